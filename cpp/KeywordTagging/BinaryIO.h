@@ -0,0 +1,148 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_BINARYIO_H
+#define OPENMPF_COMPONENTS_BINARYIO_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+// Readers and writers for the compiled tag set format. Values are stored in the byte order of
+// the machine that wrote them, which the file header records.
+
+class BinaryWriter {
+public:
+    void write_u8(uint8_t value) { write_raw(&value, sizeof value); }
+
+    void write_u32(uint32_t value) { write_raw(&value, sizeof value); }
+
+    void write_u64(uint64_t value) { write_raw(&value, sizeof value); }
+
+    // Wide strings are stored as code units, so strings that are not valid UTF-32, such as
+    // ones with unpaired \u escapes from the tagging file, are kept as they are.
+    void write_wstring(const std::wstring &value) {
+        write_u64(value.size());
+        write_raw(value.data(), value.size() * sizeof(wchar_t));
+    }
+
+    template<typename T>
+    void write_array(const std::vector<T> &values) {
+        static_assert(std::is_trivially_copyable<T>::value, "Array elements must be trivially copyable.");
+        write_u64(values.size());
+        write_raw(values.data(), values.size() * sizeof(T));
+    }
+
+    const std::string &data() const { return data_; }
+
+private:
+    std::string data_;
+
+    void write_raw(const void *data, size_t size) {
+        data_.append(static_cast<const char *>(data), size);
+    }
+};
+
+
+// Reading past the end of the data sets failed() and returns zeros and empty values, so that
+// callers only need to check for failure once they are done.
+class BinaryReader {
+public:
+    BinaryReader(const char *begin, const char *end)
+            : pos_(begin)
+            , end_(end) {
+    }
+
+    bool failed() const { return failed_; }
+
+    bool at_end() const { return pos_ == end_; }
+
+    // Number of bytes left, which bounds the number of elements that can still be read.
+    size_t remaining() const { return end_ - pos_; }
+
+    uint8_t read_u8() { return read_value<uint8_t>(); }
+
+    uint32_t read_u32() { return read_value<uint32_t>(); }
+
+    uint64_t read_u64() { return read_value<uint64_t>(); }
+
+    std::wstring read_wstring() {
+        uint64_t size = read_u64();
+        if (!check_size(size, sizeof(wchar_t))) {
+            return {};
+        }
+        std::wstring value(size, L'\0');
+        read_raw(&value[0], size * sizeof(wchar_t));
+        return value;
+    }
+
+    template<typename T>
+    std::vector<T> read_array() {
+        static_assert(std::is_trivially_copyable<T>::value, "Array elements must be trivially copyable.");
+        uint64_t size = read_u64();
+        if (!check_size(size, sizeof(T))) {
+            return {};
+        }
+        std::vector<T> values(size);
+        read_raw(values.data(), size * sizeof(T));
+        return values;
+    }
+
+private:
+    const char *pos_;
+    const char *end_;
+    bool failed_ = false;
+
+    template<typename T>
+    T read_value() {
+        T value{};
+        if (check_size(1, sizeof(T))) {
+            read_raw(&value, sizeof(T));
+        }
+        return value;
+    }
+
+    bool check_size(uint64_t count, size_t element_size) {
+        if (failed_ || count > static_cast<uint64_t>(end_ - pos_) / element_size) {
+            failed_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    void read_raw(void *data, size_t size) {
+        if (size > 0) {
+            std::memcpy(data, pos_, size);
+            pos_ += size;
+        }
+    }
+};
+
+
+#endif //OPENMPF_COMPONENTS_BINARYIO_H
@@ -25,6 +25,8 @@
  ******************************************************************************/
 
 #include "KeywordTagging.h"
+#include <atomic>
+#include <future>
 #include <string>
 #include <codecvt>
 #include <vector>
@@ -32,6 +34,7 @@
 #include <fstream>
 #include <boost/locale.hpp>
 #include <boost/regex.hpp>
+#include <boost/regex/pending/unicode_iterator.hpp>
 #include <boost/algorithm/string.hpp>
 #include "detectionComponentUtils.h"
 
@@ -39,7 +42,9 @@
 
 #include <Utils.h>
 #include <MPFDetectionException.h>
-#include "JSON.h"
+#include "MappedFile.h"
+#include "TagFileParser.h"
+#include "Utf8.h"
 
 using namespace MPF;
 using namespace COMPONENT;
@@ -48,130 +53,62 @@ using log4cxx::Logger;
 
 using namespace std;
 
-map<wstring, vector<pair<wstring, bool>>>
-KeywordTagging::parse_json(const MPFJob &job, const string &jsonfile_path) {
+KeywordTagging::TriggerMatch KeywordTagging::process_regex_match(const wstring &text, size_t start, size_t end,
+                                                                 size_t offset) {
 
-    map<wstring, vector<pair<wstring, bool>>> json_kvs_regex;
-    ifstream ifs(jsonfile_path);
-
-    if (!ifs.is_open()) {
-        throw MPFDetectionException(MPF_COULD_NOT_OPEN_DATAFILE,
-                                    "Could not open tagging file: " + jsonfile_path);
-    }
-
-    string j;
-    stringstream buffer2;
-    wstring x;
-
-    buffer2 << ifs.rdbuf();
-    j = buffer2.str();
-
-    x = boost::locale::conv::utf_to_utf<wchar_t>(j);
-
-    auto value = std::unique_ptr<JSONValue>(JSON::Parse(x.c_str()));
-
-    if (value == NULL) {
-        throw MPFDetectionException(MPF_COULD_NOT_READ_DATAFILE,
-                                    "Could not parse tagging file: " + jsonfile_path);
+    // Trim trigger words.
+    size_t trim_start = start, trim_end = end;
+    while (trim_start < end && iswspace(text.at(trim_start))) {
+        trim_start++;
     }
 
-    JSONObject root;
-    root = value->AsObject();
-
-    if (root.find(L"TAGS_BY_REGEX") != root.end() && root[L"TAGS_BY_REGEX"]->IsObject()) {
-        LOG4CXX_DEBUG(hw_logger_, "Regex tags found.");
-
-        JSONObject key_tags = root[L"TAGS_BY_REGEX"]->AsObject();
-        vector<wstring> keys = root[L"TAGS_BY_REGEX"]->ObjectKeys();
-        vector<wstring>::iterator iter = keys.begin();
-
-        while (iter != keys.end()) {
-            auto term = *iter;
-            wstring term_temp(term);
-
-            if (!key_tags[term]->IsArray()) {
-                throw MPFDetectionException(MPF_COULD_NOT_READ_DATAFILE,
-                                            "Could not parse tagging file: " + jsonfile_path +
-                                            ". In TAGS_BY_REGEX the entry for \"" +
-                                            boost::locale::conv::utf_to_utf<char>(term) +
-                                            "\" is not a valid JSON array.");
-            }
-
-            JSONArray regex_array = key_tags[term]->AsArray();
-
-            for (unsigned int i = 0; i < regex_array.size(); i++) {
-                if (regex_array[i]->IsString()) {
-                    // Legacy JSON processing.
-                    // Legacy regex patterns in the JSON tags file are listed as follows:
-                    //
-                    // "TAGS_BY_REGEX": {
-                    //    "vehicle-tag-legacy-format": [
-                    //        "auto",
-                    //        "car"
-                    //    ],
-                    //  ...
-                    // }
-
-                    wstring temp = regex_array[i]->AsString();
-                    json_kvs_regex[term].push_back(make_pair(temp, false));
-                } else if (regex_array[i]->IsObject()) {
-                    // Standard JSON format processing.
-                    // Standard JSON regex patterns are listed as follows:
-                    //
-                    // "TAGS_BY_REGEX": {
-                    //    "vehicle-tag-standard-format": [
-                    //      {"pattern": "auto"},
-                    //      {"pattern": "car"}
-                    //    ],
-                    //  ...
-                    //}
-                    JSONObject regex_entry = regex_array[i]->AsObject();
-                    if (regex_entry.find(L"pattern") != regex_entry.end()) {
-                        wstring temp = regex_entry[L"pattern"]->AsString();
-                        bool case_sens = false;
-                        if (regex_entry.find(L"caseSensitive") != regex_entry.end()) {
-                            case_sens = regex_entry[L"caseSensitive"]->AsBool();
-                        }
-                        json_kvs_regex[term].push_back(make_pair(temp, case_sens));
-                    }
-                }
-            }
-            iter++;
+    if (trim_start != end) {
+        while (start < trim_end && iswspace(text.at(trim_end - 1))) {
+            trim_end--;
         }
-
-    } else {
-        throw MPFDetectionException(MPF_COULD_NOT_READ_DATAFILE,
-                                    "Could not parse tagging file: " + jsonfile_path +
-                                    ". TAGS_BY_REGEX not found.");
     }
-    LOG4CXX_DEBUG(hw_logger_, "Successfully read JSON.");
 
-    return json_kvs_regex;
-}
+    start = trim_start;
+    end = trim_end;
 
-void KeywordTagging::process_regex_match(const boost::wsmatch &match, const wstring &full_text,
-                                         map<wstring, vector<string>> &trigger_words_offset) {
+    return {boost::locale::conv::utf_to_utf<char>(text.substr(start, end - start)),
+            start + offset, end + offset};
+}
 
-    // Find and return matching pattern.
-    int start = match.position(0Lu);
-    int end = match.position(0Lu) + match[0].length();
+KeywordTagging::TriggerMatch KeywordTagging::process_utf8_match(const string &text, size_t start, size_t end,
+                                                                size_t byte_start, size_t byte_end) {
 
-    // Trim trigger words.
-    int trim_start = start, trim_end = end;
-    while (trim_start < end && iswspace(full_text.at(trim_start))) {
+    // Trim trigger words, keeping track of both the code point and byte offsets.
+    size_t trim_start = start, trim_end = end;
+    while (trim_start < end) {
+        size_t next = byte_start;
+        if (!iswspace(utf8_decode(text, next))) {
+            break;
+        }
+        byte_start = next;
         trim_start++;
     }
 
     if (trim_start != end) {
-        while (start < trim_end && iswspace(full_text.at(trim_end - 1))) {
+        while (start < trim_end) {
+            size_t previous = utf8_previous(text, byte_end);
+            size_t next = previous;
+            if (!iswspace(utf8_decode(text, next))) {
+                break;
+            }
+            byte_end = previous;
             trim_end--;
         }
     }
 
-    start = trim_start;
-    end = trim_end;
+    return {text.substr(byte_start, byte_end - byte_start), trim_start, trim_end};
+}
+
+void KeywordTagging::add_trigger_word(TriggerMatch match,
+                                      map<string, vector<string>> &trigger_words_offset) {
 
-    wstring trigger_word = full_text.substr(start , end - start);
+    string &trigger_word = match.trigger_word;
+    size_t start = match.start, end = match.end;
     boost::replace_all(trigger_word, ";", "[;]");
 
     if (trigger_words_offset.find(trigger_word) == trigger_words_offset.end()) {
@@ -205,106 +142,246 @@ void KeywordTagging::process_regex_match(const boost::wsmatch &match, const wstr
 
 }
 
-string KeywordTagging::parse_regex_code(const boost::regex_constants::error_type &etype) {
-    switch (etype) {
-        case boost::regex_constants::error_collate:
-            return "error_collate: invalid collating element request";
-        case boost::regex_constants::error_ctype:
-            return "error_ctype: invalid character class";
-        case boost::regex_constants::error_escape:
-            return "error_escape: invalid escape character or trailing escape";
-        case boost::regex_constants::error_backref:
-            return "error_backref: invalid back reference";
-        case boost::regex_constants::error_brack:
-            return "error_brack: mismatched bracket([ or ])";
-        case boost::regex_constants::error_paren:
-            return "error_paren: mismatched parentheses(( or ))";
-        case boost::regex_constants::error_brace:
-            return "error_brace: mismatched brace({ or })";
-        case boost::regex_constants::error_badbrace:
-            return "error_badbrace: invalid range inside a { }";
-        case boost::regex_constants::error_range:
-            return "erro_range: invalid character range(e.g., [z-a])";
-        case boost::regex_constants::error_space:
-            return "error_space: insufficient memory to handle this regular expression";
-        case boost::regex_constants::error_badrepeat:
-            return "error_badrepeat: a repetition character (*, ?, +, or {) was not preceded by a valid regular expression";
-        case boost::regex_constants::error_complexity:
-            return "error_complexity: the requested match is too complex";
-        case boost::regex_constants::error_stack:
-            return "error_stack: insufficient memory to evaluate a match";
-        default:
-            return "";
+// Searches for matches that start in text[begin, end). The text may continue past end so that
+// matches that start before end are complete, and text[begin - 1] is used by assertions such
+// as \b. offset is the code point offset of text[begin] in the full text.
+void KeywordTagging::comp_regex(const wstring &text, size_t begin, size_t end, size_t offset,
+                                const TagRegex &tag_regex, RegexSearch &search, bool full_regex) {
+    size_t search_begin = begin + (search.resume > offset ? search.resume - offset : 0);
+    if (search_begin >= end) {
+        return;
     }
-}
-
-bool KeywordTagging::comp_regex(const MPFJob &job, const wstring &full_text,
-                                const wstring &regstr, map<wstring, vector<string>> &trigger_words_offset,
-                                bool full_regex,
-                                bool case_sensitive) {
-    bool found = false;
     try {
-        boost::wregex reg_matcher;
-
-        if (case_sensitive) {
-            reg_matcher = boost::wregex(regstr, boost::regex_constants::perl);
-        } else {
-            reg_matcher = boost::wregex(regstr, boost::regex_constants::perl | boost::regex::icase);
+        // Compiled once per tagging file, see TagSetCache.
+        const boost::wregex &reg_matcher = tag_regex.regex();
+
+        auto flags = search_begin > 0 ? boost::match_prev_avail : boost::match_default;
+        boost::wsregex_iterator iter(text.begin() + search_begin, text.end(), reg_matcher, flags);
+        boost::wsregex_iterator iter_end;
+
+        for (; iter != iter_end; ++iter) {
+            size_t start = (*iter)[0].first - text.begin();
+            if (start >= end) {
+                // Found again by the next chunk.
+                break;
+            }
+            size_t match_end = (*iter)[0].second - text.begin();
+            search.matches.push_back(process_regex_match(text, start, match_end, offset - begin));
+            search.resume = offset - begin + match_end;
+            // Only the first match is needed unless full regex search is enabled.
+            if (!full_regex) {
+                break;
+            }
         }
 
-        boost::wsmatch m;
-
-        if (full_regex) {
-            boost::wsregex_iterator iter(full_text.begin(), full_text.end(), reg_matcher);
-            boost::wsregex_iterator end;
+    } catch (const boost::regex_error &e) {
+        stringstream ss;
+        ss << "regex_error caught: " << parse_regex_code(e.code()) << ": " << e.what() << '\n';
+        throw MPFDetectionException(MPF_COULD_NOT_READ_DATAFILE, ss.str());
+    }
+}
 
-            for(iter; iter != end; ++iter ) {
-                process_regex_match(*iter, full_text, trigger_words_offset);
-                found = true;
+// Searches the whole UTF-8 text without converting it to a wide string, for patterns whose
+// matches can be longer than the overlap between chunks.
+void KeywordTagging::comp_regex_utf8(const string &text, const TagRegex &tag_regex,
+                                     RegexSearch &search, bool full_regex) {
+    using Utf8Iterator = boost::u8_to_u32_iterator<string::const_iterator, wchar_t>;
+    try {
+        const boost::wregex &reg_matcher = tag_regex.regex();
+
+        Utf8Iterator first(text.begin(), text.begin(), text.end());
+        Utf8Iterator last(text.end(), text.begin(), text.end());
+        boost::regex_iterator<Utf8Iterator, wchar_t> iter(first, last, reg_matcher);
+        boost::regex_iterator<Utf8Iterator, wchar_t> iter_end;
+
+        // Code point offsets are counted from the previous match.
+        size_t byte_pos = 0, pos = 0;
+        for (; iter != iter_end; ++iter) {
+            size_t byte_start = (*iter)[0].first.base() - text.begin();
+            size_t byte_end = (*iter)[0].second.base() - text.begin();
+            size_t start = pos + utf8_length(text, byte_pos, byte_start);
+            size_t end = start + utf8_length(text, byte_start, byte_end);
+            search.matches.push_back(process_utf8_match(text, start, end, byte_start, byte_end));
+            byte_pos = byte_start;
+            pos = start;
+            if (!full_regex) {
+                break;
             }
         }
-        else if (boost::regex_search(full_text, m, reg_matcher)) {
-            process_regex_match(m, full_text, trigger_words_offset);
-            found = true;
-        }
+        search.done = true;
 
     } catch (const boost::regex_error &e) {
         stringstream ss;
         ss << "regex_error caught: " << parse_regex_code(e.code()) << ": " << e.what() << '\n';
         throw MPFDetectionException(MPF_COULD_NOT_READ_DATAFILE, ss.str());
     }
+}
 
-    return found;
+namespace {
+    // Part of the text that regex patterns with a bounded match length are searched for in.
+    struct TextChunk {
+        // The code point before begin, which assertions such as \b look at.
+        size_t context_begin;
+        // Matches must start in [begin, end).
+        size_t begin;
+        size_t end;
+        // Includes enough of the following text for any match starting before end to complete.
+        size_t search_end;
+    };
+
+    TextChunk next_chunk(const string &text, size_t begin, size_t chunk_size, size_t max_length) {
+        TextChunk chunk;
+        chunk.context_begin = begin > 0 ? utf8_previous(text, begin) : 0;
+        chunk.begin = begin;
+        chunk.end = min(begin + chunk_size, text.size());
+        while (chunk.end < text.size() && is_utf8_continuation(text[chunk.end])) {
+            chunk.end++;
+        }
+        chunk.search_end = chunk.end;
+        // One extra code point so that assertions at the end of the longest match do not see
+        // the end of the chunk as the end of the text.
+        for (size_t i = 0; i <= max_length && chunk.search_end < text.size(); i++) {
+            do {
+                chunk.search_end++;
+            } while (chunk.search_end < text.size() && is_utf8_continuation(text[chunk.search_end]));
+        }
+        return chunk;
+    }
 }
 
-set<wstring> KeywordTagging::search_regex(const MPFJob &job, const wstring &full_text,
-                                          const map<wstring, vector<pair<wstring, bool>>> &json_kvs_regex,
-                                          map<wstring, map<wstring, vector<string>>> &trigger_tags_words_offset,
-                                          bool full_regex) {
+set<wstring> KeywordTagging::search_regex(const string &full_text, const TagSet &tag_set,
+                                          map<wstring, map<string, vector<string>>> &trigger_tags_words_offset,
+                                          bool full_regex, size_t chunk_size) {
     wstring found_tags_regex = L"";
     set<wstring> found_keys_regex;
 
-    if (json_kvs_regex.size() == 0) {
+    if (tag_set.tags.size() == 0) {
         return found_keys_regex;
     }
 
-    for (const auto &kv : json_kvs_regex) {
-        auto key = boost::locale::to_upper(kv.first);
-        auto values = kv.second;
-        map<wstring, vector<string>> trigger_words_offset; // map will sort items lexicographically
-        for (const pair<wstring, bool> &value : values) {
-            wstring regex_pattern = value.first;
-            bool case_sens = value.second;
+    // All literal patterns, and the literals that regexes require, are matched in a single
+    // pass. Their matches are then processed in pattern order along with the regex matches so
+    // that the trigger word offsets are listed in the same order.
+    vector<vector<LiteralMatcher::Match>> literal_matches = tag_set.literals.find_all(full_text);
+
+    // boost::wregex needs a wide string. Large texts are converted and searched one chunk at a
+    // time. The chunks overlap by the longest bounded regex match, and any match belongs to the
+    // chunk it starts in. Patterns without a bounded match length are searched for in the
+    // whole text at once.
+    bool chunked = chunk_size > 0 && full_text.size() > chunk_size;
+    vector<vector<RegexSearch>> searches;
+    // When full regex search is disabled, each tag only needs to be searched for until one of
+    // its patterns is found, or fails.
+    vector<size_t> resolved;
+    for (const auto &kv : tag_set.tags) {
+        searches.emplace_back(kv.second.size());
+        resolved.push_back(kv.second.size());
+    }
+
+    size_t chunk_begin = 0, chunk_offset = 0;
+    do {
+        TextChunk chunk = chunked
+                ? next_chunk(full_text, chunk_begin, chunk_size, tag_set.max_regex_length)
+                : TextChunk{0, 0, full_text.size(), full_text.size()};
+        if (chunked) {
+            LOG4CXX_INFO(hw_logger_, "Searching bytes " + to_string(chunk.begin) + " to "
+                                     + to_string(chunk.end) + " of " + to_string(full_text.size()) + ".")
+        }
+
+        // Only created if a regex pattern is reached.
+        wstring wide_text;
+        bool has_wide_text = false;
+        size_t wide_begin = 0, wide_end = 0;
+
+        size_t tag_index = 0;
+        for (const auto &kv : tag_set.tags) {
+            const auto &values = kv.second;
+            for (size_t i = 0; i < resolved[tag_index]; i++) {
+                const TagRegex &value = *values[i];
+                RegexSearch &search = searches[tag_index][i];
+                if (value.literal_id() < 0 && !search.done) {
+                    try {
+                        if (value.required_literal_id() >= 0
+                                && literal_matches[value.required_literal_id()].empty()) {
+                            // Can not match. Still compiled so that an invalid pattern is reported.
+                            value.regex();
+                            search.done = true;
+                        } else if (chunked && value.max_length() == 0) {
+                            comp_regex_utf8(full_text, value, search, full_regex);
+                        } else {
+                            if (!has_wide_text) {
+                                wide_text = boost::locale::conv::utf_to_utf<wchar_t>(
+                                        full_text.data() + chunk.context_begin,
+                                        full_text.data() + chunk.search_end);
+                                wide_begin = chunk.begin > chunk.context_begin ? 1 : 0;
+                                wide_end = wide_begin + utf8_length(full_text, chunk.begin, chunk.end);
+                                has_wide_text = true;
+                            }
+                            comp_regex(wide_text, wide_begin, wide_end, chunk_offset, value, search,
+                                       full_regex);
+                            search.done = !chunked;
+                        }
+                    } catch (const MPFDetectionException &) {
+                        if (full_regex) {
+                            throw;
+                        }
+                        search.error = current_exception();
+                    }
+                }
+                bool found = value.literal_id() >= 0
+                        ? !literal_matches[value.literal_id()].empty()
+                        : !search.matches.empty() || search.error;
+                if (found && !full_regex) {
+                    resolved[tag_index] = i;
+                    break;
+                }
+            }
+            tag_index++;
+        }
+
+        chunk_offset += utf8_length(full_text, chunk.begin, chunk.end);
+        chunk_begin = chunk.end;
+    } while (chunk_begin < full_text.size());
 
-            if (comp_regex(job, full_text, regex_pattern, trigger_words_offset, full_regex, case_sens)) {
+    size_t tag_index = 0;
+    for (const auto &kv : tag_set.tags) {
+        auto key = boost::locale::to_upper(kv.first);
+        const auto &values = kv.second;
+        map<string, vector<string>> trigger_words_offset; // map will sort items lexicographically
+        for (size_t i = 0; i < values.size(); i++) {
+            const TagRegex &value = *values[i];
+            RegexSearch &search = searches[tag_index][i];
+            if (search.error) {
+                rethrow_exception(search.error);
+            }
+            bool found;
+            if (value.literal_id() >= 0) {
+                const auto &matches = literal_matches[value.literal_id()];
+                found = !matches.empty();
+                for (const auto &match : matches) {
+                    add_trigger_word(process_utf8_match(full_text, match.start, match.end,
+                                                        match.byte_start, match.byte_end),
+                                     trigger_words_offset);
+                    if (!full_regex) {
+                        break;
+                    }
+                }
+            } else {
+                found = !search.matches.empty();
+                for (auto &match : search.matches) {
+                    add_trigger_word(move(match), trigger_words_offset);
+                }
+            }
+            if (found) {
                 found_keys_regex.insert(key);
                 trigger_tags_words_offset[key] = trigger_words_offset;
                 // Discontinue searching unless full regex search is enabled.
                 if (!full_regex) {
                     break;
                 }
-            }      
+            }
         }
+        tag_index++;
     }
 
     int num_found = found_keys_regex.size();
@@ -316,7 +393,7 @@ set<wstring> KeywordTagging::search_regex(const MPFJob &job, const wstring &full
     return found_keys_regex;
 }
 
-void KeywordTagging::load_tags_json(const MPFJob &job, map<wstring, vector<pair<wstring, bool>>> &json_kvs_regex) {
+shared_ptr<const TagSet> KeywordTagging::load_tags_json(const MPFJob &job) {
 
     string run_dir = GetRunDirectory();
 
@@ -340,11 +417,22 @@ void KeywordTagging::load_tags_json(const MPFJob &job, map<wstring, vector<pair<
     }
 
     LOG4CXX_DEBUG(hw_logger_, "About to read JSON from: " + jsonfile_path)
-    json_kvs_regex = parse_json(job, jsonfile_path);
-    LOG4CXX_DEBUG(hw_logger_, "Read JSON")
+    // The tagging file is only parsed again when it has changed since the last job.
+    auto tag_set = TagSetCache::get(jsonfile_path, read_tag_file);
+    LOG4CXX_DEBUG(hw_logger_, "Successfully read JSON.")
+    return tag_set;
 }
 
-bool is_only_ascii_whitespace(const wstring &str) {
+// Drops invalid UTF-8 sequences, as converting the text to a wide string does, so that offsets
+// in the UTF-8 text and the wide string agree.
+string to_valid_utf8(const string &text) {
+    if (is_valid_utf8(text)) {
+        return text;
+    }
+    return boost::locale::conv::utf_to_utf<char>(text);
+}
+
+bool is_only_ascii_whitespace(const string &str) {
     auto it = str.begin();
     do {
         if (it == str.end()) {
@@ -356,6 +444,82 @@ bool is_only_ascii_whitespace(const wstring &str) {
     return false;
 }
 
+KeywordTagging::TextTags KeywordTagging::search_text(const MPFJob &job, const string &text, const TagSet &tag_set) {
+    bool full_regex = DetectionComponentUtils::GetProperty(job.job_properties, "FULL_REGEX_SEARCH", true);
+    int chunk_size = DetectionComponentUtils::GetProperty(job.job_properties, "TEXT_CHUNK_SIZE", 16777216);
+
+    TextTags text_tags;
+    text_tags.found_tags = search_regex(text, tag_set, text_tags.trigger_tags_words_offset, full_regex,
+                                        max(chunk_size, 0));
+    return text_tags;
+}
+
+const KeywordTagging::TextTags &KeywordTagging::search_text(const MPFJob &job, const string &text,
+                                                            const TagSet &tag_set, TextTagsCache &cache) {
+    auto iter = cache.find(text);
+    if (iter == cache.end()) {
+        iter = cache.emplace(text, search_text(job, text, tag_set)).first;
+    } else {
+        LOG4CXX_DEBUG(hw_logger_, "Text was already searched.")
+    }
+    if (iter->second.error) {
+        rethrow_exception(iter->second.error);
+    }
+    return iter->second;
+}
+
+// Searches the distinct texts that have not been searched yet in parallel and adds the results
+// to the cache. Errors are stored in the cache, so that they are reported in the same order as
+// when the texts are searched one by one.
+void KeywordTagging::search_texts(const MPFJob &job, const vector<const map<string, string> *> &prop_texts,
+                                  const TagSet &tag_set, TextTagsCache &cache) {
+    vector<const string *> texts;
+    set<string> seen;
+    for (const auto *texts_by_prop : prop_texts) {
+        for (const auto &it : *texts_by_prop) {
+            const string &text = it.second;
+            if (!is_only_ascii_whitespace(text) && cache.find(text) == cache.end()
+                    && seen.insert(text).second) {
+                texts.push_back(&text);
+            }
+        }
+    }
+
+    int max_threads = DetectionComponentUtils::GetProperty(job.job_properties, "MAX_PARALLEL_TAGGING_THREADS", 4);
+    size_t num_threads = min(static_cast<size_t>(max(max_threads, 1)), texts.size());
+    if (num_threads <= 1) {
+        // Searched as they are reached.
+        return;
+    }
+    LOG4CXX_DEBUG(hw_logger_, "Searching " + to_string(texts.size()) + " distinct texts using "
+                              + to_string(num_threads) + " threads.")
+
+    vector<TextTags> results(texts.size());
+    atomic<size_t> next_text(0);
+    auto search_next_texts = [&] {
+        for (size_t i = next_text++; i < texts.size(); i = next_text++) {
+            try {
+                results[i] = search_text(job, *texts[i], tag_set);
+            } catch (...) {
+                results[i].error = current_exception();
+            }
+        }
+    };
+
+    vector<future<void>> threads;
+    for (size_t i = 1; i < num_threads; i++) {
+        threads.push_back(async(launch::async, search_next_texts));
+    }
+    search_next_texts();
+    for (auto &thread : threads) {
+        thread.get();
+    }
+
+    for (size_t i = 0; i < texts.size(); i++) {
+        cache.emplace(*texts[i], move(results[i]));
+    }
+}
+
 bool KeywordTagging::Init() {
     boost::locale::generator gen;
     locale loc = gen("");
@@ -375,30 +539,34 @@ vector<MPFGenericTrack> KeywordTagging::GetDetections(const MPFGenericJob &job)
 
     MPFGenericTrack track;
     bool has_prop = true;
-    map<string, wstring> prop_texts;
-    wstring text;
+    map<string, string> prop_texts;
 
     if (job.has_feed_forward_track) {
         track = job.feed_forward_track;
         has_prop = get_text_to_process(job, track.detection_properties, prop_texts);
     } else {
         LOG4CXX_INFO(hw_logger_, "Generic job is not feed forward. Performing tagging on text file.");
-        wifstream file {job.data_uri};
+        MappedFile file(job.data_uri);
         if (!file.is_open()) {
             throw MPFDetectionException(MPF_COULD_NOT_OPEN_MEDIA, "Cannot open: " + job.data_uri);
         }
-        wstring file_contents((istreambuf_iterator<wchar_t>(file)), (istreambuf_iterator<wchar_t>()));
-        text = move(file_contents);
-        track.detection_properties["TEXT"] = boost::locale::conv::utf_to_utf<char>(text);
-
-        prop_texts["TEXT"] = text;
-        file.close();
+        // The file is copied into the string exactly once. It is moved into the TEXT property
+        // after tagging, rather than being copied there as well.
+        const char *file_end = file.data() + file.size();
+        if (is_valid_utf8(file.data(), file_end)) {
+            prop_texts["TEXT"].assign(file.data(), file_end);
+        } else {
+            prop_texts["TEXT"] = boost::locale::conv::utf_to_utf<char>(file.data(), file_end);
+        }
     }
 
     if (has_prop) {
-        map<wstring, vector<pair<wstring, bool>>> json_kvs_regex;
-        load_tags_json(job, json_kvs_regex);
-        process_text_tagging(track.detection_properties, job, prop_texts, json_kvs_regex);
+        auto tag_set = load_tags_json(job);
+        process_text_tagging(track.detection_properties, job, prop_texts, *tag_set);
+    }
+
+    if (!job.has_feed_forward_track) {
+        track.detection_properties["TEXT"] = move(prop_texts["TEXT"]);
     }
 
     return {track};
@@ -413,12 +581,11 @@ vector<MPFAudioTrack> KeywordTagging::GetDetections(const MPFAudioJob &job) {
     }
 
     MPFAudioTrack track = job.feed_forward_track;
-    map<string, wstring> prop_texts;
+    map<string, string> prop_texts;
 
     if (get_text_to_process(job, track.detection_properties, prop_texts)) {
-        map<wstring, vector<pair<wstring, bool>>> json_kvs_regex;
-        load_tags_json(job, json_kvs_regex);
-        process_text_tagging(track.detection_properties, job, prop_texts, json_kvs_regex);
+        auto tag_set = load_tags_json(job);
+        process_text_tagging(track.detection_properties, job, prop_texts, *tag_set);
     }
 
     return {track};
@@ -433,12 +600,11 @@ vector<MPFImageLocation> KeywordTagging::GetDetections(const MPFImageJob &job) {
     }
 
     MPFImageLocation location = job.feed_forward_location;
-    map<string, wstring> prop_texts;
+    map<string, string> prop_texts;
 
     if (get_text_to_process(job, location.detection_properties, prop_texts)) {
-        map<wstring, vector<pair<wstring, bool>>> json_kvs_regex;
-        load_tags_json(job, json_kvs_regex);
-        process_text_tagging(location.detection_properties, job, prop_texts, json_kvs_regex);
+        auto tag_set = load_tags_json(job);
+        process_text_tagging(location.detection_properties, job, prop_texts, *tag_set);
     }
 
     return {location};
@@ -452,23 +618,42 @@ vector<MPFVideoTrack> KeywordTagging::GetDetections(const MPFVideoJob &job) {
         throw MPFDetectionException(MPF_UNSUPPORTED_DATA_TYPE, "Can only process video files in feed forward jobs.");
     }
 
-    map<wstring, vector<pair<wstring, bool>>> json_kvs_regex;
-    load_tags_json(job, json_kvs_regex);
+    auto tag_set = load_tags_json(job);
 
     MPFVideoTrack track = job.feed_forward_track;
-    map<string, wstring> prop_texts;
+    map<string, string> prop_texts;
 
-    // process track-level properties
-    if (get_text_to_process(job, track.detection_properties, prop_texts)) {
-        process_text_tagging(track.detection_properties, job, prop_texts, json_kvs_regex);
-    }
+    // Find the text to process for the track and each detection first, so that the distinct
+    // texts can be searched in parallel. OCR and speech output is often the same for many
+    // consecutive frames.
+    bool track_has_prop = get_text_to_process(job, track.detection_properties, prop_texts);
+    map<string, string> track_prop_texts = prop_texts;
 
-    // process detection-level properties
+    vector<pair<Properties *, map<string, string>>> detection_prop_texts;
     for (auto &pair : track.frame_locations) {
         if (get_text_to_process(job, pair.second.detection_properties, prop_texts)) {
-            process_text_tagging(pair.second.detection_properties, job, prop_texts, json_kvs_regex);
+            detection_prop_texts.emplace_back(&pair.second.detection_properties, prop_texts);
         }
+    }
 
+    vector<const map<string, string> *> all_prop_texts;
+    if (track_has_prop) {
+        all_prop_texts.push_back(&track_prop_texts);
+    }
+    for (const auto &pair : detection_prop_texts) {
+        all_prop_texts.push_back(&pair.second);
+    }
+    TextTagsCache cache;
+    search_texts(job, all_prop_texts, *tag_set, cache);
+
+    // process track-level properties
+    if (track_has_prop) {
+        process_text_tagging(track.detection_properties, job, track_prop_texts, *tag_set, &cache);
+    }
+
+    // process detection-level properties
+    for (auto &pair : detection_prop_texts) {
+        process_text_tagging(*pair.first, job, pair.second, *tag_set, &cache);
     }
 
     return {track};
@@ -479,21 +664,19 @@ bool KeywordTagging::Supports(MPFDetectionDataType data_type) {
         || data_type == MPFDetectionDataType::AUDIO || data_type == MPFDetectionDataType::VIDEO;
 }
 
-bool KeywordTagging::get_text_to_process(const MPFJob &job, const Properties &detection_properties, map<string, wstring> &prop_texts) {
+bool KeywordTagging::get_text_to_process(const MPFJob &job, const Properties &detection_properties, map<string, string> &prop_texts) {
     string props_to_process = DetectionComponentUtils::GetProperty<string>(job.job_properties,
                                                                            "FEED_FORWARD_PROP_TO_PROCESS",
                                                                            "TEXT,TRANSCRIPT,TRANSLATION");
     vector<string> split_props_to_process;
     boost::split(split_props_to_process, props_to_process, boost::is_any_of(","));
-    wstring text;
 
     bool has_prop = false;
     for (string prop_to_process : split_props_to_process) {
         boost::trim(prop_to_process);
         if (detection_properties.find(prop_to_process) != detection_properties.end()) {
             LOG4CXX_INFO(hw_logger_, "Performing tagging on " + prop_to_process + " property.")
-            text = boost::locale::conv::utf_to_utf<wchar_t>(detection_properties.at(prop_to_process));
-            prop_texts[prop_to_process] = text;
+            prop_texts[prop_to_process] = to_valid_utf8(detection_properties.at(prop_to_process));
             has_prop = true;
         }
     }
@@ -506,22 +689,17 @@ bool KeywordTagging::get_text_to_process(const MPFJob &job, const Properties &de
 
 }
 
-void KeywordTagging::process_text_tagging(Properties &detection_properties, const MPFJob &job, const map<string, wstring>& prop_texts,
-                                          const map<wstring, vector<pair<wstring, bool>>> &json_kvs_regex) {
-    string prop;
-    wstring prop_text;
-
+void KeywordTagging::process_text_tagging(Properties &detection_properties, const MPFJob &job, const map<string, string>& prop_texts,
+                                          const TagSet &tag_set, TextTagsCache *cache) {
     bool has_text = false;
     set<wstring> all_found_tags; // set will sort items lexicographically
 
     for (auto const& it : prop_texts) {
-        prop = it.first;
-        prop_text = it.second;
+        const string &prop = it.first;
+        const string &prop_text = it.second;
 
-        LOG4CXX_DEBUG(hw_logger_, "Processing tags on " +
-                                  boost::locale::conv::utf_to_utf<char>(prop))
-        LOG4CXX_DEBUG(hw_logger_, "Text is: " +
-                                  boost::locale::conv::utf_to_utf<char>(prop_text))
+        LOG4CXX_DEBUG(hw_logger_, "Processing tags on " + prop)
+        LOG4CXX_DEBUG(hw_logger_, "Text is: " + prop_text)
 
         if (is_only_ascii_whitespace(prop_text)) {
             LOG4CXX_WARN(hw_logger_, "No text to process for " +
@@ -530,23 +708,25 @@ void KeywordTagging::process_text_tagging(Properties &detection_properties, cons
         }
         has_text = true;
 
-        bool full_regex = DetectionComponentUtils::GetProperty(job.job_properties, "FULL_REGEX_SEARCH", true);
-
-        map<wstring, map<wstring, vector<string>>> trigger_tags_words_offset;
-        set<wstring> found_tags_regex = search_regex(job, prop_text, json_kvs_regex, trigger_tags_words_offset, full_regex);
+        TextTags uncached;
+        const TextTags &text_tags = cache != nullptr
+                ? search_text(job, prop_text, tag_set, *cache)
+                : (uncached = search_text(job, prop_text, tag_set));
+        const set<wstring> &found_tags_regex = text_tags.found_tags;
+        const auto &trigger_tags_words_offset = text_tags.trigger_tags_words_offset;
         all_found_tags.insert(found_tags_regex.begin(), found_tags_regex.end());
 
         wstring tag_string = boost::algorithm::join(found_tags_regex, L"; ");
 
-        map<wstring, map<wstring, vector<string>>>::iterator trigger_tags_words_offset_iterator = trigger_tags_words_offset.begin();
+        auto trigger_tags_words_offset_iterator = trigger_tags_words_offset.begin();
         while(trigger_tags_words_offset_iterator != trigger_tags_words_offset.end())
         {
             vector<string> offsets_list;
-            vector<wstring> triggers_list;
+            vector<string> triggers_list;
 
             wstring tag = trigger_tags_words_offset_iterator->first;
             boost::to_upper(tag);
-            map<wstring, vector<string>> trigger_words_offset = trigger_tags_words_offset_iterator->second;
+            const map<string, vector<string>> &trigger_words_offset = trigger_tags_words_offset_iterator->second;
 
             for (auto const& word_offset : trigger_words_offset) {
                 triggers_list.push_back(word_offset.first);
@@ -554,9 +734,9 @@ void KeywordTagging::process_text_tagging(Properties &detection_properties, cons
             }
             
             string tag_offset = boost::algorithm::join(offsets_list, "; ");
-            wstring tag_trigger = boost::algorithm::join(triggers_list, L"; ");
+            string tag_trigger = boost::algorithm::join(triggers_list, "; ");
 
-            detection_properties[boost::locale::conv::utf_to_utf<char>(prop) + " " + boost::locale::conv::utf_to_utf<char>(tag) + " TRIGGER WORDS"] = boost::locale::conv::utf_to_utf<char>(tag_trigger);
+            detection_properties[boost::locale::conv::utf_to_utf<char>(prop) + " " + boost::locale::conv::utf_to_utf<char>(tag) + " TRIGGER WORDS"] = tag_trigger;
             detection_properties[boost::locale::conv::utf_to_utf<char>(prop) + " " + boost::locale::conv::utf_to_utf<char>(tag) + " TRIGGER WORDS OFFSET"] = tag_offset;
             trigger_tags_words_offset_iterator++;
         }   
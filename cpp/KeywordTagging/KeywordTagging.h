@@ -27,12 +27,16 @@
 #ifndef OPENMPF_COMPONENTS_KEYWORDTAGGING_H
 #define OPENMPF_COMPONENTS_KEYWORDTAGGING_H
 
+#include <exception>
+#include <memory>
 #include <set>
 #include "adapters/MPFGenericDetectionComponentAdapter.h"
 #include <MPFDetectionComponent.h>
 #include <boost/regex.hpp>
 #include <log4cxx/logger.h>
 
+#include "TagCache.h"
+
 using namespace MPF;
 using namespace COMPONENT;
 
@@ -55,30 +59,67 @@ public:
 private:
     log4cxx::LoggerPtr hw_logger_;
 
-    std::set<std::wstring> search_regex(const MPFJob &job, const std::wstring &full_text,
-                                        const std::map<std::wstring, std::vector<std::pair<std::wstring, bool>>> &json_kvs_regex,
-                                        std::map<std::wstring, std::map<std::wstring, std::vector<std::string>>> &trigger_tags_words_offset,
-                                        bool full_regex);
+    // Trimmed trigger word and its code point offsets in the text.
+    struct TriggerMatch {
+        std::string trigger_word;
+        size_t start;
+        size_t end;
+    };
+
+    // Matches of one regex pattern, which may be found over several chunks of the text.
+    struct RegexSearch {
+        std::vector<TriggerMatch> matches;
+        // Code point offset where the next match may start.
+        size_t resume = 0;
+        // Set once the pattern has been searched for in the whole text.
+        bool done = false;
+        // Error to report if the pattern is reached when full regex search is disabled.
+        std::exception_ptr error;
+    };
+
+    // Tags found in one text, see search_regex.
+    struct TextTags {
+        std::set<std::wstring> found_tags;
+        std::map<std::wstring, std::map<std::string, std::vector<std::string>>> trigger_tags_words_offset;
+        // Set instead when the search failed.
+        std::exception_ptr error;
+    };
+
+    // Search results by text, so that text repeated within a job is only searched once.
+    using TextTagsCache = std::map<std::string, TextTags>;
+
+    TextTags search_text(const MPFJob &job, const std::string &text, const TagSet &tag_set);
+
+    const TextTags &search_text(const MPFJob &job, const std::string &text, const TagSet &tag_set,
+                                TextTagsCache &cache);
+
+    void search_texts(const MPFJob &job, const std::vector<const std::map<std::string, std::string> *> &prop_texts,
+                      const TagSet &tag_set, TextTagsCache &cache);
+
+    std::set<std::wstring> search_regex(const std::string &full_text, const TagSet &tag_set,
+                                        std::map<std::wstring, std::map<std::string, std::vector<std::string>>> &trigger_tags_words_offset,
+                                        bool full_regex, size_t chunk_size);
+
+    TriggerMatch process_regex_match(const std::wstring &text, size_t start, size_t end, size_t offset);
 
-    void process_regex_match(const boost::wsmatch &match, const std::wstring &full_text,
-                             std::map<std::wstring, std::vector<std::string>> &trigger_words_offset);
+    TriggerMatch process_utf8_match(const std::string &text, size_t start, size_t end,
+                                    size_t byte_start, size_t byte_end);
 
-    void process_text_tagging(Properties &detection_properties, const MPFJob &job, const std::map<std::string, std::wstring>& prop_texts,
-                              const std::map<std::wstring, std::vector<std::pair<std::wstring, bool>>> &json_kvs_regex);
+    void add_trigger_word(TriggerMatch match,
+                          std::map<std::string, std::vector<std::string>> &trigger_words_offset);
 
-    void load_tags_json(const MPFJob &job,
-                        std::map<std::wstring, std::vector<std::pair<std::wstring, bool>>> &json_kvs_regex);
+    void process_text_tagging(Properties &detection_properties, const MPFJob &job, const std::map<std::string, std::string>& prop_texts,
+                              const TagSet &tag_set, TextTagsCache *cache = nullptr);
 
-    std::map<std::wstring, std::vector<std::pair<std::wstring, bool>>> parse_json(const MPFJob &job,
-                                                                                  const std::string &jsonfile_path);
+    std::shared_ptr<const TagSet> load_tags_json(const MPFJob &job);
 
-    bool comp_regex(const MPFJob &job, const std::wstring &full_text, const std::wstring &regstr,
-                    std::map<std::wstring, std::vector<std::string>> &trigger_words_offset,
-                    bool full_regex, bool case_sensitive);
+    void comp_regex(const std::wstring &text, size_t begin, size_t end, size_t offset,
+                    const TagRegex &tag_regex, RegexSearch &search, bool full_regex);
 
-    std::string parse_regex_code(const boost::regex_constants::error_type &etype);
+    void comp_regex_utf8(const std::string &text, const TagRegex &tag_regex, RegexSearch &search,
+                         bool full_regex);
 
-    bool get_text_to_process(const MPFJob &job, const Properties &detection_properties, std::map<std::string, std::wstring>& prop_texts);
+    bool get_text_to_process(const MPFJob &job, const Properties &detection_properties, std::map<std::string, std::string>& prop_texts);
 };
 
 #endif //OPENMPF_COMPONENTS_KEYWORDTAGGING_H
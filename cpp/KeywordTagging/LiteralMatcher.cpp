@@ -0,0 +1,364 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+#include "LiteralMatcher.h"
+
+#include <algorithm>
+#include <queue>
+
+#include <boost/locale/encoding_utf.hpp>
+
+#include "BinaryIO.h"
+#include "Utf8.h"
+
+using namespace std;
+
+
+LiteralMatcher::LiteralMatcher()
+        : ctype_(&use_facet<ctype<wchar_t>>(locale_)) {
+    for (int c = 0; c < 128; c++) {
+        ascii_lower_[c] = ctype_->tolower(static_cast<wchar_t>(c));
+    }
+}
+
+
+bool LiteralMatcher::parse_literal(const wstring &pattern, Literal &literal) {
+    // Characters with a special meaning in the boost perl syntax, and the escaped characters
+    // that are known to stand for themselves.
+    static const wstring special = L".^$|?*+()[]{}\\";
+    static const wstring escapable = L".^$|?*+()[]{}\\/-#&~!\"%,:;=@ ";
+
+    size_t i = 0;
+    while (i < pattern.size()) {
+        size_t boundary_length = 0;
+        if (pattern.compare(i, 4, L"(\\b)") == 0) {
+            boundary_length = 4;
+        } else if (pattern.compare(i, 2, L"\\b") == 0) {
+            boundary_length = 2;
+        }
+
+        if (boundary_length > 0) {
+            if (i == 0) {
+                literal.start_boundary = true;
+            } else if (i + boundary_length == pattern.size()) {
+                literal.end_boundary = true;
+            } else {
+                return false;
+            }
+            i += boundary_length;
+        } else if (pattern[i] == L'\\') {
+            if (i + 1 == pattern.size() || escapable.find(pattern[i + 1]) == wstring::npos) {
+                return false;
+            }
+            literal.text += pattern[i + 1];
+            i += 2;
+        } else if (special.find(pattern[i]) != wstring::npos) {
+            return false;
+        } else {
+            literal.text += pattern[i];
+            i++;
+        }
+    }
+    return !literal.text.empty();
+}
+
+
+int LiteralMatcher::add(const wstring &pattern, bool case_sensitive) {
+    Literal literal{ L"", "", case_sensitive, false, false };
+    if (!parse_literal(pattern, literal)) {
+        return -1;
+    }
+
+    auto key = make_tuple(literal.text, literal.case_sensitive, literal.start_boundary,
+                          literal.end_boundary);
+    auto iter = literal_ids_.find(key);
+    if (iter != literal_ids_.end()) {
+        return iter->second;
+    }
+
+    literal.utf8_text = boost::locale::conv::utf_to_utf<char>(literal.text);
+    int id = static_cast<int>(literals_.size());
+    literals_.push_back(move(literal));
+    literal_ids_.emplace(move(key), id);
+    return id;
+}
+
+
+void LiteralMatcher::build() {
+    // Build the trie of case folded literals, then flatten it.
+    vector<map<wchar_t, uint32_t>> trie(1);
+    vector<vector<uint32_t>> state_outputs(1);
+    offset_ring_size_ = 1;
+    for (uint32_t id = 0; id < literals_.size(); id++) {
+        while (offset_ring_size_ <= literals_[id].text.size()) {
+            offset_ring_size_ *= 2;
+        }
+        uint32_t state = 0;
+        for (wchar_t c : literals_[id].text) {
+            wchar_t folded = fold(c);
+            auto iter = trie[state].find(folded);
+            if (iter == trie[state].end()) {
+                auto next = static_cast<uint32_t>(trie.size());
+                trie.emplace_back();
+                state_outputs.emplace_back();
+                trie[state].emplace(folded, next);
+                state = next;
+            } else {
+                state = iter->second;
+            }
+        }
+        state_outputs[state].push_back(id);
+    }
+
+    size_t num_states = trie.size();
+    edge_begin_.assign(1, 0);
+    edge_chars_.clear();
+    edge_targets_.clear();
+    output_begin_.assign(1, 0);
+    outputs_.clear();
+    for (size_t state = 0; state < num_states; state++) {
+        for (const auto &edge : trie[state]) {
+            edge_chars_.push_back(edge.first);
+            edge_targets_.push_back(edge.second);
+        }
+        edge_begin_.push_back(static_cast<uint32_t>(edge_chars_.size()));
+        outputs_.insert(outputs_.end(), state_outputs[state].begin(), state_outputs[state].end());
+        output_begin_.push_back(static_cast<uint32_t>(outputs_.size()));
+    }
+
+    // Breadth-first so that a state's failure link is always shallower than the state.
+    failure_links_.assign(num_states, 0);
+    output_links_.assign(num_states, 0);
+    queue<uint32_t> states;
+    for (const auto &edge : trie[0]) {
+        states.push(edge.second);
+    }
+    while (!states.empty()) {
+        uint32_t state = states.front();
+        states.pop();
+        for (const auto &edge : trie[state]) {
+            uint32_t child = edge.second;
+            uint32_t failure = failure_links_[state];
+            uint32_t target = 0;
+            while (!find_edge(failure, edge.first, target) && failure != 0) {
+                failure = failure_links_[failure];
+            }
+            failure_links_[child] = target;
+            output_links_[child] = state_outputs[target].empty() ? output_links_[target] : target;
+            states.push(child);
+        }
+    }
+}
+
+
+void LiteralMatcher::save(BinaryWriter &out) const {
+    out.write_u64(literals_.size());
+    for (const auto &literal : literals_) {
+        out.write_wstring(literal.text);
+        out.write_u8(static_cast<uint8_t>(literal.case_sensitive | literal.start_boundary << 1
+                                          | literal.end_boundary << 2));
+    }
+    out.write_u64(offset_ring_size_);
+    out.write_array(edge_begin_);
+    out.write_array(edge_chars_);
+    out.write_array(edge_targets_);
+    out.write_array(failure_links_);
+    out.write_array(output_links_);
+    out.write_array(output_begin_);
+    out.write_array(outputs_);
+}
+
+
+bool LiteralMatcher::load(BinaryReader &in) {
+    literals_.clear();
+    literal_ids_.clear();
+    uint64_t num_literals = in.read_u64();
+    literals_.reserve(min<uint64_t>(num_literals, in.remaining()));
+    size_t max_literal_length = 0;
+    for (uint64_t id = 0; id < num_literals && !in.failed(); id++) {
+        Literal literal;
+        literal.text = in.read_wstring();
+        uint8_t flags = in.read_u8();
+        literal.case_sensitive = flags & 1;
+        literal.start_boundary = flags & 2;
+        literal.end_boundary = flags & 4;
+        literal.utf8_text = boost::locale::conv::utf_to_utf<char>(literal.text);
+        max_literal_length = max(max_literal_length, literal.text.size());
+        if (literal.text.empty()) {
+            return false;
+        }
+        literals_.push_back(move(literal));
+    }
+    offset_ring_size_ = in.read_u64();
+    edge_begin_ = in.read_array<uint32_t>();
+    edge_chars_ = in.read_array<wchar_t>();
+    edge_targets_ = in.read_array<uint32_t>();
+    failure_links_ = in.read_array<uint32_t>();
+    output_links_ = in.read_array<uint32_t>();
+    output_begin_ = in.read_array<uint32_t>();
+    outputs_ = in.read_array<uint32_t>();
+    if (in.failed()) {
+        return false;
+    }
+
+    // Check the automaton's structure, so that a damaged file can not make find_all read out
+    // of bounds or follow failure links forever.
+    size_t num_states = failure_links_.size();
+    if (num_states == 0 || edge_begin_.size() != num_states + 1 || edge_begin_[0] != 0
+            || edge_begin_[num_states] != edge_chars_.size() || edge_targets_.size() != edge_chars_.size()
+            || output_links_.size() != num_states || output_begin_.size() != num_states + 1
+            || output_begin_[0] != 0 || output_begin_[num_states] != outputs_.size()
+            || (offset_ring_size_ & (offset_ring_size_ - 1)) != 0 || offset_ring_size_ <= max_literal_length) {
+        return false;
+    }
+    if (!is_sorted(edge_begin_.begin(), edge_begin_.end())
+            || !is_sorted(output_begin_.begin(), output_begin_.end())) {
+        return false;
+    }
+    // Trie states are numbered after their parents, so depths can be computed in order.
+    vector<uint32_t> depths(num_states, 0);
+    for (size_t state = 0; state < num_states; state++) {
+        for (uint32_t k = edge_begin_[state]; k < edge_begin_[state + 1]; k++) {
+            if (edge_targets_[k] <= state || edge_targets_[k] >= num_states
+                    || (k > edge_begin_[state] && edge_chars_[k] <= edge_chars_[k - 1])) {
+                return false;
+            }
+            depths[edge_targets_[k]] = depths[state] + 1;
+        }
+    }
+    if (failure_links_[0] != 0 || output_links_[0] != 0) {
+        return false;
+    }
+    for (size_t state = 1; state < num_states; state++) {
+        if (failure_links_[state] >= num_states || depths[failure_links_[state]] >= depths[state]
+                || output_links_[state] >= num_states || depths[output_links_[state]] >= depths[state]) {
+            return false;
+        }
+    }
+    if (any_of(outputs_.begin(), outputs_.end(), [&](uint32_t id) { return id >= literals_.size(); })) {
+        return false;
+    }
+
+    // Case folding depends on the locale, so check that each literal still leads to a state
+    // that outputs it.
+    for (uint32_t id = 0; id < literals_.size(); id++) {
+        uint32_t state = 0;
+        bool found = true;
+        for (wchar_t c : literals_[id].text) {
+            if (!find_edge(state, fold(c), state)) {
+                found = false;
+                break;
+            }
+        }
+        if (!found || find(outputs_.begin() + output_begin_[state], outputs_.begin() + output_begin_[state + 1],
+                           id) == outputs_.begin() + output_begin_[state + 1]) {
+            build();
+            break;
+        }
+    }
+    return true;
+}
+
+
+bool LiteralMatcher::find_edge(uint32_t state, wchar_t c, uint32_t &target) const {
+    auto begin = edge_chars_.begin() + edge_begin_[state];
+    auto end = edge_chars_.begin() + edge_begin_[state + 1];
+    auto iter = lower_bound(begin, end, c);
+    if (iter == end || *iter != c) {
+        return false;
+    }
+    target = edge_targets_[iter - edge_chars_.begin()];
+    return true;
+}
+
+
+uint32_t LiteralMatcher::next_state(uint32_t state, wchar_t c) const {
+    uint32_t target;
+    while (!find_edge(state, c, target)) {
+        if (state == 0) {
+            return 0;
+        }
+        state = failure_links_[state];
+    }
+    return target;
+}
+
+
+bool LiteralMatcher::is_boundary(const string &text, size_t byte_pos) const {
+    bool word_before = false;
+    if (byte_pos > 0) {
+        size_t previous = utf8_previous(text, byte_pos);
+        word_before = is_word(utf8_decode(text, previous));
+    }
+    size_t next = byte_pos;
+    bool word_after = byte_pos < text.size() && is_word(utf8_decode(text, next));
+    return word_before != word_after;
+}
+
+
+vector<vector<LiteralMatcher::Match>> LiteralMatcher::find_all(const string &text) const {
+    vector<vector<Match>> matches(literals_.size());
+    if (literals_.empty()) {
+        return matches;
+    }
+
+    // Byte offsets of the most recent code points, indexed by code point offset modulo the
+    // ring size.
+    vector<size_t> byte_offsets(offset_ring_size_);
+    size_t ring_mask = offset_ring_size_ - 1;
+
+    // A match that overlaps the previous match of the same literal is skipped, as it would
+    // be by boost::wsregex_iterator.
+    vector<size_t> last_end(literals_.size(), 0);
+    uint32_t state = 0;
+    size_t byte_pos = 0;
+    for (size_t pos = 0; byte_pos < text.size(); pos++) {
+        byte_offsets[pos & ring_mask] = byte_pos;
+        state = next_state(state, fold(utf8_decode(text, byte_pos)));
+        uint32_t output_state = output_begin_[state] != output_begin_[state + 1]
+                                ? state : output_links_[state];
+        for (; output_state != 0; output_state = output_links_[output_state]) {
+            for (uint32_t k = output_begin_[output_state]; k < output_begin_[output_state + 1]; k++) {
+                uint32_t id = outputs_[k];
+                const Literal &literal = literals_[id];
+                size_t end = pos + 1;
+                size_t start = end - literal.text.size();
+                if (start < last_end[id]) {
+                    continue;
+                }
+                size_t byte_start = byte_offsets[start & ring_mask];
+                if ((literal.case_sensitive
+                        && text.compare(byte_start, byte_pos - byte_start, literal.utf8_text) != 0)
+                        || (literal.start_boundary && !is_boundary(text, byte_start))
+                        || (literal.end_boundary && !is_boundary(text, byte_pos))) {
+                    continue;
+                }
+                matches[id].push_back({ start, end, byte_start, byte_pos });
+                last_end[id] = end;
+            }
+        }
+    }
+    return matches;
+}
@@ -0,0 +1,137 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+#ifndef OPENMPF_COMPONENTS_LITERALMATCHER_H
+#define OPENMPF_COMPONENTS_LITERALMATCHER_H
+
+#include <cstdint>
+#include <locale>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+class BinaryReader;
+class BinaryWriter;
+
+// Matches all of the tagging file's patterns that are plain literals in a single pass over
+// the text using an Aho-Corasick automaton. A literal is a pattern made only of ordinary and
+// escaped punctuation characters, optionally starting and/or ending with a "\b" or "(\b)"
+// word boundary, e.g. "(\b)bus(\b)" or "U\.S\.". All other patterns are left to boost::wregex.
+//
+// Matches are the same as boost::wregex would find for the pattern in the text converted to a
+// wide string: case-insensitive comparison uses the ctype facet of the global locale, word
+// characters are alphanumeric characters and '_', and for each literal only the leftmost
+// non-overlapping matches are reported. The text itself is scanned as UTF-8.
+class LiteralMatcher {
+public:
+    struct Match {
+        // Code point offsets, as they would be in the wide string.
+        size_t start;
+        size_t end;
+        // Byte offsets in the UTF-8 text.
+        size_t byte_start;
+        size_t byte_end;
+    };
+
+    LiteralMatcher();
+
+    // Returns the literal's id, or -1 if the pattern is not a plain literal. Patterns that
+    // are the same literal share an id.
+    int add(const std::wstring &pattern, bool case_sensitive);
+
+    // Builds the automaton. Must be called after the last literal is added.
+    void build();
+
+    bool empty() const { return literals_.empty(); }
+
+    size_t size() const { return literals_.size(); }
+
+    // Returns the matches of each literal, indexed by literal id. The text must be valid
+    // UTF-8.
+    std::vector<std::vector<Match>> find_all(const std::string &text) const;
+
+    // Writes the literals and the built automaton, for a compiled tag set.
+    void save(BinaryWriter &out) const;
+
+    // Replaces the literals and the automaton with ones written by save. No more literals can
+    // be added afterwards. The automaton is rebuilt if the global locale folds the literals
+    // differently than when it was saved. Returns false if the data is not consistent.
+    bool load(BinaryReader &in);
+
+private:
+    struct Literal {
+        std::wstring text;
+        std::string utf8_text;
+        bool case_sensitive;
+        bool start_boundary;
+        bool end_boundary;
+    };
+
+    std::locale locale_;
+    const std::ctype<wchar_t> *ctype_;
+    wchar_t ascii_lower_[128];
+
+    std::vector<Literal> literals_;
+    std::map<std::tuple<std::wstring, bool, bool, bool>, int> literal_ids_;
+
+    // The automaton's states are stored in flat arrays. The transitions out of state s are
+    // edge_chars_[edge_begin_[s]] to edge_chars_[edge_begin_[s + 1] - 1], sorted by
+    // character, and lead to the corresponding states in edge_targets_. The literals that end
+    // at state s are outputs_[output_begin_[s]] to outputs_[output_begin_[s + 1] - 1]. State 0
+    // is the root, which is also used as the "none" value for output_links_.
+    std::vector<uint32_t> edge_begin_;
+    std::vector<wchar_t> edge_chars_;
+    std::vector<uint32_t> edge_targets_;
+    std::vector<uint32_t> failure_links_;
+    // Next state on the failure path that has outputs.
+    std::vector<uint32_t> output_links_;
+    std::vector<uint32_t> output_begin_;
+    std::vector<uint32_t> outputs_;
+
+    // Size of the ring buffer of recent code point offsets used to find where a match starts.
+    // A power of two greater than the length of the longest literal.
+    size_t offset_ring_size_ = 1;
+
+    static bool parse_literal(const std::wstring &pattern, Literal &literal);
+
+    wchar_t fold(wchar_t c) const {
+        return c >= 0 && c < 128 ? ascii_lower_[c] : ctype_->tolower(c);
+    }
+
+    bool is_word(wchar_t c) const {
+        return c == L'_' || ctype_->is(std::ctype_base::alnum, c);
+    }
+
+    bool is_boundary(const std::string &text, size_t byte_pos) const;
+
+    uint32_t next_state(uint32_t state, wchar_t c) const;
+
+    bool find_edge(uint32_t state, wchar_t c, uint32_t &target) const;
+};
+
+
+#endif //OPENMPF_COMPONENTS_LITERALMATCHER_H
@@ -0,0 +1,59 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_MAPPEDFILE_H
+#define OPENMPF_COMPONENTS_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+
+// Read-only memory mapping of a whole file. The contents are paged in by the operating system
+// as they are read, rather than being copied into a buffer up front.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool is_open() const { return is_open_; }
+
+    const char *data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+private:
+    bool is_open_ = false;
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+
+#endif //OPENMPF_COMPONENTS_MAPPEDFILE_H
@@ -0,0 +1,344 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "RegexLength.h"
+
+#include <cwctype>
+
+using namespace std;
+
+
+namespace {
+    // Matches longer than this are treated as unbounded, since the overlap between chunks
+    // would be larger than the chunks themselves.
+    const size_t MAX_BOUNDED_LENGTH = 1 << 16;
+
+    struct Length {
+        size_t min;
+        size_t max;
+    };
+
+    // Recursive descent over the pattern that computes the shortest and longest match of each
+    // element. Any construct that is not understood makes the whole pattern unbounded.
+    class LengthParser {
+    public:
+        explicit LengthParser(const wstring &pattern) : pattern_(pattern) {
+        }
+
+        bool parse(Length &length) {
+            return alternation(length) && pos_ == pattern_.size();
+        }
+
+    private:
+        const wstring &pattern_;
+        size_t pos_ = 0;
+
+        bool at_end() const {
+            return pos_ >= pattern_.size();
+        }
+
+        bool next_is(wchar_t c) const {
+            return !at_end() && pattern_[pos_] == c;
+        }
+
+        bool alternation(Length &length) {
+            if (!sequence(length)) {
+                return false;
+            }
+            while (next_is(L'|')) {
+                pos_++;
+                Length branch;
+                if (!sequence(branch)) {
+                    return false;
+                }
+                length.min = min(length.min, branch.min);
+                length.max = max(length.max, branch.max);
+            }
+            return true;
+        }
+
+        bool sequence(Length &length) {
+            length = {0, 0};
+            while (!at_end() && pattern_[pos_] != L'|' && pattern_[pos_] != L')') {
+                Length element;
+                if (!atom(element) || !quantifier(element)) {
+                    return false;
+                }
+                length.min += element.min;
+                length.max += element.max;
+                if (length.max > MAX_BOUNDED_LENGTH) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool atom(Length &length) {
+            wchar_t c = pattern_[pos_++];
+            switch (c) {
+                case L'(':
+                    return group(length);
+                case L'[':
+                    length = {1, 1};
+                    return char_class();
+                case L'\\':
+                    return escape(length);
+                case L'^':
+                case L'$':
+                    length = {0, 0};
+                    return true;
+                case L'*':
+                case L'+':
+                case L'?':
+                case L'{':
+                    return false;
+                default:
+                    length = {1, 1};
+                    return true;
+            }
+        }
+
+        bool group(Length &length) {
+            if (next_is(L'?')) {
+                pos_++;
+                if (at_end()) {
+                    return false;
+                }
+                wchar_t c = pattern_[pos_++];
+                if (c == L'<' && (next_is(L'=') || next_is(L'!'))) {
+                    // Lookbehind
+                    return false;
+                }
+                if (c == L'<' || c == L'\'' || (c == L'P' && next_is(L'<'))) {
+                    // Named group
+                    if (c == L'P') {
+                        pos_++;
+                    }
+                    wchar_t close = c == L'\'' ? L'\'' : L'>';
+                    while (!at_end() && pattern_[pos_] != close) {
+                        pos_++;
+                    }
+                    if (!skip(close)) {
+                        return false;
+                    }
+                } else if (c != L':' && c != L'>') {
+                    // Inline modifiers, either on their own or for a non-capturing group.
+                    // Lookahead, comments, recursion, conditionals, and extended mode, which
+                    // ignores whitespace in the pattern, are not supported.
+                    pos_--;
+                    while (!at_end() && (pattern_[pos_] == L'i' || pattern_[pos_] == L'm'
+                                         || pattern_[pos_] == L's' || pattern_[pos_] == L'-')) {
+                        pos_++;
+                    }
+                    if (next_is(L')')) {
+                        pos_++;
+                        length = {0, 0};
+                        // A quantifier here would apply to the preceding element.
+                        return at_end() || wstring(L"*+?{").find(pattern_[pos_]) == wstring::npos;
+                    }
+                    if (!skip(L':')) {
+                        return false;
+                    }
+                }
+            }
+            return alternation(length) && skip(L')');
+        }
+
+        bool char_class() {
+            if (next_is(L'^')) {
+                pos_++;
+            }
+            if (next_is(L']')) {
+                pos_++;
+            }
+            while (!at_end() && pattern_[pos_] != L']') {
+                wchar_t c = pattern_[pos_++];
+                if (c == L'\\') {
+                    pos_++;
+                } else if (c == L'[' && (next_is(L':') || next_is(L'=') || next_is(L'.'))) {
+                    // [:alpha:], [=a=], or [.a.]
+                    wchar_t kind = pattern_[pos_++];
+                    while (!at_end() && !(pattern_[pos_ - 1] == kind && pattern_[pos_] == L']')) {
+                        pos_++;
+                    }
+                    pos_++;
+                }
+            }
+            return skip(L']');
+        }
+
+        bool escape(Length &length) {
+            if (at_end()) {
+                return false;
+            }
+            wchar_t c = pattern_[pos_++];
+            length = {1, 1};
+            switch (c) {
+                case L'b':
+                case L'B':
+                case L'<':
+                case L'>':
+                case L'E':
+                    length = {0, 0};
+                    return true;
+                case L'Q': {
+                    // Quoted literal that runs to \E or the end of the pattern.
+                    size_t end = pattern_.find(L"\\E", pos_);
+                    end = end == wstring::npos ? pattern_.size() : end;
+                    length.min = length.max = end - pos_;
+                    pos_ = end == pattern_.size() ? end : end + 2;
+                    return length.max <= MAX_BOUNDED_LENGTH;
+                }
+                case L'x':
+                    if (next_is(L'{')) {
+                        return skip_past(L'}');
+                    }
+                    for (int i = 0; i < 2 && !at_end() && iswxdigit(pattern_[pos_]); i++) {
+                        pos_++;
+                    }
+                    return true;
+                case L'0':
+                    for (int i = 0; i < 3 && !at_end() && pattern_[pos_] >= L'0' && pattern_[pos_] <= L'7'; i++) {
+                        pos_++;
+                    }
+                    return true;
+                case L'c':
+                    pos_++;
+                    return true;
+                case L'N':
+                case L'p':
+                case L'P':
+                    if (next_is(L'{')) {
+                        return skip_past(L'}');
+                    }
+                    pos_++;
+                    return true;
+                case L'a':
+                case L'e':
+                case L'f':
+                case L'n':
+                case L'r':
+                case L't':
+                case L'd':
+                case L'D':
+                case L'w':
+                case L'W':
+                case L's':
+                case L'S':
+                case L'l':
+                case L'L':
+                case L'u':
+                case L'U':
+                case L'h':
+                case L'H':
+                case L'v':
+                case L'V':
+                case L'C':
+                    return true;
+                default:
+                    // Any other escaped letter or digit is a back reference, a buffer boundary,
+                    // or something else that can not be matched within a chunk.
+                    return !iswalnum(c) && c != L'`' && c != L'\'';
+            }
+        }
+
+        bool quantifier(Length &length) {
+            if (at_end()) {
+                return true;
+            }
+            wchar_t c = pattern_[pos_];
+            if (c == L'*' || c == L'+') {
+                return false;
+            }
+            if (c == L'?') {
+                pos_++;
+                length.min = 0;
+            } else if (c == L'{') {
+                pos_++;
+                size_t min_count, max_count;
+                if (!number(min_count)) {
+                    return false;
+                }
+                max_count = min_count;
+                if (next_is(L',')) {
+                    pos_++;
+                    if (!number(max_count)) {
+                        return false;
+                    }
+                }
+                if (!skip(L'}') || max_count > MAX_BOUNDED_LENGTH) {
+                    return false;
+                }
+                length.min *= min_count;
+                length.max *= max_count;
+            } else {
+                return true;
+            }
+            // Lazy or possessive
+            if (next_is(L'?') || next_is(L'+')) {
+                pos_++;
+            }
+            return length.max <= MAX_BOUNDED_LENGTH;
+        }
+
+        bool number(size_t &value) {
+            size_t start = pos_;
+            value = 0;
+            while (!at_end() && pattern_[pos_] >= L'0' && pattern_[pos_] <= L'9') {
+                value = value * 10 + (pattern_[pos_++] - L'0');
+                if (value > MAX_BOUNDED_LENGTH) {
+                    return false;
+                }
+            }
+            return pos_ > start;
+        }
+
+        bool skip(wchar_t c) {
+            if (!next_is(c)) {
+                return false;
+            }
+            pos_++;
+            return true;
+        }
+
+        bool skip_past(wchar_t c) {
+            while (!at_end() && pattern_[pos_] != c) {
+                pos_++;
+            }
+            return skip(c);
+        }
+    };
+}
+
+
+bool bounded_match_length(const wstring &pattern, size_t &max_length) {
+    Length length;
+    if (!LengthParser(pattern).parse(length) || length.min == 0) {
+        return false;
+    }
+    max_length = length.max;
+    return true;
+}
@@ -0,0 +1,41 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_REGEXLENGTH_H
+#define OPENMPF_COMPONENTS_REGEXLENGTH_H
+
+#include <cstddef>
+#include <string>
+
+
+// Determines the longest match, in code points, of a Perl syntax pattern. Returns false when
+// matches are unbounded (*, +, {n,}), when the pattern can match the empty string, or when it
+// uses a construct the length can not be determined for, such as back references and
+// lookaround. The result is only an upper bound for patterns that are not valid.
+bool bounded_match_length(const std::wstring &pattern, size_t &max_length);
+
+
+#endif //OPENMPF_COMPONENTS_REGEXLENGTH_H
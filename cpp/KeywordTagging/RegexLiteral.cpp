@@ -0,0 +1,203 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "RegexLiteral.h"
+
+using namespace std;
+
+
+namespace {
+    // Escaped characters that stand for themselves, the same as LiteralMatcher accepts.
+    const wstring ESCAPABLE = L".^$|?*+()[]{}\\/-#&~!\"%,:;=@ ";
+
+    // Escapes that match a single character, or nothing, from a set.
+    const wstring CLASS_ESCAPES = L"bBdDwWsSlLuUhHvVaefnrtC<>AzZG`'";
+
+    // Moves past the quantifier at pos, if any. Returns false if it is not understood.
+    bool skip_quantifier(const wstring &pattern, size_t &pos, bool &optional) {
+        optional = false;
+        if (pos >= pattern.size()) {
+            return true;
+        }
+        wchar_t c = pattern[pos];
+        if (c == L'*' || c == L'?') {
+            optional = true;
+            pos++;
+        } else if (c == L'+') {
+            pos++;
+        } else if (c == L'{') {
+            size_t end = pattern.find(L'}', pos);
+            if (end == wstring::npos) {
+                return false;
+            }
+            // {0}, {0,n}, and {,n} make the element optional. Any other count requires it at
+            // least once, but that is not needed for the run it ends.
+            optional = pos + 1 == end || pattern[pos + 1] == L'0' || pattern[pos + 1] == L',';
+            pos = end + 1;
+        } else {
+            return true;
+        }
+        // Lazy or possessive
+        if (pos < pattern.size() && (pattern[pos] == L'?' || pattern[pos] == L'+')) {
+            pos++;
+        }
+        return true;
+    }
+
+    // Moves past the character class that starts at pos, the position after the '['.
+    bool skip_char_class(const wstring &pattern, size_t &pos) {
+        if (pos < pattern.size() && pattern[pos] == L'^') {
+            pos++;
+        }
+        if (pos < pattern.size() && pattern[pos] == L']') {
+            pos++;
+        }
+        while (pos < pattern.size() && pattern[pos] != L']') {
+            wchar_t c = pattern[pos++];
+            if (c == L'\\') {
+                pos++;
+            } else if (c == L'[' && pos < pattern.size()
+                    && (pattern[pos] == L':' || pattern[pos] == L'=' || pattern[pos] == L'.')) {
+                // [:alpha:], [=a=], or [.a.]
+                wchar_t kind = pattern[pos++];
+                while (pos + 1 < pattern.size() && !(pattern[pos] == kind && pattern[pos + 1] == L']')) {
+                    pos++;
+                }
+                pos += 2;
+            }
+        }
+        if (pos >= pattern.size()) {
+            return false;
+        }
+        pos++;
+        return true;
+    }
+
+    // Moves past the group that starts at pos, the position after the '('. Only groups that
+    // can not change how the rest of the pattern is matched are skipped.
+    bool skip_group(const wstring &pattern, size_t &pos) {
+        if (pos < pattern.size() && pattern[pos] == L'?') {
+            // Non-capturing groups, lookaround, and independent sub-expressions.
+            bool lookbehind = pattern.compare(pos + 1, 2, L"<=") == 0
+                    || pattern.compare(pos + 1, 2, L"<!") == 0;
+            if (!lookbehind && (pos + 1 >= pattern.size()
+                                || wstring(L":=!>").find(pattern[pos + 1]) == wstring::npos)) {
+                return false;
+            }
+        }
+        int depth = 1;
+        while (pos < pattern.size()) {
+            wchar_t c = pattern[pos++];
+            if (c == L'\\') {
+                if (pos < pattern.size() && pattern[pos] == L'Q') {
+                    return false;
+                }
+                pos++;
+            } else if (c == L'[') {
+                if (!skip_char_class(pattern, pos)) {
+                    return false;
+                }
+            } else if (c == L'(') {
+                if (pos < pattern.size() && pattern[pos] == L'?' && pos + 1 < pattern.size()
+                        && wstring(L":=!><").find(pattern[pos + 1]) == wstring::npos) {
+                    // Inline modifiers could apply to the rest of the pattern.
+                    return false;
+                }
+                depth++;
+            } else if (c == L')' && --depth == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+
+wstring required_literal(const wstring &pattern) {
+    // Pattern text of the longest run so far and of the current one, and their lengths in
+    // characters.
+    wstring longest, run;
+    size_t longest_length = 0, run_length = 0;
+    auto end_run = [&] {
+        if (run_length > longest_length) {
+            longest = run;
+            longest_length = run_length;
+        }
+        run.clear();
+        run_length = 0;
+    };
+
+    size_t pos = 0;
+    while (pos < pattern.size()) {
+        size_t atom_start = pos;
+        bool literal = false;
+        wchar_t c = pattern[pos++];
+        if (c == L'(') {
+            if (!skip_group(pattern, pos)) {
+                return L"";
+            }
+        } else if (c == L'[') {
+            if (!skip_char_class(pattern, pos)) {
+                return L"";
+            }
+        } else if (c == L'\\') {
+            if (pos >= pattern.size()) {
+                return L"";
+            }
+            wchar_t escaped = pattern[pos++];
+            if (ESCAPABLE.find(escaped) != wstring::npos) {
+                literal = true;
+            } else if (CLASS_ESCAPES.find(escaped) == wstring::npos) {
+                // Back references, \Q quotes, and escapes that span several pattern characters,
+                // such as \x41, \p{L}, or \cA.
+                return L"";
+            }
+        } else if (c == L'|' || c == L')' || c == L'*' || c == L'+' || c == L'?' || c == L'{') {
+            // Alternation, or a quantifier that does not follow an element.
+            return L"";
+        } else if (wstring(L".^$]}").find(c) == wstring::npos) {
+            // An unescaped ']' or '}' is also matched as itself, but LiteralMatcher only
+            // accepts them escaped.
+            literal = true;
+        }
+        size_t atom_end = pos;
+
+        bool optional;
+        bool quantified = pos < pattern.size() && wstring(L"*+?{").find(pattern[pos]) != wstring::npos;
+        if (!skip_quantifier(pattern, pos, optional)) {
+            return L"";
+        }
+        if (literal && !optional) {
+            run.append(pattern, atom_start, atom_end - atom_start);
+            run_length++;
+        }
+        if (!literal || quantified) {
+            end_run();
+        }
+    }
+    end_run();
+    return longest_length >= 2 ? longest : L"";
+}
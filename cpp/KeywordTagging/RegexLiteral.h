@@ -0,0 +1,42 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_REGEXLITERAL_H
+#define OPENMPF_COMPONENTS_REGEXLITERAL_H
+
+#include <string>
+
+
+// Finds the longest run of plain characters that every match of a Perl syntax pattern must
+// contain, e.g. "word" for "(\b)words?(\b)". The run is returned as it appears in the pattern,
+// so it can be added to a LiteralMatcher, and it is matched with the pattern's case
+// sensitivity. Returns an empty string when the pattern has no such run of at least two
+// characters, or uses a construct that is not understood, such as a top-level alternation or
+// inline modifiers.
+std::wstring required_literal(const std::wstring &pattern);
+
+
+#endif //OPENMPF_COMPONENTS_REGEXLITERAL_H
@@ -0,0 +1,202 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "TagCache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+
+#include <MPFDetectionException.h>
+
+#include "MappedFile.h"
+#include "RegexLength.h"
+#include "RegexLiteral.h"
+#include "TagSetFile.h"
+
+using namespace MPF;
+using namespace COMPONENT;
+
+using namespace std;
+
+
+TagRegex::TagRegex(wstring pattern, bool case_sensitive, int literal_id, int required_literal_id)
+        : pattern_(move(pattern))
+        , case_sensitive_(case_sensitive)
+        , literal_id_(literal_id)
+        , required_literal_id_(required_literal_id) {
+    if (literal_id_ < 0 && !bounded_match_length(pattern_, max_length_)) {
+        max_length_ = 0;
+    }
+}
+
+TagRegex::TagRegex(wstring pattern, bool case_sensitive, int literal_id, size_t max_length,
+                   int required_literal_id)
+        : pattern_(move(pattern))
+        , case_sensitive_(case_sensitive)
+        , literal_id_(literal_id)
+        , required_literal_id_(required_literal_id)
+        , max_length_(max_length) {
+}
+
+const boost::wregex &TagRegex::regex() const {
+    call_once(compile_flag_, [this] {
+        try {
+            if (case_sensitive_) {
+                regex_ = boost::wregex(pattern_, boost::regex_constants::perl);
+            } else {
+                regex_ = boost::wregex(pattern_, boost::regex_constants::perl | boost::regex::icase);
+            }
+        } catch (const boost::regex_error &e) {
+            stringstream ss;
+            ss << "regex_error caught: " << parse_regex_code(e.code()) << ": " << e.what() << '\n';
+            error_ = ss.str();
+        }
+    });
+
+    if (!error_.empty()) {
+        throw MPFDetectionException(MPF_COULD_NOT_READ_DATAFILE, error_);
+    }
+    return regex_;
+}
+
+
+mutex TagSetCache::mutex_;
+map<string, TagSetCache::Entry> TagSetCache::entries_;
+
+namespace {
+    shared_ptr<const TagSet> load_tag_set(const string &path, const TagSetCache::Parser &parse) {
+        MappedFile file(path);
+        if (file.is_open() && is_compiled_tag_set(file.data(), file.size())) {
+            return read_compiled_tag_set(path, file.data(), file.size());
+        }
+        return create_tag_set(parse(path));
+    }
+}
+
+shared_ptr<const TagSet> TagSetCache::get(const string &path, const Parser &parse) {
+    error_code ec;
+    auto modified = filesystem::last_write_time(path, ec);
+    uintmax_t size = ec ? 0 : filesystem::file_size(path, ec);
+    if (ec) {
+        // Not cached. The parser reports the error if the file can not be opened.
+        {
+            lock_guard<mutex> lock(mutex_);
+            entries_.erase(path);
+        }
+        return load_tag_set(path, parse);
+    }
+    long long modified_count = modified.time_since_epoch().count();
+
+    lock_guard<mutex> lock(mutex_);
+    auto iter = entries_.find(path);
+    if (iter != entries_.end() && iter->second.modified == modified_count
+            && iter->second.size == size) {
+        return iter->second.tag_set;
+    }
+
+    // Parse while holding the lock so that concurrent jobs do not load the same file twice.
+    auto tag_set = load_tag_set(path, parse);
+    entries_[path] = { modified_count, size, tag_set };
+    return tag_set;
+}
+
+void TagSetCache::clear() {
+    lock_guard<mutex> lock(mutex_);
+    entries_.clear();
+}
+
+
+shared_ptr<const TagSet> create_tag_set(TagSetCache::Patterns patterns) {
+    auto tag_set = make_shared<TagSet>();
+    // Regexes that appear more than once are only compiled once. Literals already share
+    // an id in the LiteralMatcher. Case-insensitive and case-sensitive regexes are keyed by
+    // views of the TagRegexes' own patterns.
+    unordered_map<wstring_view, shared_ptr<const TagRegex>> distinct_regexes[2];
+    for (auto &kv : patterns) {
+        auto &tag_patterns = tag_set->tags[kv.first];
+        for (auto &pattern : kv.second) {
+            int literal_id = tag_set->literals.add(pattern.first, pattern.second);
+            if (literal_id >= 0) {
+                tag_patterns.push_back(make_shared<const TagRegex>(move(pattern.first), pattern.second,
+                                                                   literal_id));
+                continue;
+            }
+            auto &regexes = distinct_regexes[pattern.second];
+            auto iter = regexes.find(pattern.first);
+            if (iter == regexes.end()) {
+                // Regexes whose required literal is not in a text are skipped without searching.
+                // The literal is matched along with the other literals.
+                wstring required = required_literal(pattern.first);
+                int required_literal_id = required.empty() ? -1 : tag_set->literals.add(required, pattern.second);
+                auto tag_regex = make_shared<const TagRegex>(move(pattern.first), pattern.second, literal_id,
+                                                             required_literal_id);
+                tag_set->max_regex_length = max(tag_set->max_regex_length, tag_regex->max_length());
+                iter = regexes.emplace(tag_regex->pattern(), move(tag_regex)).first;
+            }
+            tag_patterns.push_back(iter->second);
+        }
+    }
+    tag_set->literals.build();
+    return tag_set;
+}
+
+
+string parse_regex_code(const boost::regex_constants::error_type &etype) {
+    switch (etype) {
+        case boost::regex_constants::error_collate:
+            return "error_collate: invalid collating element request";
+        case boost::regex_constants::error_ctype:
+            return "error_ctype: invalid character class";
+        case boost::regex_constants::error_escape:
+            return "error_escape: invalid escape character or trailing escape";
+        case boost::regex_constants::error_backref:
+            return "error_backref: invalid back reference";
+        case boost::regex_constants::error_brack:
+            return "error_brack: mismatched bracket([ or ])";
+        case boost::regex_constants::error_paren:
+            return "error_paren: mismatched parentheses(( or ))";
+        case boost::regex_constants::error_brace:
+            return "error_brace: mismatched brace({ or })";
+        case boost::regex_constants::error_badbrace:
+            return "error_badbrace: invalid range inside a { }";
+        case boost::regex_constants::error_range:
+            return "erro_range: invalid character range(e.g., [z-a])";
+        case boost::regex_constants::error_space:
+            return "error_space: insufficient memory to handle this regular expression";
+        case boost::regex_constants::error_badrepeat:
+            return "error_badrepeat: a repetition character (*, ?, +, or {) was not preceded by a valid regular expression";
+        case boost::regex_constants::error_complexity:
+            return "error_complexity: the requested match is too complex";
+        case boost::regex_constants::error_stack:
+            return "error_stack: insufficient memory to evaluate a match";
+        default:
+            return "";
+    }
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_TAGCACHE_H
+#define OPENMPF_COMPONENTS_TAGCACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/regex.hpp>
+
+#include "LiteralMatcher.h"
+
+
+// Regex pattern from the tagging file. The pattern is compiled the first time it is used,
+// so that, as before, an invalid pattern is only reported when a job reaches it. Once
+// compiled it can be shared by any number of threads and jobs.
+class TagRegex {
+public:
+    TagRegex(std::wstring pattern, bool case_sensitive, int literal_id = -1, int required_literal_id = -1);
+
+    // For patterns from a compiled tag set, where the longest match is already known.
+    TagRegex(std::wstring pattern, bool case_sensitive, int literal_id, size_t max_length,
+             int required_literal_id);
+
+    const std::wstring &pattern() const { return pattern_; }
+
+    bool case_sensitive() const { return case_sensitive_; }
+
+    // Id of the pattern in the tag set's LiteralMatcher, or -1 if it has to be matched as a
+    // regex.
+    int literal_id() const { return literal_id_; }
+
+    // Id in the tag set's LiteralMatcher of a literal that every match of the regex contains,
+    // or -1 if there is none. The regex can not match a text the literal is not found in.
+    int required_literal_id() const { return required_literal_id_; }
+
+    // Longest match of the pattern in code points, or 0 when matches are unbounded or can be
+    // empty. Only computed for patterns that are not literals.
+    size_t max_length() const { return max_length_; }
+
+    // Throws MPFDetectionException when the pattern is not a valid regex.
+    const boost::wregex &regex() const;
+
+private:
+    std::wstring pattern_;
+    bool case_sensitive_;
+    int literal_id_;
+    int required_literal_id_;
+    size_t max_length_ = 0;
+
+    mutable std::once_flag compile_flag_;
+    mutable boost::wregex regex_;
+    mutable std::string error_;
+};
+
+
+// Tags from a tagging file and their patterns, in the order they appear in the file. Regexes
+// that appear more than once, with the same case sensitivity, share a TagRegex.
+struct TagSet {
+    std::map<std::wstring, std::vector<std::shared_ptr<const TagRegex>>> tags;
+
+    // All of the patterns that are plain literals.
+    LiteralMatcher literals;
+
+    // Longest match of the regex patterns that have a bounded match length.
+    size_t max_regex_length = 0;
+};
+
+
+// Process-wide cache of tag sets, so that the tagging file is only parsed and its regexes
+// are only compiled once rather than for every job. An entry is reloaded when the file's
+// modification time or size changes.
+class TagSetCache {
+public:
+    using Patterns = std::map<std::wstring, std::vector<std::pair<std::wstring, bool>>>;
+
+    using Parser = std::function<Patterns(const std::string &path)>;
+
+    // Returns the tag set for the tagging file at path, calling parse when it is not
+    // cached or has changed. Compiled tag sets are loaded without calling parse.
+    static std::shared_ptr<const TagSet> get(const std::string &path, const Parser &parse);
+
+    static void clear();
+
+private:
+    struct Entry {
+        long long modified;
+        uintmax_t size;
+        std::shared_ptr<const TagSet> tag_set;
+    };
+
+    static std::mutex mutex_;
+    static std::map<std::string, Entry> entries_;
+};
+
+
+std::shared_ptr<const TagSet> create_tag_set(TagSetCache::Patterns patterns);
+
+
+std::string parse_regex_code(const boost::regex_constants::error_type &etype);
+
+
+#endif //OPENMPF_COMPONENTS_TAGCACHE_H
@@ -0,0 +1,479 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "TagFileParser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include <boost/locale.hpp>
+
+#include <MPFDetectionException.h>
+
+#include "MappedFile.h"
+#include "Utf8.h"
+
+using namespace MPF;
+using namespace COMPONENT;
+
+using namespace std;
+
+
+TagFileParser::TagFileParser(const char *begin, const char *end)
+        : pos_(begin)
+        , end_(find(begin, end, '\0')) {
+}
+
+
+bool TagFileParser::parse() {
+    if (!skip_whitespace()) {
+        return false;
+    }
+    if (*pos_ == '{') {
+        if (!object([this](const wstring &name) { return root_member(name); })) {
+            return false;
+        }
+    } else if (!skip_value()) {
+        return false;
+    }
+    // Nothing but whitespace may follow the root value.
+    if (skip_whitespace()) {
+        return false;
+    }
+
+    for (auto iter = patterns_.begin(); iter != patterns_.end();) {
+        if (iter->second.empty()) {
+            iter = patterns_.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    return true;
+}
+
+
+bool TagFileParser::root_member(const wstring &name) {
+    if (name != L"TAGS_BY_REGEX") {
+        return skip_value();
+    }
+    patterns_.clear();
+    invalid_tags_.clear();
+    has_tags_by_regex_ = *pos_ == '{';
+    if (!has_tags_by_regex_) {
+        return skip_value();
+    }
+    return object([this](const wstring &tag) { return tag_member(tag); });
+}
+
+
+bool TagFileParser::tag_member(const wstring &tag) {
+    invalid_tags_.erase(tag);
+    auto &tag_patterns = patterns_[tag];
+    tag_patterns.clear();
+    if (*pos_ != '[') {
+        invalid_tags_.insert(tag);
+        return skip_value();
+    }
+    return array([&] { return pattern_entry(tag_patterns); });
+}
+
+
+bool TagFileParser::pattern_entry(vector<pair<wstring, bool>> &tag_patterns) {
+    if (*pos_ == '"') {
+        // Legacy regex patterns in the JSON tags file are listed as follows:
+        //
+        // "TAGS_BY_REGEX": {
+        //    "vehicle-tag-legacy-format": [
+        //        "auto",
+        //        "car"
+        //    ],
+        //  ...
+        // }
+        pos_++;
+        wstring pattern;
+        if (!parse_string(&pattern)) {
+            return false;
+        }
+        tag_patterns.emplace_back(move(pattern), false);
+        return true;
+    }
+    if (*pos_ != '{') {
+        // Other types of entries are ignored.
+        return skip_value();
+    }
+
+    // Standard JSON regex patterns are listed as follows:
+    //
+    // "TAGS_BY_REGEX": {
+    //    "vehicle-tag-standard-format": [
+    //      {"pattern": "auto"},
+    //      {"pattern": "car", "caseSensitive": true}
+    //    ],
+    //  ...
+    //}
+    bool has_pattern = false;
+    bool pattern_is_string = false;
+    wstring pattern;
+    bool case_sensitive = false;
+    bool parsed = object([&](const wstring &name) {
+        if (name == L"pattern") {
+            has_pattern = true;
+            pattern_is_string = *pos_ == '"';
+            if (!pattern_is_string) {
+                return skip_value();
+            }
+            pos_++;
+            pattern.clear();
+            return parse_string(&pattern);
+        }
+        if (name == L"caseSensitive") {
+            // Values other than true, such as strings and numbers, are treated as false.
+            case_sensitive = starts_with("true");
+        }
+        return skip_value();
+    });
+    if (!parsed) {
+        return false;
+    }
+    if (has_pattern) {
+        if (!pattern_is_string) {
+            return false;
+        }
+        tag_patterns.emplace_back(move(pattern), case_sensitive);
+    }
+    return true;
+}
+
+
+// Objects and arrays are parsed the same way as SimpleJSON: a closing bracket is only accepted
+// directly after the opening bracket or after a value, and a member name may start with any
+// character, not just a quote.
+template<typename ParseMember>
+bool TagFileParser::object(ParseMember parse_member) {
+    pos_++;
+    bool empty = true;
+    wstring name;
+    while (pos_ != end_) {
+        if (!skip_whitespace()) {
+            return false;
+        }
+        if (empty && *pos_ == '}') {
+            pos_++;
+            return true;
+        }
+
+        do {
+            pos_++;
+        } while (pos_ != end_ && (static_cast<unsigned char>(*pos_) & 0xC0) == 0x80);
+        name.clear();
+        if (!parse_string(&name)) {
+            return false;
+        }
+
+        if (!skip_whitespace() || *pos_++ != ':' || !skip_whitespace()) {
+            return false;
+        }
+        if (!parse_member(name)) {
+            return false;
+        }
+        empty = false;
+
+        if (!skip_whitespace()) {
+            return false;
+        }
+        if (*pos_ == '}') {
+            pos_++;
+            return true;
+        }
+        if (*pos_ != ',') {
+            return false;
+        }
+        pos_++;
+    }
+    return false;
+}
+
+
+template<typename ParseElement>
+bool TagFileParser::array(ParseElement parse_element) {
+    pos_++;
+    bool empty = true;
+    while (pos_ != end_) {
+        if (!skip_whitespace()) {
+            return false;
+        }
+        if (empty && *pos_ == ']') {
+            pos_++;
+            return true;
+        }
+
+        if (!parse_element()) {
+            return false;
+        }
+        empty = false;
+
+        if (!skip_whitespace()) {
+            return false;
+        }
+        if (*pos_ == ']') {
+            pos_++;
+            return true;
+        }
+        if (*pos_ != ',') {
+            return false;
+        }
+        pos_++;
+    }
+    return false;
+}
+
+
+bool TagFileParser::skip_value() {
+    char c = *pos_;
+    if (c == '"') {
+        pos_++;
+        return parse_string(nullptr);
+    }
+    if (literal()) {
+        return true;
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        return number();
+    }
+    if (c == '{') {
+        return object([this](const wstring &) { return skip_value(); });
+    }
+    if (c == '[') {
+        return array([this] { return skip_value(); });
+    }
+    return false;
+}
+
+
+// Parses the rest of a string after the opening quote. When value is null, the string is only
+// checked.
+bool TagFileParser::parse_string(wstring *value) {
+    while (pos_ != end_) {
+        auto c = static_cast<unsigned char>(*pos_);
+        if (c == '"') {
+            pos_++;
+            return true;
+        }
+        if (c < 0x20 && c != '\t') {
+            return false;
+        }
+        if (c != '\\') {
+            if (c < 0x80 || value == nullptr) {
+                // Copy the run of characters that need no decoding at once.
+                const char *run_begin = pos_;
+                do {
+                    pos_++;
+                } while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\'
+                         && static_cast<unsigned char>(*pos_) >= 0x20
+                         && (static_cast<unsigned char>(*pos_) < 0x80 || value == nullptr));
+                if (value != nullptr) {
+                    value->append(run_begin, pos_);
+                }
+            } else {
+                auto code_point = boost::locale::utf::utf_traits<char>::decode_valid(pos_);
+                value->push_back(static_cast<wchar_t>(code_point));
+            }
+            continue;
+        }
+
+        pos_++;
+        if (pos_ == end_) {
+            return false;
+        }
+        wchar_t escaped;
+        switch (*pos_) {
+            case '"':
+            case '\\':
+            case '/':
+                escaped = *pos_;
+                break;
+            case 'b':
+                escaped = L'\b';
+                break;
+            case 'f':
+                escaped = L'\f';
+                break;
+            case 'n':
+                escaped = L'\n';
+                break;
+            case 'r':
+                escaped = L'\r';
+                break;
+            case 't':
+                escaped = L'\t';
+                break;
+            case 'u': {
+                // Like SimpleJSON, each \uXXXX escape is a single character, so surrogate pairs
+                // are not combined.
+                if (end_ - pos_ < 5) {
+                    return false;
+                }
+                escaped = 0;
+                for (int i = 0; i < 4; i++) {
+                    char digit = *++pos_;
+                    escaped <<= 4;
+                    if (digit >= '0' && digit <= '9') {
+                        escaped |= digit - '0';
+                    } else if (digit >= 'A' && digit <= 'F') {
+                        escaped |= digit - 'A' + 10;
+                    } else if (digit >= 'a' && digit <= 'f') {
+                        escaped |= digit - 'a' + 10;
+                    } else {
+                        return false;
+                    }
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+        if (value != nullptr) {
+            value->push_back(escaped);
+        }
+        pos_++;
+    }
+    return false;
+}
+
+
+// Like SimpleJSON, true, false, and null are not case-sensitive.
+bool TagFileParser::literal() {
+    for (const char *word : {"true", "false", "null"}) {
+        if (starts_with(word)) {
+            pos_ += strlen(word);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool TagFileParser::number() {
+    auto is_digit = [this] { return pos_ != end_ && *pos_ >= '0' && *pos_ <= '9'; };
+    auto skip_digits = [&] {
+        while (is_digit()) {
+            pos_++;
+        }
+    };
+
+    if (*pos_ == '-') {
+        pos_++;
+    }
+    if (pos_ != end_ && *pos_ == '0') {
+        pos_++;
+    } else if (is_digit()) {
+        skip_digits();
+    } else {
+        return false;
+    }
+
+    if (pos_ != end_ && *pos_ == '.') {
+        pos_++;
+        if (!is_digit()) {
+            return false;
+        }
+        skip_digits();
+    }
+
+    if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+        pos_++;
+        if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-')) {
+            pos_++;
+        }
+        if (!is_digit()) {
+            return false;
+        }
+        skip_digits();
+    }
+    return true;
+}
+
+
+// Returns false if the end of the text is reached.
+bool TagFileParser::skip_whitespace() {
+    while (pos_ != end_ && (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\r' || *pos_ == '\n')) {
+        pos_++;
+    }
+    return pos_ != end_;
+}
+
+
+bool TagFileParser::starts_with(const char *word) const {
+    for (const char *iter = pos_; *word != '\0'; ++iter, ++word) {
+        if (iter == end_ || tolower(static_cast<unsigned char>(*iter)) != *word) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+TagFileParser::Patterns read_tag_file(const string &path) {
+    MappedFile file(path);
+
+    if (!file.is_open()) {
+        throw MPFDetectionException(MPF_COULD_NOT_OPEN_DATAFILE,
+                                    "Could not open tagging file: " + path);
+    }
+
+    const char *text_begin = file.data();
+    const char *text_end = file.data() + file.size();
+    string sanitized;
+    if (!is_valid_utf8(text_begin, text_end)) {
+        sanitized = boost::locale::conv::utf_to_utf<char>(text_begin, text_end);
+        text_begin = sanitized.data();
+        text_end = sanitized.data() + sanitized.size();
+    }
+
+    TagFileParser parser(text_begin, text_end);
+
+    if (!parser.parse()) {
+        throw MPFDetectionException(MPF_COULD_NOT_READ_DATAFILE,
+                                    "Could not parse tagging file: " + path);
+    }
+
+    if (!parser.has_tags_by_regex()) {
+        throw MPFDetectionException(MPF_COULD_NOT_READ_DATAFILE,
+                                    "Could not parse tagging file: " + path +
+                                    ". TAGS_BY_REGEX not found.");
+    }
+
+    if (!parser.invalid_tags().empty()) {
+        throw MPFDetectionException(MPF_COULD_NOT_READ_DATAFILE,
+                                    "Could not parse tagging file: " + path +
+                                    ". In TAGS_BY_REGEX the entry for \"" +
+                                    boost::locale::conv::utf_to_utf<char>(*parser.invalid_tags().begin()) +
+                                    "\" is not a valid JSON array.");
+    }
+
+    return move(parser.patterns());
+}
@@ -0,0 +1,100 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_TAGFILEPARSER_H
+#define OPENMPF_COMPONENTS_TAGFILEPARSER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// Single pass parser for JSON tagging files. The TAGS_BY_REGEX patterns are collected as they
+// are read, without building a document tree, and the rest of the document is only checked for
+// syntax. It accepts the same documents as the SimpleJSON library it replaced, including that
+// library's leniencies, so that the same tagging files are reported as malformed.
+class TagFileParser {
+public:
+    using Patterns = std::map<std::wstring, std::vector<std::pair<std::wstring, bool>>>;
+
+    // The text must be valid UTF-8. Like a C string, it ends at the first NUL character.
+    TagFileParser(const char *begin, const char *end);
+
+    // Returns false when the text is not valid JSON, or a pattern is not a string.
+    bool parse();
+
+    // Whether the root object has a TAGS_BY_REGEX object. When a key appears more than once in
+    // an object, only the last value is used.
+    bool has_tags_by_regex() const { return has_tags_by_regex_; }
+
+    // Tags in TAGS_BY_REGEX whose patterns are not in an array.
+    const std::set<std::wstring> &invalid_tags() const { return invalid_tags_; }
+
+    // Patterns by tag, in the order they appear. Tags without patterns are left out.
+    Patterns &patterns() { return patterns_; }
+
+private:
+    const char *pos_;
+    const char *end_;
+
+    bool has_tags_by_regex_ = false;
+    std::set<std::wstring> invalid_tags_;
+    Patterns patterns_;
+
+    bool root_member(const std::wstring &name);
+
+    bool tag_member(const std::wstring &tag);
+
+    bool pattern_entry(std::vector<std::pair<std::wstring, bool>> &tag_patterns);
+
+    template<typename ParseMember>
+    bool object(ParseMember parse_member);
+
+    template<typename ParseElement>
+    bool array(ParseElement parse_element);
+
+    bool skip_value();
+
+    bool parse_string(std::wstring *value);
+
+    bool literal();
+
+    bool number();
+
+    bool skip_whitespace();
+
+    bool starts_with(const char *word) const;
+};
+
+
+// Reads the patterns from the tagging file at path. Throws MPFDetectionException when the file
+// can not be opened or is not a valid tagging file.
+TagFileParser::Patterns read_tag_file(const std::string &path);
+
+
+#endif //OPENMPF_COMPONENTS_TAGFILEPARSER_H
@@ -0,0 +1,170 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "TagSetFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#include <MPFDetectionException.h>
+
+#include "BinaryIO.h"
+
+using namespace MPF;
+using namespace COMPONENT;
+
+using namespace std;
+
+
+// File layout, after the header:
+//   regex patterns: count, then for each the pattern, case sensitivity, literal id, and
+//                   longest match
+//   tags: count, then for each the tag and the indexes of its patterns
+//   longest match of the bounded regexes
+//   literal automaton, as written by LiteralMatcher::save
+namespace {
+    const char MAGIC[8] = { 'M', 'P', 'F', 'K', 'T', 'A', 'G', 'S' };
+
+    // Increment when the layout changes.
+    const uint32_t VERSION = 2;
+
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    MPFDetectionException read_error(const string &path, const string &reason) {
+        return { MPF_COULD_NOT_READ_DATAFILE,
+                 "Could not read compiled tagging file: " + path + ". " + reason };
+    }
+}
+
+
+bool is_compiled_tag_set(const char *data, size_t size) {
+    return size >= sizeof MAGIC && memcmp(data, MAGIC, sizeof MAGIC) == 0;
+}
+
+
+void write_compiled_tag_set(const TagSet &tag_set, const string &path) {
+    static_assert(sizeof(wchar_t) == sizeof(uint32_t), "Compiled tag sets store wchar_t as 32 bits.");
+
+    map<const TagRegex *, uint32_t> indexes;
+    vector<const TagRegex *> regexes;
+    for (const auto &kv : tag_set.tags) {
+        for (const auto &tag_regex : kv.second) {
+            if (indexes.emplace(tag_regex.get(), regexes.size()).second) {
+                regexes.push_back(tag_regex.get());
+            }
+        }
+    }
+
+    BinaryWriter out;
+    for (char c : MAGIC) {
+        out.write_u8(c);
+    }
+    out.write_u32(VERSION);
+    out.write_u32(BYTE_ORDER_MARK);
+
+    out.write_u64(regexes.size());
+    for (const TagRegex *tag_regex : regexes) {
+        out.write_wstring(tag_regex->pattern());
+        out.write_u8(tag_regex->case_sensitive());
+        out.write_u32(static_cast<uint32_t>(tag_regex->literal_id()));
+        out.write_u32(static_cast<uint32_t>(tag_regex->required_literal_id()));
+        out.write_u64(tag_regex->max_length());
+    }
+
+    out.write_u64(tag_set.tags.size());
+    for (const auto &kv : tag_set.tags) {
+        out.write_wstring(kv.first);
+        vector<uint32_t> tag_indexes;
+        for (const auto &tag_regex : kv.second) {
+            tag_indexes.push_back(indexes.at(tag_regex.get()));
+        }
+        out.write_array(tag_indexes);
+    }
+
+    out.write_u64(tag_set.max_regex_length);
+    tag_set.literals.save(out);
+
+    ofstream file(path, ios::binary);
+    file.write(out.data().data(), out.data().size());
+    file.close();
+    if (!file) {
+        throw MPFDetectionException(MPF_COULD_NOT_OPEN_DATAFILE,
+                                    "Could not write compiled tagging file: " + path);
+    }
+}
+
+
+shared_ptr<const TagSet> read_compiled_tag_set(const string &path, const char *data, size_t size) {
+    if (!is_compiled_tag_set(data, size)) {
+        throw read_error(path, "The file is not a compiled tag set.");
+    }
+    BinaryReader in(data + sizeof MAGIC, data + size);
+    uint32_t version = in.read_u32();
+    uint32_t byte_order_mark = in.read_u32();
+    if (version != VERSION || byte_order_mark != BYTE_ORDER_MARK) {
+        throw read_error(path, "The file was compiled by a different version of keyword_tag_compiler or on a "
+                               "different platform. Compile it again from the tagging file.");
+    }
+
+    auto tag_set = make_shared<TagSet>();
+    vector<shared_ptr<const TagRegex>> regexes;
+    uint64_t num_regexes = in.read_u64();
+    regexes.reserve(min<uint64_t>(num_regexes, in.remaining()));
+    for (uint64_t i = 0; i < num_regexes && !in.failed(); i++) {
+        wstring pattern = in.read_wstring();
+        bool case_sensitive = in.read_u8() != 0;
+        auto literal_id = static_cast<int32_t>(in.read_u32());
+        auto required_literal_id = static_cast<int32_t>(in.read_u32());
+        uint64_t max_length = in.read_u64();
+        regexes.push_back(make_shared<const TagRegex>(move(pattern), case_sensitive, literal_id, max_length,
+                                                      required_literal_id));
+    }
+
+    uint64_t num_tags = in.read_u64();
+    for (uint64_t i = 0; i < num_tags && !in.failed(); i++) {
+        auto &tag_patterns = tag_set->tags[in.read_wstring()];
+        for (uint32_t index : in.read_array<uint32_t>()) {
+            if (index >= regexes.size()) {
+                throw read_error(path, "The file is damaged.");
+            }
+            tag_patterns.push_back(regexes[index]);
+        }
+    }
+
+    tag_set->max_regex_length = in.read_u64();
+    if (!tag_set->literals.load(in) || !in.at_end()) {
+        throw read_error(path, "The file is damaged.");
+    }
+    for (const auto &tag_regex : regexes) {
+        if (tag_regex->literal_id() >= static_cast<int>(tag_set->literals.size())
+                || tag_regex->required_literal_id() >= static_cast<int>(tag_set->literals.size())) {
+            throw read_error(path, "The file is damaged.");
+        }
+    }
+    return tag_set;
+}
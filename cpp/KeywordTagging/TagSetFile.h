@@ -0,0 +1,50 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_TAGSETFILE_H
+#define OPENMPF_COMPONENTS_TAGSETFILE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "TagCache.h"
+
+
+// Compiled tag sets are tag sets saved by keyword_tag_compiler, with their literal automaton
+// already built, so that they can be loaded without parsing a tagging file. Regexes are still
+// compiled the first time a job uses them.
+
+bool is_compiled_tag_set(const char *data, size_t size);
+
+// Throws MPFDetectionException when the file can not be written.
+void write_compiled_tag_set(const TagSet &tag_set, const std::string &path);
+
+// Throws MPFDetectionException when the data is not a compiled tag set in the current format.
+std::shared_ptr<const TagSet> read_compiled_tag_set(const std::string &path, const char *data, size_t size);
+
+
+#endif //OPENMPF_COMPONENTS_TAGSETFILE_H
@@ -0,0 +1,99 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+#ifndef OPENMPF_COMPONENTS_UTF8_H
+#define OPENMPF_COMPONENTS_UTF8_H
+
+#include <string>
+
+#include <boost/locale/utf.hpp>
+
+
+// Helpers for working directly on UTF-8 text. Offsets are byte offsets into the text, which
+// must be valid UTF-8 except for is_valid_utf8.
+
+inline bool is_valid_utf8(const char *begin, const char *end) {
+    using boost::locale::utf::utf_traits;
+    auto iter = begin;
+    while (iter != end) {
+        if (static_cast<unsigned char>(*iter) < 0x80) {
+            ++iter;
+            continue;
+        }
+        auto c = utf_traits<char>::decode(iter, end);
+        if (c == boost::locale::utf::illegal || c == boost::locale::utf::incomplete) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+inline bool is_valid_utf8(const std::string &text) {
+    return is_valid_utf8(text.data(), text.data() + text.size());
+}
+
+
+inline bool is_utf8_continuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+
+// Returns the number of code points in text[begin, end).
+inline size_t utf8_length(const std::string &text, size_t begin, size_t end) {
+    size_t length = 0;
+    for (size_t pos = begin; pos < end; pos++) {
+        if (!is_utf8_continuation(text[pos])) {
+            length++;
+        }
+    }
+    return length;
+}
+
+
+// Returns the code point at pos and advances pos to the next code point.
+inline wchar_t utf8_decode(const std::string &text, size_t &pos) {
+    auto lead = static_cast<unsigned char>(text[pos]);
+    if (lead < 0x80) {
+        pos++;
+        return lead;
+    }
+    auto iter = text.begin() + pos;
+    auto c = boost::locale::utf::utf_traits<char>::decode_valid(iter);
+    pos = iter - text.begin();
+    return static_cast<wchar_t>(c);
+}
+
+
+// Returns the offset of the code point that ends at pos.
+inline size_t utf8_previous(const std::string &text, size_t pos) {
+    do {
+        pos--;
+    } while (pos > 0 && is_utf8_continuation(text[pos]));
+    return pos;
+}
+
+
+#endif //OPENMPF_COMPONENTS_UTF8_H
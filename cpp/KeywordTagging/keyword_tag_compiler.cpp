@@ -0,0 +1,89 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include <iostream>
+#include <set>
+
+#include <boost/locale.hpp>
+
+#include <MPFDetectionException.h>
+
+#include "TagCache.h"
+#include "TagFileParser.h"
+#include "TagSetFile.h"
+
+using namespace MPF::COMPONENT;
+
+
+// Compiles a JSON tagging file into a tag set that the component loads without parsing the
+// file or building the literal automaton. Set TAGGING_FILE to the output file to use it.
+int main(int argc, char *argv[]) {
+    try {
+        if (argc != 3) {
+            std::cout << "Usage: " << argv[0] << " TAGGING_FILE OUTPUT_FILE" << std::endl;
+            return 1;
+        }
+
+        // Case fold the literals with the same locale as the component.
+        boost::locale::generator gen;
+        std::locale::global(gen(""));
+
+        auto tag_set = create_tag_set(read_tag_file(argv[1]));
+
+        // Report invalid regexes now. They are still included, and are reported by the jobs
+        // that use them, as when the tagging file is used directly.
+        std::set<const TagRegex *> regexes;
+        // The LiteralMatcher also holds the literals that regexes require.
+        std::set<int> literal_ids;
+        for (const auto &kv : tag_set->tags) {
+            for (const auto &tag_regex : kv.second) {
+                if (tag_regex->literal_id() >= 0) {
+                    literal_ids.insert(tag_regex->literal_id());
+                }
+                if (regexes.insert(tag_regex.get()).second && tag_regex->literal_id() < 0) {
+                    try {
+                        tag_regex->regex();
+                    } catch (const MPFDetectionException &ex) {
+                        std::cerr << "Warning: Invalid pattern for tag \""
+                                  << boost::locale::conv::utf_to_utf<char>(kv.first) << "\": "
+                                  << boost::locale::conv::utf_to_utf<char>(tag_regex->pattern()) << ": "
+                                  << ex.what() << std::endl;
+                    }
+                }
+            }
+        }
+
+        write_compiled_tag_set(*tag_set, argv[2]);
+        std::cout << "Compiled " << tag_set->tags.size() << " tags with " << regexes.size()
+                  << " distinct patterns, " << literal_ids.size() << " of them literals, to "
+                  << argv[2] << std::endl;
+        return 0;
+    }
+    catch (const std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
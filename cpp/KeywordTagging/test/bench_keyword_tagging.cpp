@@ -0,0 +1,348 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "KeywordTagging.h"
+#include "TagCache.h"
+#include "TagFileParser.h"
+#include "TagSetFile.h"
+
+// Tagging throughput and latency on a deterministic synthetic corpus, generated when the
+// benchmark starts, so it runs without any input files or network access. The text is
+// multilingual UTF-8 (English, Bulgarian, German, French, Greek, Chinese, and Arabic words)
+// with keywords, codes, and numbers mixed in for the generated tag files to find. Each tag
+// file has a given number of plain "\bkeyword<n>\b" literal patterns and of regex patterns.
+// Three in four of the regexes contain a literal every match needs, the others do not.
+// Throughput is reported as docs_per_second and bytes_per_second.
+//
+// Per-document latency of tagging a 2 KB text against 2,000 regex patterns, with the tag set
+// reloaded for every document (Cold) and served from the process-wide tag set cache (Cached),
+// against 2,000 literals (CachedLiterals), and against the 2,000 regexes grouped into tags of
+// 5, 20, and 100 patterns each (RegexesPerTag).
+//     ./bench_keyword_tagging --benchmark_filter=TagDocument
+//
+// Throughput of tagging text files of 4 KB to 1 MB, the arguments being the size in KB and
+// the numbers of literal and regex patterns in the tag file.
+//     ./bench_keyword_tagging --benchmark_filter=TagCorpus
+//
+// Latency of tagging a feed-forward video track of 200 detections whose text only changes
+// every given number of frames, as with OCR output, searched with 1 and with 4 threads.
+//     ./bench_keyword_tagging --benchmark_filter=TagVideoTrack
+//
+// Time to load a generated tag file with 200,000 patterns, without the cost of searching a
+// text, from the JSON file and from the same tag set compiled by keyword_tag_compiler. The
+// arguments are the numbers of literal and regex patterns.
+//     ./bench_keyword_tagging --benchmark_filter=LoadTagFile
+//
+// Corpus sizes and tag file sizes are changed by adding or editing the Args of a benchmark.
+
+using namespace MPF::COMPONENT;
+
+
+namespace {
+    constexpr int PATTERNS_PER_TAG = 20;
+    const std::string TAGGING_FILE = "./bench-text-tags.json";
+    const std::string COMPILED_TAGGING_FILE = "./bench-text-tags.ktags";
+    const std::string TEXT_FILE = "./bench-text.txt";
+
+
+    // Generates the synthetic text. std::mt19937 is used directly, rather than through the
+    // standard distributions, whose results differ between standard libraries, so the corpus
+    // is the same on every platform.
+    class CorpusGenerator {
+    public:
+        explicit CorpusGenerator(uint32_t seed = 42) : rng_(seed) {
+        }
+
+        // Returns size bytes of text, cut at a UTF-8 character boundary.
+        std::string text(size_t size) {
+            std::string text;
+            text.reserve(size + 64);
+            while (text.size() < size) {
+                text += sentence();
+            }
+            size_t end = size;
+            while (end > 0 && (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80) {
+                end--;
+            }
+            text.resize(end);
+            return text;
+        }
+
+        std::string sentence() {
+            std::string sentence;
+            size_t num_words = 4 + next(12);
+            for (size_t i = 0; i < num_words; i++) {
+                sentence += i == 0 ? "" : " ";
+                size_t kind = next(40);
+                if (kind == 0) {
+                    sentence += "keyword" + std::to_string(next(20000));
+                } else if (kind == 1) {
+                    sentence += "code" + std::to_string(next(2000)) + "-" + std::to_string(next(1000));
+                } else if (kind == 2) {
+                    sentence += "ref " + std::to_string(next(2000));
+                } else if (kind == 3) {
+                    sentence += std::to_string(100 + next(900)) + "-" + std::to_string(1000 + next(9000));
+                } else {
+                    const auto &words = VOCABULARY[next(VOCABULARY.size())];
+                    sentence += words[next(words.size())];
+                }
+            }
+            static const std::vector<std::string> ends = { ". ", ". ", "! ", "? ", ".\n", "; " };
+            return sentence + ends[next(ends.size())];
+        }
+
+    private:
+        static const std::vector<std::vector<std::string>> VOCABULARY;
+
+        std::mt19937 rng_;
+
+        size_t next(size_t n) {
+            return rng_() % n;
+        }
+    };
+
+    const std::vector<std::vector<std::string>> CorpusGenerator::VOCABULARY = {
+            {"the", "report", "vehicle", "airport", "meeting", "account", "border", "shipment", "contract",
+             "station", "morning", "people", "travel", "phone", "address", "number", "said", "was"},
+            {"свободни", "държава", "хора", "всички", "граница", "летище", "сметка", "договор", "среща",
+             "сутрин", "телефон", "адрес"},
+            {"Straße", "Grenze", "Flughafen", "Konto", "Vertrag", "Treffen", "müssen", "größer", "Bahnhof"},
+            {"frontière", "aéroport", "compte", "contrat", "réunion", "été", "déjà", "gare"},
+            {"σύνορα", "αεροδρόμιο", "λογαριασμός", "συμβόλαιο", "συνάντηση", "πρωί"},
+            {"边境", "机场", "账户", "合同", "会议", "早上", "电话", "地址"},
+            {"الحدود", "المطار", "الحساب", "العقد", "الاجتماع", "الصباح", "الهاتف"}
+    };
+
+
+    // Writes a tag file with num_literals plain "\bkeyword<n>\b" patterns and num_regexes regex
+    // patterns, spread evenly over tags of patterns_per_tag patterns.
+    void WriteTagFile(int num_literals, int num_regexes, int patterns_per_tag = PATTERNS_PER_TAG) {
+        std::ofstream out(TAGGING_FILE);
+        out << "{ \"TAGS_BY_REGEX\": {";
+        int num_patterns = num_literals + num_regexes;
+        int literal = 0, regex = 0;
+        for (int pattern = 0; pattern < num_patterns; pattern++) {
+            if (pattern % patterns_per_tag == 0) {
+                out << (pattern == 0 ? "" : "],") << "\n  \"tag-" << pattern / patterns_per_tag << "\": [";
+            } else {
+                out << ", ";
+            }
+            bool is_literal = static_cast<int64_t>(pattern + 1) * num_literals / num_patterns
+                    > static_cast<int64_t>(pattern) * num_literals / num_patterns;
+            if (is_literal) {
+                out << R"({"pattern": "\\bkeyword)" << literal++ << R"(\\b"})";
+                continue;
+            }
+            switch (regex % 4) {
+                case 0:
+                    out << R"({"pattern": "\\bcode)" << regex << R"(-[0-9]+\\b"})";
+                    break;
+                case 1:
+                    out << R"json({"pattern": "(\\b)ref(\\W+))json" << regex << R"json((\\b)"})json";
+                    break;
+                case 2:
+                    out << R"({"pattern": "\\bkeyword)" << regex << R"([0-9]?\\b", "caseSensitive": true})";
+                    break;
+                default:
+                    out << R"({"pattern": "\\b[0-9]{3}-)" << regex % 10 << R"([0-9]{3}\\b|id)" << regex << R"("})";
+                    break;
+            }
+            regex++;
+        }
+        out << (num_patterns == 0 ? "" : "]") << "\n} }";
+    }
+
+
+    std::string GenerateText(size_t size, uint32_t seed = 42) {
+        return CorpusGenerator(seed).text(size);
+    }
+
+
+    MPFImageJob CreateJob(const std::string &text) {
+        MPFImageLocation location(1, 2, 3, 4, 5, {{"TEXT", text}});
+        return { "Bench", "/some/path", location, {{"TAGGING_FILE", TAGGING_FILE}}, {} };
+    }
+
+
+    // A feed-forward track whose frames repeat the same OCR text for frames_per_text frames.
+    MPFVideoJob CreateVideoJob(int num_threads, int frames_per_text, size_t &total_size) {
+        CorpusGenerator generator;
+        MPFVideoTrack track(0, 199, 0.5, {});
+        std::string text;
+        total_size = 0;
+        for (int frame = 0; frame < 200; frame++) {
+            if (frame % frames_per_text == 0) {
+                text = generator.sentence() + generator.sentence();
+            }
+            total_size += text.size();
+            track.frame_locations.emplace(frame, MPFImageLocation(1, 2, 3, 4, 5, {{"TEXT", text}}));
+        }
+        return { "Bench", "/some/path", 0, 199, track,
+                 {{"TAGGING_FILE", TAGGING_FILE}, {"MAX_PARALLEL_TAGGING_THREADS", std::to_string(num_threads)}},
+                 {} };
+    }
+
+
+    void SetThroughput(benchmark::State &state, size_t bytes_per_iteration) {
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes_per_iteration));
+        state.counters["docs_per_second"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                               benchmark::Counter::kIsRate);
+    }
+
+
+    void TagDocument(benchmark::State &state, bool cached, int num_literals, int num_regexes,
+                     int patterns_per_tag = PATTERNS_PER_TAG) {
+        WriteTagFile(num_literals, num_regexes, patterns_per_tag);
+        KeywordTagging tagger;
+        tagger.SetRunDirectory("../plugin");
+        tagger.Init();
+        std::string text = GenerateText(2048);
+        MPFImageJob job = CreateJob(text);
+
+        for (auto _ : state) {
+            if (!cached) {
+                TagSetCache::clear();
+            }
+            benchmark::DoNotOptimize(tagger.GetDetections(job));
+        }
+        SetThroughput(state, text.size());
+        tagger.Close();
+    }
+
+
+    void BM_TagDocumentCold(benchmark::State &state) {
+        TagDocument(state, false, 0, 2000);
+    }
+    BENCHMARK(BM_TagDocumentCold)->Unit(benchmark::kMillisecond);
+
+
+    void BM_TagDocumentCached(benchmark::State &state) {
+        TagDocument(state, true, 0, 2000);
+    }
+    BENCHMARK(BM_TagDocumentCached)->Unit(benchmark::kMillisecond);
+
+
+    void BM_TagDocumentCachedLiterals(benchmark::State &state) {
+        TagDocument(state, true, 2000, 0);
+    }
+    BENCHMARK(BM_TagDocumentCachedLiterals)->Unit(benchmark::kMillisecond);
+
+
+    void BM_TagDocumentRegexesPerTag(benchmark::State &state) {
+        TagDocument(state, true, 0, 2000, state.range(0));
+    }
+    BENCHMARK(BM_TagDocumentRegexesPerTag)->Arg(5)->Arg(20)->Arg(100)->Unit(benchmark::kMillisecond);
+
+
+    void BM_TagCorpus(benchmark::State &state) {
+        WriteTagFile(state.range(1), state.range(2));
+        size_t size = state.range(0) * 1024;
+        {
+            std::ofstream out(TEXT_FILE, std::ios::binary);
+            out << GenerateText(size);
+        }
+        KeywordTagging tagger;
+        tagger.SetRunDirectory("../plugin");
+        tagger.Init();
+        MPFGenericJob job("Bench", TEXT_FILE, {{"TAGGING_FILE", TAGGING_FILE}}, {});
+
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(tagger.GetDetections(job));
+        }
+        SetThroughput(state, size);
+        tagger.Close();
+        std::remove(TEXT_FILE.c_str());
+    }
+    BENCHMARK(BM_TagCorpus)->ArgNames({"kb", "literals", "regexes"})
+            ->Args({4, 1000, 40})->Args({256, 1000, 40})->Args({1024, 1000, 40})
+            ->Args({256, 20000, 0})->Args({256, 0, 400})
+            ->Unit(benchmark::kMillisecond);
+
+
+    void BM_TagVideoTrack(benchmark::State &state) {
+        WriteTagFile(1000, 40);
+        KeywordTagging tagger;
+        tagger.SetRunDirectory("../plugin");
+        tagger.Init();
+        size_t total_size;
+        MPFVideoJob job = CreateVideoJob(state.range(0), state.range(1), total_size);
+
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(tagger.GetDetections(job));
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * total_size));
+        state.counters["frames_per_second"] = benchmark::Counter(static_cast<double>(state.iterations() * 200),
+                                                                 benchmark::Counter::kIsRate);
+        tagger.Close();
+    }
+    BENCHMARK(BM_TagVideoTrack)->ArgNames({"threads", "frames_per_text"})
+            ->Args({1, 20})->Args({4, 20})->Args({4, 1})
+            ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+
+    void LoadTagFile(benchmark::State &state, bool compiled) {
+        WriteTagFile(state.range(0), state.range(1), 100);
+        KeywordTagging tagger;
+        tagger.SetRunDirectory("../plugin");
+        tagger.Init();
+        MPFImageJob job = CreateJob(GenerateText(100));
+        if (compiled) {
+            write_compiled_tag_set(*create_tag_set(read_tag_file(TAGGING_FILE)), COMPILED_TAGGING_FILE);
+            job.job_properties["TAGGING_FILE"] = COMPILED_TAGGING_FILE;
+        }
+
+        for (auto _ : state) {
+            TagSetCache::clear();
+            benchmark::DoNotOptimize(tagger.GetDetections(job));
+        }
+        tagger.Close();
+    }
+
+
+    void BM_LoadTagFile(benchmark::State &state) {
+        LoadTagFile(state, false);
+    }
+    BENCHMARK(BM_LoadTagFile)->ArgNames({"literals", "regexes"})
+            ->Args({200000, 0})->Args({190000, 10000})->Unit(benchmark::kMillisecond);
+
+
+    void BM_LoadCompiledTagFile(benchmark::State &state) {
+        LoadTagFile(state, true);
+    }
+    BENCHMARK(BM_LoadCompiledTagFile)->ArgNames({"literals", "regexes"})
+            ->Args({200000, 0})->Args({190000, 10000})->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_MAIN();
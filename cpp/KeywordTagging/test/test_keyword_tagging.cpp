@@ -24,10 +24,18 @@
  * limitations under the License.                                             *
  ******************************************************************************/
 
+#include <cstdio>
+#include <fstream>
+
 #include <gtest/gtest.h>
 #include <log4cxx/basicconfigurator.h>
 
 #include "KeywordTagging.h"
+#include "LiteralMatcher.h"
+#include "RegexLiteral.h"
+#include "TagCache.h"
+#include "TagFileParser.h"
+#include "TagSetFile.h"
 
 using namespace MPF::COMPONENT;
 
@@ -982,3 +990,365 @@ TEST(KEYWORDTAGGING, SSNTest) {
     ASSERT_NO_FATAL_FAILURE(assertTextNotFound(tagger, "333-22-3333:k"));
     ASSERT_NO_FATAL_FAILURE(assertTextNotFound(tagger, "333-22-3333k:k"));
 }
+
+
+void writeTagFile(const std::string &path, const std::string &tags_by_regex) {
+    std::ofstream out(path);
+    out << "{ \"TAGS_BY_REGEX\": " << tags_by_regex << " }";
+}
+
+
+Properties tagText(KeywordTagging &tagger, const std::string &text, const std::string &tagging_file) {
+    MPFImageLocation location(1, 2, 3, 4, 5, {{"TEXT", text}});
+    MPFImageJob job("JOB NAME", "/some/path", location, {{"TAGGING_FILE", tagging_file}}, {});
+    return tagger.GetDetections(job).at(0).detection_properties;
+}
+
+
+TEST(KEYWORDTAGGING, TagFileCacheInvalidation) {
+    KeywordTagging tagger;
+    tagger.SetRunDirectory("../plugin");
+    ASSERT_TRUE(tagger.Init());
+
+    std::string tagging_file = "./cache-test-tags.json";
+    writeTagFile(tagging_file, R"json({ "vehicle": [ {"pattern": "(\\b)car(\\b)"} ] })json");
+    ASSERT_EQ("VEHICLE", tagText(tagger, "a red car", tagging_file)["TAGS"]);
+    // Served from the cache.
+    ASSERT_EQ("VEHICLE", tagText(tagger, "a blue car", tagging_file)["TAGS"]);
+
+    // Rewriting the file with a different size invalidates the cached tag set even if the
+    // modification time has a coarse resolution.
+    writeTagFile(tagging_file, R"json({ "color": [ {"pattern": "red"}, {"pattern": "Blue", "caseSensitive": true} ] })json");
+    Properties props = tagText(tagger, "a red car", tagging_file);
+    ASSERT_EQ("COLOR", props["TAGS"]);
+    ASSERT_EQ("red", props["TEXT COLOR TRIGGER WORDS"]);
+    ASSERT_EQ("", tagText(tagger, "a blue car", tagging_file)["TAGS"]);
+
+    // An invalid pattern is still only reported when a job reaches it.
+    writeTagFile(tagging_file, R"json({ "a": [ {"pattern": "car"} ], "b": [ {"pattern": "(car"} ] })json");
+    ASSERT_THROW(tagText(tagger, "car", tagging_file), MPFDetectionException);
+    ASSERT_THROW(tagText(tagger, "car", tagging_file), MPFDetectionException);
+
+    std::remove(tagging_file.c_str());
+    ASSERT_THROW(tagText(tagger, "car", tagging_file), MPFDetectionException);
+
+    ASSERT_TRUE(tagger.Close());
+}
+
+
+TEST(KEYWORDTAGGING, LiteralPatternsMatchLikeRegexes) {
+    KeywordTagging tagger;
+    tagger.SetRunDirectory("../plugin");
+    ASSERT_TRUE(tagger.Init());
+
+    LiteralMatcher matcher;
+    ASSERT_EQ(0, matcher.add(L"(\\b)car(\\b)", false));
+    ASSERT_EQ(0, matcher.add(L"(\\b)car(\\b)", false));
+    ASSERT_EQ(1, matcher.add(L"(\\b)car(\\b)", true));
+    ASSERT_EQ(2, matcher.add(L"U\\.S\\.", false));
+    ASSERT_EQ(-1, matcher.add(L"car\\d", false));
+    ASSERT_EQ(-1, matcher.add(L"cars?", false));
+    ASSERT_EQ(-1, matcher.add(L"car\\bs", false));
+    ASSERT_EQ(-1, matcher.add(L"\\b", false));
+
+    // Each pattern is a plain literal, so it is matched by the literal matcher. Wrapping it in a
+    // non-capturing group makes it a regex, which must produce exactly the same output.
+    std::vector<std::pair<std::string, bool>> patterns = {
+            {"aa", false},
+            {"(\\\\b)car(\\\\b)", false},
+            {"\\\\bCar", true},
+            {"bus\\\\b", false},
+            {"U\\\\.S\\\\.", false},
+            {"-\\\\b", false},
+            {"\\\\b-", false},
+            {"c\\\\+\\\\+", false},
+            {"свободни", false},
+            {"hello world", false}
+    };
+    std::vector<std::string> texts = {
+            "aaaaa car Car cars scar Car-car AA",
+            "bus busy abus U.S. u.s. us U.S.A. car-port -- a-b -a",
+            "C++ c++ c+++ Свободни свободни, СВОБОДНИ hello world Hello  world hello worlds"
+    };
+
+    std::string literal_file = "./literal-tags.json";
+    std::string regex_file = "./regex-tags.json";
+    for (const auto &pattern : patterns) {
+        std::string case_sensitive = pattern.second ? "true" : "false";
+        writeTagFile(literal_file, R"json({ "tag": [ {"pattern": ")json" + pattern.first
+                                   + R"json(", "caseSensitive": )json" + case_sensitive + "} ] }");
+        writeTagFile(regex_file, R"json({ "tag": [ {"pattern": "(?:)json" + pattern.first
+                                 + R"json()", "caseSensitive": )json" + case_sensitive + "} ] }");
+
+        for (const auto &text : texts) {
+            for (const std::string full_search : {"true", "false"}) {
+                MPFImageLocation location(1, 2, 3, 4, 5, {{"TEXT", text}});
+                MPFImageJob literal_job("JOB NAME", "/some/path", location,
+                                        {{"TAGGING_FILE", literal_file}, {"FULL_REGEX_SEARCH", full_search}}, {});
+                MPFImageJob regex_job("JOB NAME", "/some/path", location,
+                                      {{"TAGGING_FILE", regex_file}, {"FULL_REGEX_SEARCH", full_search}}, {});
+
+                ASSERT_EQ(tagger.GetDetections(regex_job).at(0).detection_properties,
+                          tagger.GetDetections(literal_job).at(0).detection_properties)
+                        << "pattern: " << pattern.first << ", text: " << text;
+            }
+        }
+    }
+    std::remove(literal_file.c_str());
+    std::remove(regex_file.c_str());
+
+    ASSERT_TRUE(tagger.Close());
+}
+
+
+TEST(KEYWORDTAGGING, RegexesAreSkippedWithoutRequiredLiteral) {
+    KeywordTagging tagger;
+    tagger.SetRunDirectory("../plugin");
+    ASSERT_TRUE(tagger.Init());
+
+    ASSERT_EQ(L"word", required_literal(L"(\\b)words?(\\b)"));
+    ASSERT_EQ(L"search", required_literal(L"(\\b)search(\\W+)this(\\b)"));
+    ASSERT_EQ(L"U\\.S\\.", required_literal(L"\\bU\\.S\\.\\d"));
+    ASSERT_EQ(L"cde", required_literal(L"ab+cdeg{0,2}"));
+    ASSERT_EQ(L"", required_literal(L"car|bus"));
+    ASSERT_EQ(L"", required_literal(L"(?i)car\\d"));
+    ASSERT_EQ(L"", required_literal(L"(car)\\1"));
+    ASSERT_EQ(L"", required_literal(L"\\d{3}-\\d{4}"));
+
+    std::string tagging_file = "./required-literal-tags.json";
+    writeTagFile(tagging_file, R"json({
+        "vehicle": [ {"pattern": "\\bcars?\\b"}, {"pattern": "\\bBus\\d*", "caseSensitive": true} ],
+        "number": [ {"pattern": "\\d+"} ]
+    })json");
+    for (const std::string full_search : {"true", "false"}) {
+        MPFImageLocation location(1, 2, 3, 4, 5, {{"TEXT", "2 CARS and a bus, 1 Bus42"}});
+        MPFImageJob job("JOB NAME", "/some/path", location,
+                        {{"TAGGING_FILE", tagging_file}, {"FULL_REGEX_SEARCH", full_search}}, {});
+        Properties props = tagger.GetDetections(job).at(0).detection_properties;
+        ASSERT_EQ("NUMBER; VEHICLE", props["TAGS"]);
+        if (full_search == "true") {
+            ASSERT_EQ("Bus42; CARS", props["TEXT VEHICLE TRIGGER WORDS"]);
+        } else {
+            ASSERT_EQ("CARS", props["TEXT VEHICLE TRIGGER WORDS"]);
+        }
+    }
+    ASSERT_EQ("", tagText(tagger, "a truck", tagging_file)["TAGS"]);
+
+    // An invalid pattern is reported even though its required literal is not in the text.
+    writeTagFile(tagging_file, R"json({ "vehicle": [ {"pattern": "truck{2,1}"} ] })json");
+    ASSERT_EQ(L"truck", required_literal(L"truck{2,1}"));
+    ASSERT_THROW(tagText(tagger, "a car", tagging_file), MPFDetectionException);
+
+    std::remove(tagging_file.c_str());
+
+    ASSERT_TRUE(tagger.Close());
+}
+
+
+TEST(KEYWORDTAGGING, InvalidUtf8IsSkipped) {
+    KeywordTagging tagger;
+    tagger.SetRunDirectory("../plugin");
+    ASSERT_TRUE(tagger.Init());
+
+    // Invalid UTF-8 sequences do not count towards the offsets.
+    std::string text = "caf\xff свободни car";
+    MPFImageLocation location(1, 2, 3, 4, 5, {{"TEXT", text}});
+    MPFImageJob job("JOB NAME", "/some/path", location, {}, {});
+    Properties props = tagger.GetDetections(job).at(0).detection_properties;
+    ASSERT_EQ(text, props["TEXT"]);
+    ASSERT_EQ("car", props["TEXT VEHICLE TRIGGER WORDS"]);
+    ASSERT_EQ("13-15", props["TEXT VEHICLE TRIGGER WORDS OFFSET"]);
+
+    // The rest of the file is still processed after an invalid sequence.
+    std::string file_path = "./invalid-utf8.txt";
+    {
+        std::ofstream out(file_path, std::ios::binary);
+        out << text;
+    }
+    std::vector<MPFGenericTrack> results;
+    ASSERT_NO_FATAL_FAILURE(runKeywordTagging(file_path, tagger, results, {{"TAGGING_FILE", "text-tags.json"}}));
+    ASSERT_EQ("caf свободни car", results.at(0).detection_properties.at("TEXT"));
+    ASSERT_EQ("13-15", results.at(0).detection_properties.at("TEXT VEHICLE TRIGGER WORDS OFFSET"));
+    std::remove(file_path.c_str());
+
+    ASSERT_TRUE(tagger.Close());
+}
+
+
+TEST(KEYWORDTAGGING, ChunkedSearchMatchesWholeText) {
+    KeywordTagging tagger;
+    tagger.SetRunDirectory("../plugin");
+    ASSERT_TRUE(tagger.Init());
+
+    std::string file_path = "./chunked-text.txt";
+    {
+        std::ifstream bulgarian("data/eng-bul.txt", std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(bulgarian)), std::istreambuf_iterator<char>());
+        text += "Call 555-1234 or (555) 555-1234 at 12:30 pm on January 5, 2020.\n"
+                "Email john@example.com or write to P.O. Box 123. SSN: 123-45-6789.\n"
+                "The car is parked at the airport; the visa is in the bank account.\n";
+        std::ofstream out(file_path, std::ios::binary);
+        for (int i = 0; i < 10; i++) {
+            out << text;
+        }
+    }
+
+    // Matches that cross the boundaries between chunks are found once, with the same offsets.
+    for (const std::string full_regex : {"true", "false"}) {
+        std::vector<MPFGenericTrack> expected;
+        ASSERT_NO_FATAL_FAILURE(runKeywordTagging(file_path, tagger, expected,
+                                                  {{"TAGGING_FILE", "text-tags.json"},
+                                                   {"FULL_REGEX_SEARCH", full_regex},
+                                                   {"TEXT_CHUNK_SIZE", "0"}}));
+        ASSERT_EQ("DATE; FINANCIAL; IDENTITY DOCUMENT; PERSONAL; TIME; TRAVEL; VEHICLE",
+                  expected.at(0).detection_properties.at("TAGS"));
+
+        for (const std::string chunk_size : {"1", "7", "100"}) {
+            std::vector<MPFGenericTrack> results;
+            ASSERT_NO_FATAL_FAILURE(runKeywordTagging(file_path, tagger, results,
+                                                      {{"TAGGING_FILE", "text-tags.json"},
+                                                       {"FULL_REGEX_SEARCH", full_regex},
+                                                       {"TEXT_CHUNK_SIZE", chunk_size}}));
+            ASSERT_EQ(expected.at(0).detection_properties, results.at(0).detection_properties)
+                                        << "TEXT_CHUNK_SIZE = " << chunk_size;
+        }
+    }
+    std::remove(file_path.c_str());
+
+    ASSERT_TRUE(tagger.Close());
+}
+
+
+TEST(KEYWORDTAGGING, RepeatedVideoTextIsSearchedInParallel) {
+    KeywordTagging tagger;
+    tagger.SetRunDirectory("../plugin");
+    ASSERT_TRUE(tagger.Init());
+
+    std::vector<std::string> texts = {"a car at the airport", "username", "   ", "nothing to see"};
+    MPFVideoTrack track(0, 59, 0.5, {{"TEXT", "username"}});
+    for (int frame = 0; frame < 60; frame++) {
+        Properties props = {{"TEXT", texts[frame / 5 % texts.size()]}};
+        if (frame % 7 == 0) {
+            props["TAGS"] = "earlier";
+        }
+        track.frame_locations.emplace(frame, MPFImageLocation(1, 2, 3, 4, 5, props));
+    }
+
+    MPFVideoJob serial_job("JOB NAME", "/some/path", 0, 100, track,
+                           {{"MAX_PARALLEL_TAGGING_THREADS", "1"}}, {});
+    std::vector<MPFVideoTrack> expected = tagger.GetDetections(serial_job);
+
+    MPFVideoJob parallel_job("JOB NAME", "/some/path", 0, 100, track,
+                             {{"MAX_PARALLEL_TAGGING_THREADS", "4"}}, {});
+    std::vector<MPFVideoTrack> results = tagger.GetDetections(parallel_job);
+
+    ASSERT_EQ(1, results.size());
+    ASSERT_EQ(expected.at(0).detection_properties, results.at(0).detection_properties);
+    ASSERT_EQ("PERSONAL", results.at(0).detection_properties.at("TAGS"));
+    for (int frame = 0; frame < 60; frame++) {
+        ASSERT_EQ(expected.at(0).frame_locations.at(frame).detection_properties,
+                  results.at(0).frame_locations.at(frame).detection_properties);
+    }
+
+    Properties props = results.at(0).frame_locations.at(0).detection_properties;
+    ASSERT_EQ("EARLIER; TRAVEL; VEHICLE", props["TAGS"]);
+    ASSERT_EQ("2-4", props["TEXT VEHICLE TRIGGER WORDS OFFSET"]);
+    props = results.at(0).frame_locations.at(12).detection_properties;
+    ASSERT_EQ("   ", props["TEXT"]);
+    ASSERT_EQ(0, props.count("TAGS"));
+
+    // Errors are still reported.
+    std::string tagging_file = "./parallel-error-tags.json";
+    writeTagFile(tagging_file, R"json({ "a": [ {"pattern": "(car"} ] })json");
+    MPFVideoJob error_job("JOB NAME", "/some/path", 0, 100, track,
+                          {{"TAGGING_FILE", tagging_file}}, {});
+    ASSERT_THROW(tagger.GetDetections(error_job), MPFDetectionException);
+    std::remove(tagging_file.c_str());
+
+    ASSERT_TRUE(tagger.Close());
+}
+
+
+std::string tagFileError(KeywordTagging &tagger, const std::string &tagging_file) {
+    try {
+        tagText(tagger, "car", tagging_file);
+    } catch (const MPFDetectionException &e) {
+        return e.what();
+    }
+    return "";
+}
+
+
+TEST(KEYWORDTAGGING, TagFileFormat) {
+    KeywordTagging tagger;
+    tagger.SetRunDirectory("../plugin");
+    ASSERT_TRUE(tagger.Init());
+
+    // Legacy string patterns, standard patterns, and escapes. Entries that are neither are
+    // ignored, and when a tag is listed twice the last entry is used.
+    std::string tagging_file = "./format-test-tags.json";
+    writeTagFile(tagging_file, R"json({
+        "vehicle": [ "(\\b)car(\\b)", {"pattern": "Bus", "caseSensitive": true}, 5, null, {"other": "van"} ],
+        "fruit": [ {"pattern": "apple"} ],
+        "fruit": [ {"pattern": "pêche"}, "kiwi\/lime" ]
+    })json");
+    Properties props = tagText(tagger, "a car, a bus, an apple, a pêche, kiwi/lime", tagging_file);
+    ASSERT_EQ("FRUIT; VEHICLE", props["TAGS"]);
+    ASSERT_EQ("car", props["TEXT VEHICLE TRIGGER WORDS"]);
+    ASSERT_EQ("kiwi/lime; pêche", props["TEXT FRUIT TRIGGER WORDS"]);
+
+    std::string prefix = "Could not parse tagging file: " + tagging_file;
+    writeTagFile(tagging_file, R"json({ "vehicle": [ "car", ] })json");
+    ASSERT_EQ(prefix, tagFileError(tagger, tagging_file));
+
+    writeTagFile(tagging_file, R"json({ "vehicle": [ {"pattern": 5} ] })json");
+    ASSERT_EQ(prefix, tagFileError(tagger, tagging_file));
+
+    writeTagFile(tagging_file, R"json({ "b": "car", "a": {"pattern": "car"}, "c": [] })json");
+    ASSERT_EQ(prefix + ". In TAGS_BY_REGEX the entry for \"a\" is not a valid JSON array.",
+              tagFileError(tagger, tagging_file));
+
+    writeTagFile(tagging_file, R"json([ "car" ])json");
+    ASSERT_EQ(prefix + ". TAGS_BY_REGEX not found.", tagFileError(tagger, tagging_file));
+
+    std::remove(tagging_file.c_str());
+    ASSERT_EQ("Could not open tagging file: " + tagging_file, tagFileError(tagger, tagging_file));
+
+    ASSERT_TRUE(tagger.Close());
+}
+
+
+TEST(KEYWORDTAGGING, CompiledTagSetMatchesTaggingFile) {
+    KeywordTagging tagger;
+    tagger.SetRunDirectory("../plugin");
+    ASSERT_TRUE(tagger.Init());
+
+    std::vector<std::string> texts = {
+            "a car at the airport at 12:30 pm on January 5, 2020",
+            "username: john@example.com, password: 123-45-6789, call (555) 555-1234",
+            "Всички хора се раждат свободни P.O. Box 123 bank account $100",
+            "nothing to see here"};
+    std::string compiled_file = "./compiled-tags.ktags";
+    for (std::string tagging_file : {"../plugin/KeywordTagging/config/text-tags.json",
+                                     "./config/test-text-tags-foreign.json"}) {
+        write_compiled_tag_set(*create_tag_set(read_tag_file(tagging_file)), compiled_file);
+        for (const auto &text : texts) {
+            ASSERT_EQ(tagText(tagger, text, tagging_file), tagText(tagger, text, compiled_file));
+        }
+    }
+    ASSERT_EQ("TRAVEL; VEHICLE", tagText(tagger, texts[0], compiled_file)["TAGS"]);
+
+    // Damaged files are reported.
+    std::ifstream in(compiled_file, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream(compiled_file, std::ios::binary) << data.substr(0, data.size() - 1);
+    ASSERT_THROW(tagText(tagger, texts[0], compiled_file), MPFDetectionException);
+
+    data[8]++;
+    std::ofstream(compiled_file, std::ios::binary) << data;
+    ASSERT_THROW(tagText(tagger, texts[0], compiled_file), MPFDetectionException);
+
+    std::remove(compiled_file.c_str());
+    ASSERT_TRUE(tagger.Close());
+}
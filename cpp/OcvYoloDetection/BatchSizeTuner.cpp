@@ -0,0 +1,229 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "BatchSizeTuner.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <opencv2/core/cuda.hpp>
+
+#include "Config.h"
+
+
+namespace {
+    constexpr int RUNS_PER_CANDIDATE = 2;
+
+    constexpr std::chrono::milliseconds GPU_MEMORY_SAMPLE_INTERVAL(5);
+
+
+    // cv::cuda only reports the memory in use on the whole device, so memory allocated by
+    // other processes on the same device is included.
+    long GetGpuMemoryUsageBytes(const cv::cuda::DeviceInfo &deviceInfo) {
+        return static_cast<long>(deviceInfo.totalMemory() - deviceInfo.freeMemory());
+    }
+
+
+    // Reads a memory field of /proc/self/status, such as VmRSS or VmHWM, in bytes.
+    long GetProcessMemoryBytes(const std::string &field) {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, field.size() + 1, field + ':') == 0) {
+                // The value is reported in kB.
+                return std::stol(line.substr(field.size() + 1)) * 1024;
+            }
+        }
+        return 0;
+    }
+
+
+    // Memory currently in use on the device the network runs on. For the CPU, this is the
+    // resident set size of the process.
+    long GetMemoryUsageBytes(int cudaDeviceId) {
+        if (cudaDeviceId >= 0) {
+            return GetGpuMemoryUsageBytes(cv::cuda::DeviceInfo(cudaDeviceId));
+        }
+        return GetProcessMemoryBytes("VmRSS");
+    }
+
+
+    // Resets the process's peak resident set size (VmHWM) to its current resident set size.
+    // Kernels older than 4.0 do not support this, in which case VmHWM keeps the peak since
+    // the process started, which can only overstate the memory used by a batch.
+    void ResetPeakResidentSetSize() {
+        std::ofstream("/proc/self/clear_refs") << '5';
+    }
+}
+
+
+// Polls the memory in use on a CUDA device on a background thread and keeps the maximum,
+// because memory allocated while a batch runs may be freed before the batch returns.
+class BatchSizeTuner::GpuMemorySampler {
+public:
+    explicit GpuMemorySampler(int cudaDeviceId)
+            : deviceInfo_(cudaDeviceId)
+            , peakBytes_(GetGpuMemoryUsageBytes(deviceInfo_))
+            , thread_([this] { run(); }) {
+    }
+
+    ~GpuMemorySampler() {
+        if (thread_.joinable()) {
+            stop();
+        }
+    }
+
+    /// stop sampling and return the most memory in use since the sampler was created
+    long stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        stoppedCv_.notify_one();
+        thread_.join();
+        return std::max(peakBytes_, GetGpuMemoryUsageBytes(deviceInfo_));
+    }
+
+private:
+    cv::cuda::DeviceInfo deviceInfo_;
+    std::mutex mutex_;
+    std::condition_variable stoppedCv_;
+    bool stopped_ = false;
+    long peakBytes_;
+    std::thread thread_;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stoppedCv_.wait_for(lock, GPU_MEMORY_SAMPLE_INTERVAL, [this] { return stopped_; })) {
+            peakBytes_ = std::max(peakBytes_, GetGpuMemoryUsageBytes(deviceInfo_));
+        }
+    }
+};
+
+
+BatchSizeTuner::BatchSizeTuner(int batchSize)
+        : batchSize_(batchSize) {
+}
+
+
+BatchSizeTuner::BatchSizeTuner(int maxBatchSize, long memoryLimitMB, int cudaDeviceId)
+        : memoryLimitBytes_(memoryLimitMB * 1024 * 1024)
+        , cudaDeviceId_(cudaDeviceId)
+        , baselineMemoryBytes_(GetMemoryUsageBytes(cudaDeviceId))
+        , batchSize_(1) {
+    for (int batchSize = 1; batchSize <= maxBatchSize; batchSize *= 2) {
+        candidates_.push_back(batchSize);
+    }
+}
+
+
+BatchSizeTuner::BatchSizeTuner(BatchSizeTuner &&other) noexcept = default;
+
+
+BatchSizeTuner::~BatchSizeTuner() = default;
+
+
+int BatchSizeTuner::getBatchSize() const {
+    return isTuning() ? candidates_[candidateIdx_] : batchSize_;
+}
+
+
+void BatchSizeTuner::startBatch() {
+    // Only the last run at each candidate is measured.
+    if (!isTuning() || runsAtCandidate_ + 1 < RUNS_PER_CANDIDATE) {
+        return;
+    }
+    if (cudaDeviceId_ >= 0) {
+        gpuMemorySampler_.reset();
+        gpuMemorySampler_ = std::make_unique<GpuMemorySampler>(cudaDeviceId_);
+    }
+    else {
+        ResetPeakResidentSetSize();
+    }
+}
+
+
+void BatchSizeTuner::recordBatch(int numFrames, std::chrono::steady_clock::duration elapsed) {
+    if (!isTuning()) {
+        return;
+    }
+    int batchSize = candidates_[candidateIdx_];
+    if (numFrames < batchSize) {
+        // The end of the video was reached, so the measurement is not comparable.
+        return;
+    }
+    if (++runsAtCandidate_ < RUNS_PER_CANDIDATE) {
+        return;
+    }
+
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    long memoryBytes = std::max(0L, getPeakMemoryUsageBytes() - baselineMemoryBytes_);
+    trials_.push_back({batchSize, numFrames / std::max(seconds, 1e-9), memoryBytes});
+    LOG_DEBUG("Batch size " << batchSize << " processed " << trials_.back().framesPerSec
+              << " frames/sec using up to " << memoryBytes / (1024 * 1024) << " MB");
+
+    runsAtCandidate_ = 0;
+    ++candidateIdx_;
+    // Memory use grows with the batch size, so there is no point trying larger sizes.
+    if (memoryLimitBytes_ > 0 && memoryBytes > memoryLimitBytes_) {
+        candidateIdx_ = candidates_.size();
+    }
+    if (!isTuning()) {
+        finishTuning();
+    }
+}
+
+
+// Most memory in use while the last batch ran. For the CPU, this is the peak resident set
+// size of the process since startBatch().
+long BatchSizeTuner::getPeakMemoryUsageBytes() {
+    if (cudaDeviceId_ < 0) {
+        return GetProcessMemoryBytes("VmHWM");
+    }
+    if (gpuMemorySampler_ == nullptr) {
+        return GetMemoryUsageBytes(cudaDeviceId_);
+    }
+    long peakBytes = gpuMemorySampler_->stop();
+    gpuMemorySampler_.reset();
+    return peakBytes;
+}
+
+
+void BatchSizeTuner::finishTuning() {
+    const Trial *best = nullptr;
+    for (const Trial &trial: trials_) {
+        bool withinLimit = memoryLimitBytes_ <= 0 || trial.peakMemoryBytes <= memoryLimitBytes_;
+        if (withinLimit && (best == nullptr || trial.framesPerSec > best->framesPerSec)) {
+            best = &trial;
+        }
+    }
+    batchSize_ = best == nullptr ? 1 : best->batchSize;
+    LOG_INFO("Selected detection frame batch size of " << batchSize_);
+}
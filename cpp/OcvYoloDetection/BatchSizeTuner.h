@@ -0,0 +1,91 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_BATCHSIZETUNER_H
+#define OPENMPF_COMPONENTS_BATCHSIZETUNER_H
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+
+/** ***************************************************************************
+*   Chooses the detection frame batch size for a video job. When tuning, the
+*   first batches of the job try increasing power of two batch sizes. Each
+*   size is run twice and only the second run is measured, since the first
+*   run at a new size includes the network reallocating its buffers. The
+*   size with the highest frame rate whose peak memory use is within the
+*   limit is used for the rest of the job.
+**************************************************************************** */
+class BatchSizeTuner {
+public:
+    /// always use the given batch size
+    explicit BatchSizeTuner(int batchSize);
+
+    /// try power of two batch sizes up to maxBatchSize
+    BatchSizeTuner(int maxBatchSize, long memoryLimitMB, int cudaDeviceId);
+
+    BatchSizeTuner(BatchSizeTuner &&other) noexcept;
+
+    ~BatchSizeTuner();
+
+    bool isTuning() const { return candidateIdx_ < candidates_.size(); }
+
+    /// batch size to use for the next batch
+    int getBatchSize() const;
+
+    /// start measuring the peak memory use of the next batch
+    void startBatch();
+
+    /// record how long it took to detect and track a batch of frames
+    void recordBatch(int numFrames, std::chrono::steady_clock::duration elapsed);
+
+private:
+    class GpuMemorySampler;
+
+    struct Trial {
+        int batchSize;
+        double framesPerSec;
+        long peakMemoryBytes;
+    };
+
+    std::vector<int> candidates_;
+    size_t candidateIdx_ = 0;
+    int runsAtCandidate_ = 0;
+    long memoryLimitBytes_ = 0;
+    int cudaDeviceId_ = -1;
+    long baselineMemoryBytes_ = 0;
+    std::unique_ptr<GpuMemorySampler> gpuMemorySampler_;
+    std::vector<Trial> trials_;
+    int batchSize_;
+
+    long getPeakMemoryUsageBytes();
+
+    void finishTuning();
+};
+
+
+#endif //OPENMPF_COMPONENTS_BATCHSIZETUNER_H
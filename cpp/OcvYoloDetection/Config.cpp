@@ -91,7 +91,15 @@ Config::Config(const Properties &jobProps)
                 GetProperty(jobProps, "TRITON_CONNECTION_SETUP_RETRY_INITIAL_DELAY", 5))
         , tritonVerboseClient(GetProperty(jobProps, "TRITON_VERBOSE_CLIENT", false))
         , tritonUseSSL(GetProperty(jobProps, "TRITON_USE_SSL", false))
-        , tritonUseShm(GetProperty(jobProps, "TRITON_USE_SHM", false)) {
+        , tritonUseShm(GetProperty(jobProps, "TRITON_USE_SHM", false))
+        , checkpointDirectory(GetProperty(jobProps, "CHECKPOINT_DIRECTORY", ""))
+        , checkpointFrameInterval(std::max(GetProperty(jobProps, "CHECKPOINT_FRAME_INTERVAL", 1000), 1))
+        , checkpointRetainOnCompletion(GetProperty(jobProps, "CHECKPOINT_RETAIN_ON_COMPLETION", false))
+        , autoTuneBatchSize(GetProperty(jobProps, "AUTO_TUNE_FRAME_BATCH_SIZE", false))
+        , autoTuneMaxBatchSize(std::max(GetProperty(jobProps, "AUTO_TUNE_MAX_FRAME_BATCH_SIZE", 32), 1))
+        , autoTuneMemoryLimitMB(GetProperty(jobProps, "AUTO_TUNE_MEMORY_LIMIT_MB", 4096))
+        , stageTimings(GetProperty(jobProps, "ENABLE_STAGE_TIMING", false)
+                       ? std::make_shared<StageTimings>() : nullptr) {
             std::string quality_property = GetProperty(jobProps, "QUALITY_SELECTION_PROPERTY", "CONFIDENCE");
             if (quality_property != "CONFIDENCE") {
                 throw MPFInvalidPropertyException("QUALITY_SELECTION_PROPERTY", "Unsupported quality selection property \"" + quality_property + "\". Only CONFIDENCE is supported for quality selection.");
@@ -134,6 +142,13 @@ std::ostream &operator<<(std::ostream &out, const Config &cfg) {
         << "\"tritonVerboseClient\":" << cfg.tritonVerboseClient << ","
         << "\"tritonUseSSL\":" << cfg.tritonUseSSL << ","
         << "\"tritonUseShm\":" << cfg.tritonUseShm << ","
+        << "\"checkpointDirectory\":" << cfg.checkpointDirectory << ","
+        << "\"checkpointFrameInterval\":" << cfg.checkpointFrameInterval << ","
+        << "\"checkpointRetainOnCompletion\":" << cfg.checkpointRetainOnCompletion << ","
+        << "\"autoTuneBatchSize\":" << cfg.autoTuneBatchSize << ","
+        << "\"autoTuneMaxBatchSize\":" << cfg.autoTuneMaxBatchSize << ","
+        << "\"autoTuneMemoryLimitMB\":" << cfg.autoTuneMemoryLimitMB << ","
+        << "\"stageTimingEnabled\":" << (cfg.stageTimings ? "1" : "0") << ","
         << "\"kfProcessVar\":" << format(cfg.QN) << ","
         << "\"kfMeasurementVar\":" << format(cfg.RN)
         << "}";
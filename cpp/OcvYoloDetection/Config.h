@@ -27,6 +27,7 @@
 #ifndef OPENMPF_COMPONENTS_CONFIG_H
 #define OPENMPF_COMPONENTS_CONFIG_H
 
+#include <memory>
 #include <ostream>
 #include <string>
 
@@ -35,6 +36,8 @@
 
 #include <MPFDetectionObjects.h>
 
+#include "StageTimings.h"
+
 
 
 /** ****************************************************************************
@@ -156,6 +159,25 @@ public:
     /// use shared memory for client-server communication
     bool tritonUseShm;
 
+    /// directory in which video tracking checkpoints are stored (empty disables checkpointing)
+    std::string checkpointDirectory;
+
+    /// minimum number of frames processed between video tracking checkpoints
+    long checkpointFrameInterval;
+
+    /// keep the last checkpoint after the job completes successfully
+    bool checkpointRetainOnCompletion;
+
+    /// choose the detection frame batch size by measuring throughput at the start of the job
+    bool autoTuneBatchSize;
+    /// largest detection frame batch size tried when auto-tuning
+    int autoTuneMaxBatchSize;
+    /// peak memory limit in MB for the auto-tuned batch size (0 for no limit)
+    long autoTuneMemoryLimitMB;
+
+    /// per-stage latency histograms, null unless stage timing is enabled
+    std::shared_ptr<StageTimings> stageTimings;
+
     /// shared log object
     static const log4cxx::LoggerPtr log;
 
@@ -45,7 +45,8 @@ DetectionLocation::DetectionLocation(const Config &config,
                                      cv::Mat classFeature,
                                      cv::Mat dftFeature)
         : frame(std::move(frame)), dftSize_(config.dftSize), dftHanningWindowEnabled_(config.dftHannWindowEnabled),
-          edgeSnapDist_(config.edgeSnapDist), classFeature_(std::move(classFeature)),
+          edgeSnapDist_(config.edgeSnapDist), stageTimings_(config.stageTimings.get()),
+          classFeature_(std::move(classFeature)),
           dftFeature_(std::move(dftFeature)) {
     this->confidence = confidence;
     setRect(boundingBox & cv::Rect2d(0, 0, DetectionLocation::frame.data.cols,
@@ -165,14 +166,76 @@ float DetectionLocation::featureDist(Track &track) {
 
 
 /** **************************************************************************
-* Compute Kalman distance (error from predicted) to track's tail detection's
+* Compute Kalman distance (error from predicted) to track's tail detection's.
+* The track memoizes the result for the rest of the frame.
 *
 * \param   track track
 * \returns distance
 *
 *************************************************************************** */
 float DetectionLocation::kfResidualDist(const Track &track) const {
-    return track.testResidual(getRect(), edgeSnapDist_);
+    return track.kfResidual(*this, edgeSnapDist_);
+}
+
+
+/** **************************************************************************
+* Write the location to a checkpoint. The frame image data is not written
+* since it is shared by all of the locations from the same frame.
+*
+* \param fs              open file storage positioned inside a map
+* \param includeFeatures if true also write class and dft features
+*
+*************************************************************************** */
+void DetectionLocation::write(cv::FileStorage &fs, bool includeFeatures) const {
+    fs << "frameIdx" << static_cast<int>(frame.idx)
+       << "time" << frame.time
+       << "timeStep" << frame.timeStep
+       << "rect" << getRect()
+       << "confidence" << confidence;
+    writeProperties(fs, "properties", detection_properties);
+    if (includeFeatures) {
+        fs << "classFeature" << classFeature_
+           << "dftFeature" << dftFeature_;
+    }
+}
+
+
+/** **************************************************************************
+* Restore a location written with DetectionLocation::write
+*
+* \param node      file node containing the location
+* \param config    job configuration
+* \param frameData image data for the location's frame, empty if released
+*
+* \returns restored location
+*
+*************************************************************************** */
+DetectionLocation DetectionLocation::read(const cv::FileNode &node, const Config &config,
+                                         cv::Mat frameData) {
+    cv::Mat classFeature;
+    cv::Mat dftFeature;
+    node["classFeature"] >> classFeature;
+    node["dftFeature"] >> dftFeature;
+
+    DetectionLocation location(config,
+                               Frame(static_cast<int>(node["frameIdx"]),
+                                     static_cast<double>(node["time"]),
+                                     static_cast<double>(node["timeStep"]),
+                                     std::move(frameData)),
+                               cv::Rect2d(),
+                               static_cast<float>(node["confidence"]),
+                               std::move(classFeature),
+                               std::move(dftFeature));
+
+    // Rectangle was already clipped and snapped when it was written.
+    cv::Rect2i rect;
+    node["rect"] >> rect;
+    location.x_left_upper = rect.x;
+    location.y_left_upper = rect.y;
+    location.width = rect.width;
+    location.height = rect.height;
+    location.detection_properties = readProperties(node["properties"]);
+    return location;
 }
 
 
@@ -239,6 +302,7 @@ cv::Mat DetectionLocation::getDFTFeature() {
     if (!dftFeature_.empty()) {
         return dftFeature_;
     }
+    ScopedStageTimer timer(stageTimings_, StageTimings::DFT_FEATURES);
 
     // make normalized grayscale float image
     cv::Mat gray;
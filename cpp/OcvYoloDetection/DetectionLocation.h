@@ -44,6 +44,9 @@ public:
     /// frame associated with detection
     Frame frame;
 
+    /// index of the detection within its frame, used by tracks to memoize residuals (-1 if unset)
+    int frameDetectionIdx = -1;
+
     DetectionLocation(const Config &config,
                       Frame frame,
                       const cv::Rect2d &boundingBox,
@@ -80,10 +83,17 @@ public:
     /// get bbox alignment via phase correlation
     cv::Point2d phaseCorrelate(Track &tr);
 
+    /// write location fields to a checkpoint, features are only needed for track tails
+    void write(cv::FileStorage &fs, bool includeFeatures) const;
+
+    /// restore a location written with write(), using the given image data for its frame
+    static DetectionLocation read(const cv::FileNode &node, const Config &config, cv::Mat frameData);
+
 private:
     int dftSize_;
     bool dftHanningWindowEnabled_;
     float edgeSnapDist_;
+    StageTimings *stageTimings_;
 
     /// unit vector of with elements proportional to scores for each classes
     cv::Mat classFeature_;
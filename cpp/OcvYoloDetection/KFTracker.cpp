@@ -424,6 +424,53 @@ KFTracker::KFTracker(const float t,
 #endif
 }
 
+/** **************************************************************************
+ * Restore a Kalman filter tracker from a checkpoint
+ *
+ * \param node file node containing state written by KFTracker::write
+ *
+*************************************************************************** */
+KFTracker::KFTracker(const cv::FileNode &node) :
+        _kf(KF_STATE_DIM, KF_MEAS_DIM, KF_CTRL_DIM, CV_32F),
+        _t(static_cast<float>(node["t"])),
+        _dt(static_cast<float>(node["dt"]))
+{
+    node["roi"] >> _roi;
+    node["qn"] >> _qn;
+    node["statePre"] >> _kf.statePre;
+    node["statePost"] >> _kf.statePost;
+    node["transitionMatrix"] >> _kf.transitionMatrix;
+    node["measurementMatrix"] >> _kf.measurementMatrix;
+    node["processNoiseCov"] >> _kf.processNoiseCov;
+    node["measurementNoiseCov"] >> _kf.measurementNoiseCov;
+    node["errorCovPre"] >> _kf.errorCovPre;
+    node["errorCovPost"] >> _kf.errorCovPost;
+    node["gain"] >> _kf.gain;
+}
+
+/** **************************************************************************
+ * Write the complete filter state so that a restored filter produces exactly
+ * the same predictions and corrections as this one
+ *
+ * \param fs open file storage positioned inside a map
+ *
+*************************************************************************** */
+void KFTracker::write(cv::FileStorage &fs) const {
+    fs << "t" << _t
+       << "dt" << _dt
+       << "roi" << _roi
+       << "qn" << _qn
+       << "statePre" << _kf.statePre
+       << "statePost" << _kf.statePost
+       << "transitionMatrix" << _kf.transitionMatrix
+       << "measurementMatrix" << _kf.measurementMatrix
+       << "processNoiseCov" << _kf.processNoiseCov
+       << "measurementNoiseCov" << _kf.measurementNoiseCov
+       << "errorCovPre" << _kf.errorCovPre
+       << "errorCovPost" << _kf.errorCovPost
+       << "gain" << _kf.gain;
+}
+
 #include <fstream>
 
 /** **************************************************************************
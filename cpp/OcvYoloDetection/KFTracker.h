@@ -58,6 +58,8 @@ public:
               const cv::Mat1f &rn,
               const cv::Mat1f &qn);
 
+    explicit KFTracker(const cv::FileNode &node);  ///< restore filter written with write()
+
     KFTracker(KFTracker &&kft): _kf(std::move(kft._kf)),
                                 _t(kft._t),
                                 _dt(kft._dt),
@@ -65,6 +67,8 @@ public:
                                 _qn(std::move(kft._qn)),
                                 _state_trace(kft._state_trace.str()) {}
 
+    void write(cv::FileStorage &fs) const;  ///< write complete filter state to a checkpoint
+
     // diagnostic output function for debug/tuning
     void dump(const std::string& filename);
     friend std::ostream &operator<<(std::ostream &out, const KFTracker &kft);
@@ -24,6 +24,7 @@
  * limitations under the License.                                             *
  ******************************************************************************/
 
+#include <chrono>
 #include <functional>
 #include <list>
 #include <stdexcept>
@@ -37,22 +38,53 @@
 #include <MPFImageReader.h>
 #include <Utils.h>
 
-#include "Cluster.h"
 #include "Config.h"
 #include "DetectionLocation.h"
 #include "Track.h"
+#include "Tracking.h"
+#include "TrackingCheckpoint.h"
 #include "OcvYoloDetection.h"
 
 using namespace MPF::COMPONENT;
 using DetectionComponentUtils::GetProperty;
 
 namespace {
-    std::vector<Frame> GetVideoFrames(MPFAsyncVideoCapture &videoCapture, int numFrames) {
+    // Stage latencies are added to the first detection or track, since there is no job level
+    // output for them. They are always logged in case there are no results.
+    void ReportStageTimings(const Config &config, Properties *firstResultProperties,
+                            const log4cxx::LoggerPtr &logger) {
+        if (!config.stageTimings) {
+            return;
+        }
+        LOG4CXX_INFO(logger, "Stage latencies:" << config.stageTimings->toString());
+        if (firstResultProperties != nullptr) {
+            config.stageTimings->addSummaryProperties(*firstResultProperties);
+        }
+    }
+
+
+    // Batch size tuning results only carry over to jobs that run the same model the same way.
+    std::string GetBatchSizeTuningKey(const Properties &jobProperties, const Config &config) {
+        return GetProperty(jobProperties, "MODELS_DIR_PATH", ".") + '|'
+               + GetProperty(jobProperties, "MODEL_NAME", "tiny yolo") + '|'
+               + std::to_string(config.netInputImageSize) + '|'
+               + std::to_string(config.cudaDeviceId) + '|'
+               + std::to_string(config.autoTuneMaxBatchSize) + '|'
+               + std::to_string(config.autoTuneMemoryLimitMB);
+    }
+
+
+    std::vector<Frame> GetVideoFrames(MPFAsyncVideoCapture &videoCapture, int numFrames,
+                                      StageTimings *stageTimings) {
         double fps = videoCapture.GetFrameRate();
         std::vector<Frame> frames;
         frames.reserve(numFrames);
         for (int i = 0; i < numFrames; i++) {
-            if (auto optMpfFrame = videoCapture.Read()) {
+            auto optMpfFrame = [&] {
+                ScopedStageTimer timer(stageTimings, StageTimings::DECODE);
+                return videoCapture.Read();
+            }();
+            if (optMpfFrame) {
                 double time = optMpfFrame->index / fps;
                 frames.emplace_back(optMpfFrame->index, time, 1 / fps,
                                     std::move(optMpfFrame->data));
@@ -64,161 +96,12 @@ namespace {
     }
 
 
-    std::vector<Track> AssignDetections(
-            std::vector<Cluster<Track>> &trackClusters,
-            std::vector<Cluster<DetectionLocation>> &detectionClusters,
-            const Config &config) {
-
-        // tracks that were assigned a detection in the current frame
-        std::vector<Track> assignedTracks;
-        if (config.maxIOUDist > 0) {
-            // intersection over union tracking and assignment
-            Track::assignDetections(trackClusters,
-                                    detectionClusters,
-                                    assignedTracks,
-                                    config.maxIOUDist,
-                                    config.maxClassDist,
-                                    config.maxKFResidual,
-                                    config.edgeSnapDist,
-                                    std::mem_fn(&DetectionLocation::iouDist),
-                                    "IoU",
-                                    config.enableDebug);
-            LOG_TRACE("IOU assignment complete");
-        }
-
-        if (config.maxFeatureDist > 0) {
-            // feature-based tracking and assignment
-            Track::assignDetections(trackClusters,
-                                    detectionClusters,
-                                    assignedTracks,
-                                    config.maxFeatureDist,
-                                    config.maxClassDist,
-                                    config.maxKFResidual,
-                                    config.edgeSnapDist,
-                                    std::mem_fn(&DetectionLocation::featureDist),
-                                    "DFT",
-                                    config.enableDebug);
-            LOG_TRACE("Feature assignment complete");
-        }
-
-        if (config.maxCenterDist > 0) {
-            // center-to-center distance tracking and assignment
-            Track::assignDetections(trackClusters,
-                                    detectionClusters,
-                                    assignedTracks,
-                                    config.maxCenterDist,
-                                    config.maxClassDist,
-                                    config.maxKFResidual,
-                                    config.edgeSnapDist,
-                                    std::mem_fn(&DetectionLocation::center2CenterDist),
-                                    "C2C",
-                                    config.enableDebug);
-            LOG_TRACE("Center2Center assignment complete");
-        }
-        return assignedTracks;
-    }
-
-
-    void ExtendWithOcvTracker(const Config &config, const Frame &frame,
-                              Cluster<Track> &trackCluster) {
-        if (config.mosseTrackerDisabled) {
-            return;
-        }
-        // tracks leftover have no detections in current frame, try tracking
-        for (auto &track: trackCluster.members) {
-            cv::Rect2i predictedRect;
-            bool ocvTrackingSuccessful = track.ocvTrackerPredict(frame, config.maxFrameGap,
-                                                                 predictedRect);
-            if (!ocvTrackingSuccessful ||
-                track.testResidual(predictedRect, config.edgeSnapDist) > config.maxKFResidual) {
-                continue;
-            }
-
-            float previousConfidence = track.back().confidence;
-            auto previousProps = track.back().detection_properties;
-            constexpr float gapFillPenalty = 0.00001;
-            track.add({
-                              config, frame, predictedRect,
-                              // Slightly lower confidence to make sure this detection is never chosen as the exemplar.
-                              previousConfidence - gapFillPenalty,
-                              track.back().getClassFeature(),
-                              track.back().getDFTFeature()});
-            track.back().detection_properties = std::move(previousProps);
-            track.back().detection_properties.emplace("FILLED_GAP", "TRUE");
-            track.kalmanCorrect(config.edgeSnapDist);
-        }
-    }
-
-
-    void ProcessFrameDetections(
-            const Config &config,
-            const Frame &frame,
-            std::vector<DetectionLocation> &&detections,
-            std::vector<Track> &inProgressTracks,
-            std::vector<MPFVideoTrack> &completedTracks) {
-
-        LOG_TRACE(detections.size() << " detections to be matched to " << inProgressTracks.size()
-                                    << " tracks");
-
-        // group detections according to class features
-        std::vector<Cluster<DetectionLocation>> detectionClusterList
-                = clusterItems(std::move(detections), config.maxClassDist);
-
-        // group tracks according to class features
-        std::vector<Cluster<Track>> trackClusterList
-                = clusterItems(std::move(inProgressTracks), config.maxClassDist);
-        inProgressTracks.clear();
-
-        // tracks that were assigned a detection in the current frame
-        std::vector<Track> assignedTracks
-                = AssignDetections(trackClusterList, detectionClusterList, config);
-
-        // any detection not assigned up to this point becomes a new track
-        for (auto &detectionCluster: detectionClusterList) {
-            // make any unassigned detections into new tracks
-            for (auto &detection: detectionCluster.members) {
-                // start of tracks always get feature calculated
-                detection.getDFTFeature();
-                // create new track
-                assignedTracks.emplace_back();
-                if (!config.kfDisabled) {
-                    // initialize Kalman tracker
-                    assignedTracks.back().kalmanInit(detection.frame.time,
-                                                     detection.frame.timeStep,
-                                                     detection.getRect(),
-                                                     detection.frame.getRect(),
-                                                     config.RN, config.QN);
-                }
-                // add first detection to track
-                assignedTracks.back().add(std::move(detection));
-                LOG_TRACE("Created new track " << assignedTracks.back());
-
-            }
-        }
-
-        for (auto &trackCluster: trackClusterList) {
-            // check any tracks that didn't get a detection and use tracker to continue them if possible
-            ExtendWithOcvTracker(config, frame, trackCluster);
-            // move tracks with no new detections to assigned tracks
-            assignedTracks.insert(assignedTracks.end(),
-                                  std::make_move_iterator(trackCluster.members.begin()),
-                                  std::make_move_iterator(trackCluster.members.end()));
-        }
-
-        for (auto &track: assignedTracks) {
-            auto gapSize = frame.idx - track.back().frame.idx;
-            if (gapSize > config.maxFrameGap) {
-                // remove and convert any tracks too far in the past from the active list
-                completedTracks.push_back(Track::toMpfTrack(std::move(track)));
-            } else {
-                inProgressTracks.push_back(std::move(track));
-            }
-        }
-
-        // advance Kalman predictions
-        if (!config.kfDisabled) {
-            for (auto &track: inProgressTracks) {
-                track.kalmanPredict(frame.time, config.edgeSnapDist);
+    // Frames up to and including lastFrameIdx were already tracked before the checkpoint
+    // was saved. They still need to be decoded since the capture can only move forward.
+    void SkipVideoFrames(MPFAsyncVideoCapture &videoCapture, long lastFrameIdx) {
+        while (auto optMpfFrame = videoCapture.Read()) {
+            if (optMpfFrame->index >= lastFrameIdx) {
+                break;
             }
         }
     }
@@ -245,6 +128,22 @@ bool OcvYoloDetection::Close() {
 }
 
 
+BatchSizeTuner OcvYoloDetection::CreateBatchSizeTuner(const std::string &tuningKey,
+                                                     const Config &config) const {
+    if (!config.autoTuneBatchSize) {
+        return BatchSizeTuner(config.frameBatchSize);
+    }
+    auto tunedBatchSizeIter = tunedBatchSizes_.find(tuningKey);
+    if (tunedBatchSizeIter != tunedBatchSizes_.end()) {
+        LOG4CXX_INFO(logger_, "Using previously tuned detection frame batch size of "
+                << tunedBatchSizeIter->second);
+        return BatchSizeTuner(tunedBatchSizeIter->second);
+    }
+    return BatchSizeTuner(config.autoTuneMaxBatchSize, config.autoTuneMemoryLimitMB,
+                          config.cudaDeviceId);
+}
+
+
 void OcvYoloDetection::InitYoloNetwork(const Properties &jobProperties, const Config &config) {
     auto modelName = GetProperty(jobProperties, "MODEL_NAME", "tiny yolo");
     auto modelsDirPath = GetProperty(jobProperties, "MODELS_DIR_PATH", ".");
@@ -268,7 +167,10 @@ std::vector<MPFImageLocation> OcvYoloDetection::GetDetections(const MPFImageJob
         Config config(job.job_properties);
         InitYoloNetwork(job.job_properties, config);
 
-        MPFImageReader imageReader(job);
+        MPFImageReader imageReader = [&] {
+            ScopedStageTimer timer(config.stageTimings.get(), StageTimings::DECODE);
+            return MPFImageReader(job);
+        }();
         std::vector<MPFImageLocation> results;
         std::vector<Frame> frameBatch = {Frame(imageReader.GetImage())};
         frameBatch.front().idx = 0;
@@ -299,6 +201,9 @@ std::vector<MPFImageLocation> OcvYoloDetection::GetDetections(const MPFImageJob
 
         yoloNetwork_->Finish();
 
+        ReportStageTimings(config,
+                           results.empty() ? nullptr : &results.front().detection_properties,
+                           logger_);
         LOG4CXX_INFO(logger_, "Found " << results.size() << " detections.");
         return results;
     }
@@ -322,22 +227,40 @@ std::vector<MPFVideoTrack> OcvYoloDetection::GetDetections(const MPFVideoJob &jo
             config.mosseTrackerDisabled = true;
             LOG_WARN("MOSSE tracker is not supported with Triton, and has been disabled for this job");
         }
+        if (config.tritonEnabled && config.autoTuneBatchSize) {
+            // Triton requests are asynchronous, so batch times can not be measured here.
+            config.autoTuneBatchSize = false;
+            LOG_WARN("Batch size auto-tuning is not supported with Triton, and has been disabled for this job");
+        }
 
         InitYoloNetwork(job.job_properties, config);
 
+        std::string batchSizeTuningKey = GetBatchSizeTuningKey(job.job_properties, config);
+        BatchSizeTuner batchSizeTuner = CreateBatchSizeTuner(batchSizeTuningKey, config);
+
+        TrackingCheckpoint checkpoint(job, config);
+        long checkpointFrameIdx = checkpoint.restore(config, inProgressTracks, completedTracks);
+
         MPFAsyncVideoCapture videoCapture(job);
+        if (checkpointFrameIdx >= 0) {
+            SkipVideoFrames(videoCapture, checkpointFrameIdx);
+        }
 
         // place to hold frames till callbacks are done
         std::unordered_map<int, std::vector<Frame>> frameBatches;
 
         while (true) {
-            auto tmp = GetVideoFrames(videoCapture, config.frameBatchSize);
+            auto tmp = GetVideoFrames(videoCapture, batchSizeTuner.getBatchSize(),
+                                      config.stageTimings.get());
 
             if (tmp.empty()) {
                 break;
             }
 
             int frameBatchKey = tmp.back().idx;
+            int numFrames = tmp.size();
+            batchSizeTuner.startBatch();
+            auto batchStartTime = std::chrono::steady_clock::now();
             frameBatches.insert(std::make_pair(frameBatchKey, std::move(tmp)));
 
             LOG_TRACE("Processing frames [" << frameBatches.at(frameBatchKey).front().idx << "..."
@@ -348,7 +271,8 @@ std::vector<MPFVideoTrack> OcvYoloDetection::GetDetections(const MPFVideoJob &jo
 
                                         // LAMBDA: This callback performs tracking on the frame detections using the
                                         // corresponding Frame objects, which contain the cv::Mat data.
-                                        [&config, &frameBatches, &inProgressTracks, &completedTracks, frameBatchKey]
+                                        [&config, &frameBatches, &inProgressTracks, &completedTracks, &checkpoint,
+                                         frameBatchKey]
                                                 (std::vector<std::vector<DetectionLocation>> &&detectionsVec,
                                                  std::vector<Frame>::const_iterator begin,
                                                  std::vector<Frame>::const_iterator end) {
@@ -361,6 +285,8 @@ std::vector<MPFVideoTrack> OcvYoloDetection::GetDetections(const MPFVideoJob &jo
                                                                        inProgressTracks,
                                                                        completedTracks);
                                             }
+                                            checkpoint.update(backFrameIdx, inProgressTracks,
+                                                              completedTracks);
 
                                             // last frame in batch, release frame batch
                                             if (frameBatchKey == backFrameIdx) {
@@ -369,9 +295,12 @@ std::vector<MPFVideoTrack> OcvYoloDetection::GetDetections(const MPFVideoJob &jo
                                         },
 
                                         config);
+
+            batchSizeTuner.recordBatch(numFrames, std::chrono::steady_clock::now() - batchStartTime);
         }
 
         yoloNetwork_->Finish();
+        checkpoint.finish();
 
         assert(("All frame batches should have been processed.", frameBatches.empty()));
 
@@ -414,6 +343,18 @@ std::vector<MPFVideoTrack> OcvYoloDetection::GetDetections(const MPFVideoJob &jo
             completedTracks.erase(it);
         }
 
+        if (config.autoTuneBatchSize && !batchSizeTuner.isTuning()) {
+            tunedBatchSizes_[batchSizeTuningKey] = batchSizeTuner.getBatchSize();
+            if (!completedTracks.empty()) {
+                completedTracks.front().detection_properties.emplace(
+                        "DETECTION FRAME BATCH SIZE", std::to_string(batchSizeTuner.getBatchSize()));
+            }
+        }
+
+        ReportStageTimings(config,
+                           completedTracks.empty()
+                           ? nullptr : &completedTracks.front().detection_properties,
+                           logger_);
         LOG4CXX_INFO(logger_, "Found " << completedTracks.size() << " tracks.");
 
         return completedTracks;
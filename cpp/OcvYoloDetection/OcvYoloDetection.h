@@ -31,6 +31,7 @@
 #include <memory>
 #include <list>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <log4cxx/logger.h>
@@ -38,6 +39,7 @@
 #include <adapters/MPFImageAndVideoDetectionComponentAdapter.h>
 #include <ModelsIniParser.h>
 
+#include "BatchSizeTuner.h"
 #include "Config.h"
 #include "yolo_network/YoloNetwork.h"
 
@@ -62,7 +64,12 @@ private:
 
     std::unique_ptr<YoloNetwork> yoloNetwork_;
 
+    /// auto-tuned detection frame batch sizes keyed by model and hardware settings
+    std::unordered_map<std::string, int> tunedBatchSizes_;
+
     void InitYoloNetwork(const MPF::COMPONENT::Properties &jobProperties, const Config &config);
+
+    BatchSizeTuner CreateBatchSizeTuner(const std::string &tuningKey, const Config &config) const;
 };
 
 #endif //OPENMPF_COMPONENTS_OCVYOLODETECTION_H
@@ -0,0 +1,169 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "StageTimings.h"
+
+#include <sstream>
+
+using namespace MPF::COMPONENT;
+
+
+namespace {
+    const char *GetStageName(StageTimings::Stage stage) {
+        switch (stage) {
+            case StageTimings::DECODE:
+                return "DECODE";
+            case StageTimings::PREPROCESS:
+                return "PREPROCESS";
+            case StageTimings::FORWARD:
+                return "FORWARD";
+            case StageTimings::POSTPROCESS:
+                return "POSTPROCESS";
+            case StageTimings::DFT_FEATURES:
+                return "DFT FEATURES";
+            case StageTimings::ASSIGNMENT:
+                return "ASSIGNMENT";
+            case StageTimings::KALMAN:
+                return "KALMAN";
+            default:
+                return "UNKNOWN";
+        }
+    }
+
+
+    int GetBucketIdx(uint64_t microseconds, int numBuckets) {
+        int bucketIdx = 0;
+        while (microseconds > 0 && bucketIdx < numBuckets - 1) {
+            microseconds >>= 1;
+            ++bucketIdx;
+        }
+        return bucketIdx;
+    }
+}
+
+
+StageTimings::StageTimings() {
+    for (Histogram &histogram: histograms_) {
+        histogram.count = 0;
+        histogram.totalUs = 0;
+        histogram.maxUs = 0;
+        for (auto &bucket: histogram.buckets) {
+            bucket = 0;
+        }
+    }
+}
+
+
+void StageTimings::record(Stage stage, std::chrono::steady_clock::duration elapsed) {
+    uint64_t microseconds
+            = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    Histogram &histogram = histograms_[stage];
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    histogram.totalUs.fetch_add(microseconds, std::memory_order_relaxed);
+    histogram.buckets[GetBucketIdx(microseconds, NUM_BUCKETS)]
+            .fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t currentMax = histogram.maxUs.load(std::memory_order_relaxed);
+    while (microseconds > currentMax
+           && !histogram.maxUs.compare_exchange_weak(currentMax, microseconds,
+                                                     std::memory_order_relaxed)) {
+    }
+}
+
+
+/** **************************************************************************
+* Summarize a stage's histogram. Percentiles are reported as the upper bound
+* of the bucket that contains them.
+*
+* \param stage stage to summarize
+*
+* \returns summary string, or empty string if the stage was never timed
+*
+*************************************************************************** */
+std::string StageTimings::summarize(Stage stage) const {
+    const Histogram &histogram = histograms_[stage];
+    uint64_t count = histogram.count.load();
+    if (count == 0) {
+        return "";
+    }
+
+    std::array<uint64_t, NUM_BUCKETS> buckets{};
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        buckets[i] = histogram.buckets[i].load();
+    }
+
+    auto getPercentileUs = [&](double percentile) {
+        uint64_t rank = static_cast<uint64_t>(percentile * count);
+        uint64_t cumulative = 0;
+        for (int i = 0; i < NUM_BUCKETS; ++i) {
+            cumulative += buckets[i];
+            if (cumulative > rank) {
+                return uint64_t{1} << i;
+            }
+        }
+        return uint64_t{1} << (NUM_BUCKETS - 1);
+    };
+
+    uint64_t totalUs = histogram.totalUs.load();
+    std::ostringstream summary;
+    summary << "count: " << count
+            << ", total ms: " << totalUs / 1000.0
+            << ", mean us: " << totalUs / count
+            << ", p50 us: <" << getPercentileUs(0.5)
+            << ", p90 us: <" << getPercentileUs(0.9)
+            << ", p99 us: <" << getPercentileUs(0.99)
+            << ", max us: " << histogram.maxUs.load()
+            << ", histogram us:";
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        if (buckets[i] > 0) {
+            summary << " <" << (uint64_t{1} << i) << "=" << buckets[i];
+        }
+    }
+    return summary.str();
+}
+
+
+void StageTimings::addSummaryProperties(Properties &properties) const {
+    for (int stage = 0; stage < NUM_STAGES; ++stage) {
+        std::string summary = summarize(static_cast<Stage>(stage));
+        if (!summary.empty()) {
+            properties["STAGE LATENCY " + std::string(GetStageName(static_cast<Stage>(stage)))]
+                    = std::move(summary);
+        }
+    }
+}
+
+
+std::string StageTimings::toString() const {
+    std::ostringstream out;
+    for (int stage = 0; stage < NUM_STAGES; ++stage) {
+        std::string summary = summarize(static_cast<Stage>(stage));
+        if (!summary.empty()) {
+            out << "\n    " << GetStageName(static_cast<Stage>(stage)) << ": " << summary;
+        }
+    }
+    return out.str();
+}
@@ -0,0 +1,114 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_STAGETIMINGS_H
+#define OPENMPF_COMPONENTS_STAGETIMINGS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <MPFDetectionObjects.h>
+
+
+/** ***************************************************************************
+*   Per-job latency histograms for the stages of detection and tracking.
+*   Each histogram uses power of two microsecond buckets. Updates are lock
+*   free so that stages running on inference client threads can record too.
+**************************************************************************** */
+class StageTimings {
+public:
+    enum Stage {
+        DECODE,
+        PREPROCESS,
+        FORWARD,
+        POSTPROCESS,
+        DFT_FEATURES,
+        ASSIGNMENT,
+        KALMAN,
+        NUM_STAGES
+    };
+
+    StageTimings();
+
+    /// add one sample to a stage's histogram
+    void record(Stage stage, std::chrono::steady_clock::duration elapsed);
+
+    /// add a "STAGE LATENCY <stage>" summary property for each stage that was timed
+    void addSummaryProperties(MPF::COMPONENT::Properties &properties) const;
+
+    /// single line summary of all stages for logging
+    std::string toString() const;
+
+private:
+    /// bucket i counts samples in [2^(i-1), 2^i) microseconds, bucket 0 counts samples < 1 us
+    static constexpr int NUM_BUCKETS = 32;
+
+    struct Histogram {
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> totalUs;
+        std::atomic<uint64_t> maxUs;
+        std::array<std::atomic<uint64_t>, NUM_BUCKETS> buckets;
+    };
+
+    std::array<Histogram, NUM_STAGES> histograms_;
+
+    std::string summarize(Stage stage) const;
+};
+
+
+/** ***************************************************************************
+*   Records the time from construction to destruction of the timer. Does
+*   nothing, not even read the clock, when timings is null.
+**************************************************************************** */
+class ScopedStageTimer {
+public:
+    ScopedStageTimer(StageTimings *timings, StageTimings::Stage stage)
+            : timings_(timings)
+            , stage_(stage)
+            , start_(timings ? std::chrono::steady_clock::now()
+                             : std::chrono::steady_clock::time_point()) {}
+
+    ~ScopedStageTimer() {
+        if (timings_) {
+            timings_->record(stage_, std::chrono::steady_clock::now() - start_);
+        }
+    }
+
+    ScopedStageTimer(const ScopedStageTimer &) = delete;
+
+    ScopedStageTimer &operator=(const ScopedStageTimer &) = delete;
+
+private:
+    StageTimings *timings_;
+    StageTimings::Stage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+
+#endif //OPENMPF_COMPONENTS_STAGETIMINGS_H
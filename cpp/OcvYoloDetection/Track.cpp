@@ -25,6 +25,7 @@
  ******************************************************************************/
 
 #include <cmath>
+#include <limits>
 #include <vector>
 
 #include "util.h"
@@ -101,6 +102,7 @@ void Track::kalmanInit(const float t,
                        const cv::Mat1f &rn,
                        const cv::Mat1f &qn) {
     kalmanFilterTracker_ = std::unique_ptr<KFTracker>(new KFTracker(t, dt, rec0, roi, rn, qn));
+    residualCache_.clear();
 }
 
 
@@ -159,6 +161,7 @@ cv::Rect2i Track::predictedBox() const {
 *************************************************************************** */
 void Track::kalmanPredict(const float t, const float edgeSnap) {
     if (kalmanFilterTracker_) {
+        residualCache_.clear();
         kalmanFilterTracker_->predict(t);
         // make frame edges "sticky"
         kalmanFilterTracker_->setStatePreFromBBox(
@@ -173,6 +176,7 @@ void Track::kalmanPredict(const float t, const float edgeSnap) {
 *************************************************************************** */
 void Track::kalmanCorrect(const float edgeSnap) {
     if (kalmanFilterTracker_) {
+        residualCache_.clear();
         LOG_TRACE("kf meas: " << back().getRect());
         kalmanFilterTracker_->correct(back().getRect());
         cv::Rect2i corrected = snapToEdges(back().getRect(), kalmanFilterTracker_->correctedBBox(),
@@ -196,6 +200,97 @@ float Track::testResidual(const cv::Rect2i &bbox, const float edgeSnap) const {
 }
 
 
+/** **************************************************************************
+* Get the Kalman residual for a detection from the frame currently being
+* tracked. The same track-detection pair is evaluated by each assignment
+* pass and by the debug output, so the result is kept until the next Kalman
+* predict or correct.
+*
+* \param detection detection with frameDetectionIdx set, otherwise the
+*                  residual is not memoized
+* \param edgeSnap  distance within which boxes snap to the frame edges
+*
+* \returns normalized residual
+*
+*************************************************************************** */
+float Track::kfResidual(const DetectionLocation &detection, const float edgeSnap) const {
+    int detectionIdx = detection.frameDetectionIdx;
+    if (!kalmanFilterTracker_ || detectionIdx < 0) {
+        return testResidual(detection.getRect(), edgeSnap);
+    }
+    if (detection.frame.idx != residualCacheFrameIdx_) {
+        residualCache_.clear();
+        residualCacheFrameIdx_ = detection.frame.idx;
+    }
+    if (detectionIdx >= residualCache_.size()) {
+        residualCache_.resize(detectionIdx + 1, std::numeric_limits<float>::quiet_NaN());
+    }
+    float &residual = residualCache_[detectionIdx];
+    if (std::isnan(residual)) {
+        residual = kalmanFilterTracker_->testResidual(detection.getRect(), edgeSnap);
+    }
+    return residual;
+}
+
+
+/** **************************************************************************
+* Write the track to a checkpoint. Only the tail detection's features are
+* written since earlier detections are never compared against again. The
+* OpenCV tracker can not be serialized, so checkpointing requires the MOSSE
+* tracker to be disabled.
+*
+* \param fs open file storage positioned inside a map
+*
+*************************************************************************** */
+void Track::write(cv::FileStorage &fs) const {
+    fs << "locations" << "[";
+    for (size_t i = 0; i < locations_.size(); ++i) {
+        fs << "{";
+        locations_[i].write(fs, i + 1 == locations_.size());
+        fs << "}";
+    }
+    fs << "]";
+    if (kalmanFilterTracker_) {
+        fs << "kalmanFilter" << "{";
+        kalmanFilterTracker_->write(fs);
+        fs << "}";
+    }
+}
+
+
+/** **************************************************************************
+* Restore a track written with Track::write
+*
+* \param node      file node containing the track
+* \param config    job configuration
+* \param frameData image data of the checkpointed track tails by frame index
+*
+* \returns restored track
+*
+*************************************************************************** */
+Track Track::read(const cv::FileNode &node, const Config &config,
+                  const std::unordered_map<int, cv::Mat> &frameData) {
+    Track track;
+    cv::FileNode locations = node["locations"];
+    int numLocations = static_cast<int>(locations.size());
+    for (int i = 0; i < numLocations; ++i) {
+        cv::FileNode location = locations[i];
+        cv::Mat data;
+        if (i == numLocations - 1) {
+            // only the tail keeps its frame image
+            data = frameData.at(static_cast<int>(location["frameIdx"]));
+        }
+        track.locations_.push_back(DetectionLocation::read(location, config, std::move(data)));
+    }
+
+    cv::FileNode kalmanFilter = node["kalmanFilter"];
+    if (!kalmanFilter.empty()) {
+        track.kalmanFilterTracker_.reset(new KFTracker(kalmanFilter));
+    }
+    return track;
+}
+
+
 /** **************************************************************************
 *   Dump MPF::COMPONENT::Track to a stream
 *************************************************************************** */
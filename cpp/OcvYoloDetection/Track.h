@@ -32,6 +32,7 @@
 #include <memory>
 #include <ostream>
 #include <utility>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -84,6 +85,9 @@ public:
 
     float testResidual(const cv::Rect2i &bbox, float edgeSnap) const;
 
+    /// residual of a detection from the current frame, memoized until the Kalman state changes
+    float kfResidual(const DetectionLocation &detection, float edgeSnap) const;
+
     cv::Rect2i predictedBox() const;
 
     // TODO use words for parameters
@@ -214,6 +218,13 @@ public:
     /// get class feature vector for last detection
     cv::Mat getClassFeature() const { return back().getClassFeature(); }
 
+    /// write track locations and Kalman filter state to a checkpoint
+    void write(cv::FileStorage &fs) const;
+
+    /// restore a track written with write(), tail frame image data is looked up by frame index
+    static Track read(const cv::FileNode &node, const Config &config,
+                      const std::unordered_map<int, cv::Mat> &frameData);
+
 
     friend std::ostream &operator<<(std::ostream &out, const Track &t);
 
@@ -229,6 +240,12 @@ private:
 
     std::unique_ptr<KFTracker> kalmanFilterTracker_;
 
+    /// Kalman residuals of the current frame's detections by frameDetectionIdx, NaN if not computed
+    mutable std::vector<float> residualCache_;
+
+    /// frame the cached residuals belong to
+    mutable size_t residualCacheFrameIdx_ = 0;
+
 
     template<typename TCostFunc>
     static dlib::matrix<long> getCostMatrix(std::vector<Track> &tracks,
@@ -0,0 +1,217 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "Tracking.h"
+
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "Cluster.h"
+
+using namespace MPF::COMPONENT;
+
+
+namespace {
+    std::vector<Track> AssignDetections(
+            std::vector<Cluster<Track>> &trackClusters,
+            std::vector<Cluster<DetectionLocation>> &detectionClusters,
+            const Config &config) {
+
+        // tracks that were assigned a detection in the current frame
+        std::vector<Track> assignedTracks;
+        if (config.maxIOUDist > 0) {
+            // intersection over union tracking and assignment
+            Track::assignDetections(trackClusters,
+                                    detectionClusters,
+                                    assignedTracks,
+                                    config.maxIOUDist,
+                                    config.maxClassDist,
+                                    config.maxKFResidual,
+                                    config.edgeSnapDist,
+                                    std::mem_fn(&DetectionLocation::iouDist),
+                                    "IoU",
+                                    config.enableDebug);
+            LOG_TRACE("IOU assignment complete");
+        }
+
+        if (config.maxFeatureDist > 0) {
+            // feature-based tracking and assignment
+            Track::assignDetections(trackClusters,
+                                    detectionClusters,
+                                    assignedTracks,
+                                    config.maxFeatureDist,
+                                    config.maxClassDist,
+                                    config.maxKFResidual,
+                                    config.edgeSnapDist,
+                                    std::mem_fn(&DetectionLocation::featureDist),
+                                    "DFT",
+                                    config.enableDebug);
+            LOG_TRACE("Feature assignment complete");
+        }
+
+        if (config.maxCenterDist > 0) {
+            // center-to-center distance tracking and assignment
+            Track::assignDetections(trackClusters,
+                                    detectionClusters,
+                                    assignedTracks,
+                                    config.maxCenterDist,
+                                    config.maxClassDist,
+                                    config.maxKFResidual,
+                                    config.edgeSnapDist,
+                                    std::mem_fn(&DetectionLocation::center2CenterDist),
+                                    "C2C",
+                                    config.enableDebug);
+            LOG_TRACE("Center2Center assignment complete");
+        }
+        return assignedTracks;
+    }
+
+
+    void ExtendWithOcvTracker(const Config &config, const Frame &frame,
+                              Cluster<Track> &trackCluster) {
+        if (config.mosseTrackerDisabled) {
+            return;
+        }
+        // tracks leftover have no detections in current frame, try tracking
+        for (auto &track: trackCluster.members) {
+            cv::Rect2i predictedRect;
+            bool ocvTrackingSuccessful = track.ocvTrackerPredict(frame, config.maxFrameGap,
+                                                                 predictedRect);
+            if (!ocvTrackingSuccessful ||
+                track.testResidual(predictedRect, config.edgeSnapDist) > config.maxKFResidual) {
+                continue;
+            }
+
+            float previousConfidence = track.back().confidence;
+            auto previousProps = track.back().detection_properties;
+            constexpr float gapFillPenalty = 0.00001;
+            track.add({
+                              config, frame, predictedRect,
+                              // Slightly lower confidence to make sure this detection is never chosen as the exemplar.
+                              previousConfidence - gapFillPenalty,
+                              track.back().getClassFeature(),
+                              track.back().getDFTFeature()});
+            track.back().detection_properties = std::move(previousProps);
+            track.back().detection_properties.emplace("FILLED_GAP", "TRUE");
+            track.kalmanCorrect(config.edgeSnapDist);
+        }
+    }
+} // end anonymous namespace
+
+
+/** **************************************************************************
+* Assign a frame's detections to the in-progress tracks, start new tracks for
+* the unassigned detections, and move tracks that have gone stale to the
+* completed list.
+*
+* \param         config            job configuration
+* \param         frame             frame the detections came from
+* \param         detections        detections found in the frame
+* \param[in,out] inProgressTracks  tracks that may still be extended
+* \param[in,out] completedTracks   tracks that have been terminated
+*
+*************************************************************************** */
+void ProcessFrameDetections(
+        const Config &config,
+        const Frame &frame,
+        std::vector<DetectionLocation> &&detections,
+        std::vector<Track> &inProgressTracks,
+        std::vector<MPFVideoTrack> &completedTracks) {
+
+    LOG_TRACE(detections.size() << " detections to be matched to " << inProgressTracks.size()
+                                << " tracks");
+
+    // lets tracks memoize residuals for the detections across the assignment passes
+    for (int i = 0; i < detections.size(); ++i) {
+        detections[i].frameDetectionIdx = i;
+    }
+
+    // group detections according to class features
+    std::vector<Cluster<DetectionLocation>> detectionClusterList
+            = clusterItems(std::move(detections), config.maxClassDist);
+
+    // group tracks according to class features
+    std::vector<Cluster<Track>> trackClusterList
+            = clusterItems(std::move(inProgressTracks), config.maxClassDist);
+    inProgressTracks.clear();
+
+    // tracks that were assigned a detection in the current frame
+    std::vector<Track> assignedTracks = [&] {
+        ScopedStageTimer timer(config.stageTimings.get(), StageTimings::ASSIGNMENT);
+        return AssignDetections(trackClusterList, detectionClusterList, config);
+    }();
+
+    // any detection not assigned up to this point becomes a new track
+    for (auto &detectionCluster: detectionClusterList) {
+        // make any unassigned detections into new tracks
+        for (auto &detection: detectionCluster.members) {
+            // start of tracks always get feature calculated
+            detection.getDFTFeature();
+            // create new track
+            assignedTracks.emplace_back();
+            if (!config.kfDisabled) {
+                // initialize Kalman tracker
+                assignedTracks.back().kalmanInit(detection.frame.time,
+                                                 detection.frame.timeStep,
+                                                 detection.getRect(),
+                                                 detection.frame.getRect(),
+                                                 config.RN, config.QN);
+            }
+            // add first detection to track
+            assignedTracks.back().add(std::move(detection));
+            LOG_TRACE("Created new track " << assignedTracks.back());
+
+        }
+    }
+
+    for (auto &trackCluster: trackClusterList) {
+        // check any tracks that didn't get a detection and use tracker to continue them if possible
+        ExtendWithOcvTracker(config, frame, trackCluster);
+        // move tracks with no new detections to assigned tracks
+        assignedTracks.insert(assignedTracks.end(),
+                              std::make_move_iterator(trackCluster.members.begin()),
+                              std::make_move_iterator(trackCluster.members.end()));
+    }
+
+    for (auto &track: assignedTracks) {
+        auto gapSize = frame.idx - track.back().frame.idx;
+        if (gapSize > config.maxFrameGap) {
+            // remove and convert any tracks too far in the past from the active list
+            completedTracks.push_back(Track::toMpfTrack(std::move(track)));
+        } else {
+            inProgressTracks.push_back(std::move(track));
+        }
+    }
+
+    // advance Kalman predictions
+    if (!config.kfDisabled) {
+        ScopedStageTimer timer(config.stageTimings.get(), StageTimings::KALMAN);
+        for (auto &track: inProgressTracks) {
+            track.kalmanPredict(frame.time, config.edgeSnapDist);
+        }
+    }
+}
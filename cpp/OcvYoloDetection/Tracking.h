@@ -0,0 +1,48 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_TRACKING_H
+#define OPENMPF_COMPONENTS_TRACKING_H
+
+#include <vector>
+
+#include <MPFDetectionObjects.h>
+
+#include "Config.h"
+#include "DetectionLocation.h"
+#include "Frame.h"
+#include "Track.h"
+
+
+/// update tracks with the detections from the next frame
+void ProcessFrameDetections(const Config &config,
+                            const Frame &frame,
+                            std::vector<DetectionLocation> &&detections,
+                            std::vector<Track> &inProgressTracks,
+                            std::vector<MPF::COMPONENT::MPFVideoTrack> &completedTracks);
+
+
+#endif //OPENMPF_COMPONENTS_TRACKING_H
@@ -0,0 +1,306 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "TrackingCheckpoint.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+#include <opencv2/core.hpp>
+
+#include <MPFDetectionException.h>
+#include <MPFInvalidPropertyException.h>
+#include <Utils.h>
+
+#include "util.h"
+
+using namespace MPF::COMPONENT;
+
+
+namespace {
+    /// checkpoint format version, increment when the layout changes
+    constexpr int CHECKPOINT_VERSION = 1;
+
+
+    // The key identifies jobs whose tracking state is interchangeable. The stop frame is
+    // left out because tracking is causal: the state after frame N does not depend on how
+    // many frames follow it.
+    std::string GetJobKey(const MPFVideoJob &job) {
+        std::ostringstream key;
+        key << job.data_uri << '\n' << job.start_frame << '\n';
+        for (const auto &property: job.job_properties) {
+            if (property.first.rfind("CHECKPOINT_", 0) != 0) {
+                key << property.first << '=' << property.second << '\n';
+            }
+        }
+        for (const auto &property: job.media_properties) {
+            key << property.first << '=' << property.second << '\n';
+        }
+        if (job.has_feed_forward_track) {
+            key << "FEED_FORWARD_TRACK=" << job.feed_forward_track.start_frame << '-'
+                << job.feed_forward_track.stop_frame << '\n';
+            for (const auto &location: job.feed_forward_track.frame_locations) {
+                key << location.first << ':' << location.second << '\n';
+            }
+        }
+        return key.str();
+    }
+
+
+    std::string GetCheckpointPath(const Config &config, const std::string &jobKey) {
+        std::string directory;
+        std::string error = Utils::expandFileName(config.checkpointDirectory, directory);
+        if (!error.empty()) {
+            throw MPFInvalidPropertyException(
+                    "CHECKPOINT_DIRECTORY",
+                    "The value, \"" + config.checkpointDirectory
+                    + "\", could not be expanded due to: " + error);
+        }
+
+        std::error_code errorCode;
+        std::filesystem::create_directories(directory, errorCode);
+        if (errorCode) {
+            throw MPFDetectionException(
+                    MPF_FILE_WRITE_ERROR,
+                    "Failed to create checkpoint directory \"" + directory + "\" due to: "
+                    + errorCode.message());
+        }
+
+        std::ostringstream fileName;
+        fileName << "ocv-yolo-checkpoint-" << std::hex << std::hash<std::string>()(jobKey);
+        return directory + '/' + fileName.str() + ".yml";
+    }
+
+
+    void WriteVideoTrack(cv::FileStorage &fs, const MPFVideoTrack &track) {
+        fs << "startFrame" << track.start_frame
+           << "stopFrame" << track.stop_frame
+           << "confidence" << track.confidence;
+        writeProperties(fs, "properties", track.detection_properties);
+        fs << "frameLocations" << "[";
+        for (const auto &frameLocation: track.frame_locations) {
+            const MPFImageLocation &location = frameLocation.second;
+            fs << "{"
+               << "frame" << frameLocation.first
+               << "rect" << cv::Rect2i(location.x_left_upper, location.y_left_upper,
+                                       location.width, location.height)
+               << "confidence" << location.confidence;
+            writeProperties(fs, "properties", location.detection_properties);
+            fs << "}";
+        }
+        fs << "]";
+    }
+
+
+    MPFVideoTrack ReadVideoTrack(const cv::FileNode &node) {
+        MPFVideoTrack track(static_cast<int>(node["startFrame"]),
+                            static_cast<int>(node["stopFrame"]),
+                            static_cast<float>(node["confidence"]),
+                            readProperties(node["properties"]));
+        for (const cv::FileNode &locationNode: node["frameLocations"]) {
+            cv::Rect2i rect;
+            locationNode["rect"] >> rect;
+            track.frame_locations.emplace(
+                    static_cast<int>(locationNode["frame"]),
+                    MPFImageLocation(rect.x, rect.y, rect.width, rect.height,
+                                     static_cast<float>(locationNode["confidence"]),
+                                     readProperties(locationNode["properties"])));
+        }
+        return track;
+    }
+} // end anonymous namespace
+
+
+TrackingCheckpoint::TrackingCheckpoint(const MPFVideoJob &job, const Config &config)
+        : jobKey_(GetJobKey(job))
+        , maxFrameIdx_(job.stop_frame - job.start_frame)
+        , frameInterval_(config.checkpointFrameInterval)
+        , retainOnCompletion_(config.checkpointRetainOnCompletion) {
+    if (config.checkpointDirectory.empty()) {
+        return;
+    }
+    if (!config.mosseTrackerDisabled) {
+        LOG_WARN("Checkpointing is not supported with the MOSSE tracker enabled, and has been "
+                 "disabled for this job");
+        return;
+    }
+    path_ = GetCheckpointPath(config, jobKey_);
+    LOG_DEBUG("Using checkpoint file " << path_);
+}
+
+
+/** **************************************************************************
+* Restore the tracking state from the checkpoint file, if there is one for
+* this job. A checkpoint that can not be used is ignored so that the job
+* starts over from the first frame.
+*
+* \param         config            job configuration
+* \param[in,out] inProgressTracks  receives restored in-progress tracks
+* \param[in,out] completedTracks   receives restored completed tracks
+*
+* \returns index of the last frame covered by the checkpoint or -1 if none
+*
+*************************************************************************** */
+long TrackingCheckpoint::restore(const Config &config,
+                                 std::vector<Track> &inProgressTracks,
+                                 std::vector<MPFVideoTrack> &completedTracks) {
+    if (!isEnabled() || !std::filesystem::exists(path_)) {
+        return -1;
+    }
+
+    try {
+        cv::FileStorage fs(path_, cv::FileStorage::READ);
+        if (static_cast<int>(fs["version"]) != CHECKPOINT_VERSION
+            || static_cast<std::string>(fs["jobKey"]) != jobKey_) {
+            LOG_WARN("Ignoring checkpoint " << path_ << " because it was created by a different "
+                     "job or component version.");
+            return -1;
+        }
+
+        long lastFrameIdx = static_cast<int>(fs["lastFrameIdx"]);
+        if (lastFrameIdx > maxFrameIdx_) {
+            LOG_WARN("Ignoring checkpoint " << path_ << " because its last frame " << lastFrameIdx
+                     << " is past the end of the job.");
+            return -1;
+        }
+
+        std::unordered_map<int, cv::Mat> frameData;
+        for (const cv::FileNode &frameNode: fs["frames"]) {
+            frameNode["data"] >> frameData[static_cast<int>(frameNode["idx"])];
+        }
+
+        std::vector<Track> restoredInProgress;
+        for (const cv::FileNode &trackNode: fs["inProgressTracks"]) {
+            restoredInProgress.push_back(Track::read(trackNode, config, frameData));
+        }
+
+        std::vector<MPFVideoTrack> restoredCompleted;
+        for (const cv::FileNode &trackNode: fs["completedTracks"]) {
+            restoredCompleted.push_back(ReadVideoTrack(trackNode));
+        }
+
+        inProgressTracks = std::move(restoredInProgress);
+        completedTracks = std::move(restoredCompleted);
+        lastSavedFrameIdx_ = lastFrameIdx;
+        LOG_INFO("Resuming from checkpoint at frame " << lastFrameIdx << " with "
+                 << inProgressTracks.size() << " in-progress and " << completedTracks.size()
+                 << " completed tracks.");
+        return lastFrameIdx;
+    }
+    catch (const std::exception &ex) {
+        LOG_WARN("Ignoring checkpoint " << path_ << " because it could not be read: "
+                 << ex.what());
+        return -1;
+    }
+}
+
+
+/** **************************************************************************
+* Save the tracking state once at least the configured number of frames have
+* been processed since the previous checkpoint. Must only be called between
+* frame batches, after all frames up to lastFrameIdx have been tracked.
+*
+* \param lastFrameIdx      index of the last frame that has been tracked
+* \param inProgressTracks  tracks that may still be extended
+* \param completedTracks   tracks that have been terminated
+*
+*************************************************************************** */
+void TrackingCheckpoint::update(long lastFrameIdx,
+                                const std::vector<Track> &inProgressTracks,
+                                const std::vector<MPFVideoTrack> &completedTracks) {
+    if (!isEnabled() || lastFrameIdx - lastSavedFrameIdx_ < frameInterval_) {
+        return;
+    }
+    try {
+        save(lastFrameIdx, inProgressTracks, completedTracks);
+        lastSavedFrameIdx_ = lastFrameIdx;
+    }
+    catch (const std::exception &ex) {
+        // A missed checkpoint only costs time if the job is restarted, so keep going.
+        LOG_WARN("Failed to write checkpoint " << path_ << " at frame " << lastFrameIdx
+                 << " due to: " << ex.what());
+    }
+}
+
+
+void TrackingCheckpoint::finish() {
+    if (isEnabled() && !retainOnCompletion_) {
+        std::remove(path_.c_str());
+    }
+}
+
+
+void TrackingCheckpoint::save(long lastFrameIdx,
+                              const std::vector<Track> &inProgressTracks,
+                              const std::vector<MPFVideoTrack> &completedTracks) const {
+    // Write to a temporary file and then rename it so that a job killed in the middle of
+    // writing a checkpoint still has the previous one.
+    std::string tempPath = path_.substr(0, path_.size() - 4) + ".tmp.yml";
+    {
+        cv::FileStorage fs(tempPath, cv::FileStorage::WRITE_BASE64);
+        fs << "version" << CHECKPOINT_VERSION
+           << "jobKey" << jobKey_
+           << "lastFrameIdx" << static_cast<int>(lastFrameIdx);
+
+        // Track tails from the same frame share image data, so only write it once.
+        std::unordered_map<int, cv::Mat> tailFrameData;
+        for (const Track &track: inProgressTracks) {
+            tailFrameData.emplace(track.back().frame.idx, track.back().frame.data);
+        }
+        fs << "frames" << "[";
+        for (const auto &frame: tailFrameData) {
+            fs << "{" << "idx" << frame.first << "data" << frame.second << "}";
+        }
+        fs << "]";
+
+        fs << "inProgressTracks" << "[";
+        for (const Track &track: inProgressTracks) {
+            fs << "{";
+            track.write(fs);
+            fs << "}";
+        }
+        fs << "]";
+
+        fs << "completedTracks" << "[";
+        for (const MPFVideoTrack &track: completedTracks) {
+            fs << "{";
+            WriteVideoTrack(fs, track);
+            fs << "}";
+        }
+        fs << "]";
+        fs.release();
+    }
+
+    if (std::rename(tempPath.c_str(), path_.c_str()) != 0) {
+        throw MPFDetectionException(MPF_FILE_WRITE_ERROR,
+                                    "Could not rename " + tempPath + " to " + path_);
+    }
+    LOG_DEBUG("Wrote checkpoint at frame " << lastFrameIdx << " to " << path_);
+}
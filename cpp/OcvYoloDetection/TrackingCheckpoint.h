@@ -0,0 +1,77 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_TRACKINGCHECKPOINT_H
+#define OPENMPF_COMPONENTS_TRACKINGCHECKPOINT_H
+
+#include <string>
+#include <vector>
+
+#include <MPFDetectionObjects.h>
+
+#include "Config.h"
+#include "Track.h"
+
+
+/** ***************************************************************************
+*   Periodically saves the tracking state of a video job to a local directory
+*   so that a restarted job with the same parameters can resume after the
+*   last checkpointed frame rather than starting over from the first frame.
+**************************************************************************** */
+class TrackingCheckpoint {
+public:
+    TrackingCheckpoint(const MPF::COMPONENT::MPFVideoJob &job, const Config &config);
+
+    bool isEnabled() const { return !path_.empty(); }
+
+    /// restore saved tracks, returns the index of the last checkpointed frame or -1 if none
+    long restore(const Config &config,
+                 std::vector<Track> &inProgressTracks,
+                 std::vector<MPF::COMPONENT::MPFVideoTrack> &completedTracks);
+
+    /// save tracks if enough frames have been processed since the last checkpoint
+    void update(long lastFrameIdx,
+                const std::vector<Track> &inProgressTracks,
+                const std::vector<MPF::COMPONENT::MPFVideoTrack> &completedTracks);
+
+    /// remove the checkpoint after the job completes, unless configured to retain it
+    void finish();
+
+private:
+    std::string path_;
+    std::string jobKey_;
+    long maxFrameIdx_;
+    long frameInterval_;
+    bool retainOnCompletion_;
+    long lastSavedFrameIdx_ = -1;
+
+    void save(long lastFrameIdx,
+              const std::vector<Track> &inProgressTracks,
+              const std::vector<MPF::COMPONENT::MPFVideoTrack> &completedTracks) const;
+};
+
+
+#endif //OPENMPF_COMPONENTS_TRACKINGCHECKPOINT_H
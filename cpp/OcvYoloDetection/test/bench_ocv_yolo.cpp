@@ -0,0 +1,339 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/dnn.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "Config.h"
+#include "DetectionLocation.h"
+#include "Frame.h"
+#include "KFTracker.h"
+#include "Track.h"
+#include "Tracking.h"
+#include "yolo_network/BaseYoloNetworkImpl.h"
+
+#include "TestUtils.h"
+
+using namespace MPF::COMPONENT;
+
+// All benchmarks run on the CPU using the test media and the tiny yolo model that are
+// installed with the unit tests. Run from the test build directory, e.g.
+//     ./bench_ocv_yolo --benchmark_filter=Assign
+
+
+namespace {
+    const std::string MODELS_DIR = "../plugin/OcvYoloDetection/models/";
+    const std::string VIDEO_PATH = "data/lp-ferrari-texas-shortened.mp4";
+    constexpr int NUM_CLASSES = 80;
+
+
+    Config GetBenchmarkConfig() {
+        Properties jobProps = getTinyYoloConfig();
+        jobProps["CUDA_DEVICE_ID"] = "-1";
+        return Config(jobProps);
+    }
+
+
+    const std::vector<Frame> &GetVideoFrames() {
+        static const std::vector<Frame> frames = [] {
+            cv::VideoCapture capture(VIDEO_PATH);
+            double fps = capture.get(cv::CAP_PROP_FPS);
+            std::vector<Frame> result;
+            cv::Mat data;
+            for (int i = 0; i < 8 && capture.read(data); ++i) {
+                result.emplace_back(i, i / fps, 1 / fps, data.clone());
+            }
+            return result;
+        }();
+        return frames;
+    }
+
+
+    cv::Mat1f GetClassFeature(int classIdx) {
+        cv::Mat1f feature = cv::Mat1f::zeros(1, NUM_CLASSES);
+        feature(0, classIdx % NUM_CLASSES) = 1;
+        return feature;
+    }
+
+
+    DetectionLocation CreateDetection(const Config &config, const Frame &frame,
+                                      const cv::Rect2d &box, int classIdx) {
+        DetectionLocation detection(config, frame, box, 0.9, GetClassFeature(classIdx),
+                                    cv::Mat());
+        detection.detection_properties.emplace("CLASSIFICATION", std::to_string(classIdx));
+        return detection;
+    }
+
+
+    // Boxes with random sizes scattered uniformly over the frame.
+    std::vector<cv::Rect2d> GetRandomBoxes(int count, const cv::Size &frameSize, cv::RNG &rng) {
+        std::vector<cv::Rect2d> boxes;
+        boxes.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            double width = rng.uniform(20.0, 200.0);
+            double height = rng.uniform(20.0, 200.0);
+            boxes.emplace_back(rng.uniform(0.0, frameSize.width - width),
+                               rng.uniform(0.0, frameSize.height - height),
+                               width, height);
+        }
+        return boxes;
+    }
+
+
+    // Exposes the OpenCV DNN stages of the network so they can be timed separately.
+    class BenchmarkYoloNetwork : public BaseYoloNetworkImpl {
+    public:
+        explicit BenchmarkYoloNetwork(const Config &config)
+                : BaseYoloNetworkImpl({MODELS_DIR + "yolov4-tiny.cfg",
+                                       MODELS_DIR + "yolov4-tiny.weights",
+                                       MODELS_DIR + "coco.names",
+                                       ""}, config) {}
+
+        using BaseYoloNetworkImpl::ForwardCvdnn;
+        using BaseYoloNetworkImpl::ExtractFrameDetectionsCvdnn;
+    };
+
+
+    // Tracks and detections for one frame of a synthetic scene where each object moves a
+    // few pixels from the previous frame.
+    void CreateAssignmentProblem(const Config &config, int numObjects,
+                                 std::vector<Track> &tracks,
+                                 std::vector<DetectionLocation> &detections) {
+        const Frame &prevFrame = GetVideoFrames().at(0);
+        const Frame &frame = GetVideoFrames().at(1);
+        cv::RNG rng(numObjects);
+        std::vector<cv::Rect2d> boxes = GetRandomBoxes(numObjects, frame.data.size(), rng);
+
+        tracks.clear();
+        detections.clear();
+        for (int i = 0; i < numObjects; ++i) {
+            DetectionLocation tail = CreateDetection(config, prevFrame, boxes[i], 0);
+            tail.getDFTFeature();
+            tracks.emplace_back();
+            tracks.back().kalmanInit(prevFrame.time, prevFrame.timeStep, tail.getRect(),
+                                     prevFrame.getRect(), config.RN, config.QN);
+            tracks.back().add(std::move(tail));
+            tracks.back().kalmanPredict(frame.time, config.edgeSnapDist);
+
+            cv::Point2d shift(rng.uniform(-4.0, 4.0), rng.uniform(-4.0, 4.0));
+            detections.push_back(CreateDetection(config, frame, boxes[i] + shift, 0));
+            detections.back().frameDetectionIdx = i;
+        }
+    }
+} // end anonymous namespace
+
+
+static void BM_GetDataAsResizedFloat(benchmark::State &state) {
+    const Frame &frame = GetVideoFrames().at(0);
+    cv::Size2i targetSize(state.range(0), state.range(0));
+    for (auto _: state) {
+        benchmark::DoNotOptimize(frame.getDataAsResizedFloat(targetSize));
+    }
+}
+BENCHMARK(BM_GetDataAsResizedFloat)->Arg(416)->Arg(608);
+
+
+static void BM_ExtractFrameDetectionsCvdnn(benchmark::State &state) {
+    Config config = GetBenchmarkConfig();
+    config.confidenceThreshold = 0.1;
+    BenchmarkYoloNetwork network(config);
+    std::vector<Frame> frames(GetVideoFrames().begin(), GetVideoFrames().begin() + 4);
+    // record the output tensors once so only the post-processing is timed
+    std::vector<cv::Mat> layerOutputs = network.ForwardCvdnn(frames, config);
+
+    for (auto _: state) {
+        for (int frameIdx = 0; frameIdx < frames.size(); ++frameIdx) {
+            benchmark::DoNotOptimize(network.ExtractFrameDetectionsCvdnn(
+                    frameIdx, frames[frameIdx], layerOutputs, config));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * frames.size());
+}
+BENCHMARK(BM_ExtractFrameDetectionsCvdnn)->Unit(benchmark::kMicrosecond);
+
+
+static void BM_NMSBoxes(benchmark::State &state) {
+    Config config = GetBenchmarkConfig();
+    cv::RNG rng(state.range(0));
+    // Several overlapping candidates per object, like the raw output of a yolo layer.
+    std::vector<cv::Rect2d> objects = GetRandomBoxes(state.range(0) / 10, {1920, 1080}, rng);
+    std::vector<cv::Rect2d> boxes;
+    std::vector<float> confidences;
+    for (int i = 0; i < state.range(0); ++i) {
+        const cv::Rect2d &object = objects[i % objects.size()];
+        boxes.emplace_back(object.x + rng.uniform(-8.0, 8.0), object.y + rng.uniform(-8.0, 8.0),
+                           object.width * rng.uniform(0.9, 1.1),
+                           object.height * rng.uniform(0.9, 1.1));
+        confidences.push_back(rng.uniform(config.confidenceThreshold, 1.0f));
+    }
+
+    std::vector<int> keepIndices;
+    for (auto _: state) {
+        cv::dnn::NMSBoxes(boxes, confidences, config.confidenceThreshold, config.nmsThresh,
+                          keepIndices);
+        benchmark::DoNotOptimize(keepIndices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+BENCHMARK(BM_NMSBoxes)->Arg(100)->Arg(1000)->Arg(5000);
+
+
+template<typename TCostFunc>
+static void BM_AssignDetections(benchmark::State &state, TCostFunc costFunc) {
+    Config config = GetBenchmarkConfig();
+    std::vector<Track> tracks;
+    std::vector<DetectionLocation> detections;
+    std::vector<Track> assignedTracks;
+    for (auto _: state) {
+        state.PauseTiming();
+        CreateAssignmentProblem(config, state.range(0), tracks, detections);
+        assignedTracks.clear();
+        state.ResumeTiming();
+
+        Track::assignDetections(tracks, detections, assignedTracks, 1.0, config.maxKFResidual,
+                                config.edgeSnapDist, costFunc, "bench", false);
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK_CAPTURE(BM_AssignDetections, IoU, std::mem_fn(&DetectionLocation::iouDist))
+        ->Arg(10)->Arg(50)->Arg(100)->Arg(250)->Arg(500)
+        ->Unit(benchmark::kMicrosecond)->Complexity();
+BENCHMARK_CAPTURE(BM_AssignDetections, DFT, std::mem_fn(&DetectionLocation::featureDist))
+        ->Arg(10)->Arg(50)->Arg(100)
+        ->Unit(benchmark::kMillisecond)->Complexity();
+BENCHMARK_CAPTURE(BM_AssignDetections, C2C, std::mem_fn(&DetectionLocation::center2CenterDist))
+        ->Arg(10)->Arg(50)->Arg(100)->Arg(250)->Arg(500)
+        ->Unit(benchmark::kMicrosecond)->Complexity();
+
+
+static void BM_GetDFTFeature(benchmark::State &state) {
+    Config config = GetBenchmarkConfig();
+    const Frame &frame = GetVideoFrames().at(0);
+    cv::Rect2d box(100, 50, state.range(0), state.range(0));
+    for (auto _: state) {
+        DetectionLocation detection(config, frame, box, 0.9, GetClassFeature(0), cv::Mat());
+        benchmark::DoNotOptimize(detection.getDFTFeature());
+    }
+}
+BENCHMARK(BM_GetDFTFeature)->Arg(32)->Arg(128)->Arg(256);
+
+
+static void BM_FeatureDist(benchmark::State &state) {
+    Config config = GetBenchmarkConfig();
+    std::vector<Track> tracks;
+    std::vector<DetectionLocation> detections;
+    CreateAssignmentProblem(config, 1, tracks, detections);
+    // both DFT features are cached after the first call, as they are during tracking
+    for (auto _: state) {
+        benchmark::DoNotOptimize(detections.front().featureDist(tracks.front()));
+    }
+}
+BENCHMARK(BM_FeatureDist);
+
+
+static void BM_KFTrackerPredictCorrect(benchmark::State &state) {
+    Config config = GetBenchmarkConfig();
+    float dt = 1 / 30.0f;
+    cv::Rect2i box(200, 100, 80, 60);
+    KFTracker kalmanFilter(0, dt, box, {0, 0, 1920, 1080}, config.RN, config.QN);
+    float t = 0;
+    for (auto _: state) {
+        t += dt;
+        box.x += 2;
+        if (box.x > 1800) {
+            box.x = 0;
+        }
+        kalmanFilter.predict(t);
+        kalmanFilter.correct(box);
+        benchmark::DoNotOptimize(kalmanFilter.correctedBBox());
+    }
+}
+BENCHMARK(BM_KFTrackerPredictCorrect);
+
+
+// End-to-end tracking of a synthetic detection stream without running the network. Objects
+// move at constant velocity and wrap around the frame edges, so tracks are regularly
+// terminated and restarted.
+static void BM_ProcessFrameDetections(benchmark::State &state) {
+    Config config = GetBenchmarkConfig();
+    int numObjects = state.range(0);
+    constexpr int numFrames = 100;
+    constexpr double fps = 30;
+
+    cv::Mat frameData(1080, 1920, CV_8UC3);
+    cv::RNG rng(numObjects);
+    rng.fill(frameData, cv::RNG::UNIFORM, 0, 256);
+    std::vector<cv::Rect2d> startBoxes = GetRandomBoxes(numObjects, frameData.size(), rng);
+    std::vector<cv::Point2d> velocities;
+    for (int i = 0; i < numObjects; ++i) {
+        velocities.emplace_back(rng.uniform(-10.0, 10.0), rng.uniform(-10.0, 10.0));
+    }
+
+    for (auto _: state) {
+        std::vector<Track> inProgressTracks;
+        std::vector<MPFVideoTrack> completedTracks;
+        for (int frameIdx = 0; frameIdx < numFrames; ++frameIdx) {
+            state.PauseTiming();
+            Frame frame(frameIdx, frameIdx / fps, 1 / fps, frameData);
+            std::vector<DetectionLocation> detections;
+            for (int i = 0; i < numObjects; ++i) {
+                cv::Rect2d box = startBoxes[i] + velocities[i] * frameIdx;
+                box.x = std::fmod(box.x + frameData.cols, frameData.cols);
+                box.y = std::fmod(box.y + frameData.rows, frameData.rows);
+                detections.push_back(CreateDetection(config, frame, box, i % 3));
+            }
+            state.ResumeTiming();
+
+            ProcessFrameDetections(config, frame, std::move(detections), inProgressTracks,
+                                   completedTracks);
+        }
+        benchmark::DoNotOptimize(completedTracks.data());
+    }
+    state.SetItemsProcessed(state.iterations() * numFrames);
+}
+BENCHMARK(BM_ProcessFrameDetections)->Arg(10)->Arg(50)->Arg(200)
+        ->Unit(benchmark::kMillisecond);
+
+
+int main(int argc, char **argv) {
+    init_logging();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -24,6 +24,8 @@
  * limitations under the License.                                             *
  ******************************************************************************/
 
+#include <algorithm>
+#include <filesystem>
 #include <string>
 #include <utility>
 #include <vector>
@@ -36,6 +38,7 @@
 #include "Frame.h"
 #include "DetectionLocation.h"
 #include "Track.h"
+#include "TrackingCheckpoint.h"
 #include "yolo_network/YoloNetwork.h"
 #include "OcvYoloDetection.h"
 
@@ -134,6 +137,42 @@ TEST_F(OcvLocalYoloDetectionTestFixture, TestCorrelator) {
 }
 
 
+TEST_F(OcvLocalYoloDetectionTestFixture, TestMemoizedKalmanResidual) {
+    Config cfg({});
+    cv::Mat data = cv::Mat::zeros(480, 640, CV_8UC3);
+    Frame frame0(0, 0.0, 0.1, data);
+    Frame frame1(1, 0.1, 0.1, data);
+
+    Track track;
+    DetectionLocation tail(cfg, frame0, cv::Rect2d(100, 100, 50, 50), 0.9,
+                           cv::Mat1f::ones(1, 1), cv::Mat());
+    track.kalmanInit(frame0.time, frame0.timeStep, tail.getRect(), frame0.getRect(),
+                     cfg.RN, cfg.QN);
+    track.add(std::move(tail));
+    track.kalmanPredict(frame1.time, cfg.edgeSnapDist);
+
+    DetectionLocation nearDetection(cfg, frame1, cv::Rect2d(104, 102, 50, 50), 0.9,
+                                    cv::Mat1f::ones(1, 1), cv::Mat());
+    nearDetection.frameDetectionIdx = 0;
+    DetectionLocation farDetection(cfg, frame1, cv::Rect2d(300, 200, 60, 40), 0.9,
+                                   cv::Mat1f::ones(1, 1), cv::Mat());
+    farDetection.frameDetectionIdx = 1;
+
+    float nearResidual = track.testResidual(nearDetection.getRect(), cfg.edgeSnapDist);
+    float farResidual = track.testResidual(farDetection.getRect(), cfg.edgeSnapDist);
+    ASSERT_LT(nearResidual, farResidual);
+    for (int pass = 0; pass < 3; ++pass) {
+        ASSERT_EQ(nearResidual, nearDetection.kfResidualDist(track));
+        ASSERT_EQ(farResidual, farDetection.kfResidualDist(track));
+    }
+
+    // Memoized residuals must not survive a change to the filter state.
+    track.kalmanPredict(0.2, cfg.edgeSnapDist);
+    ASSERT_EQ(track.testResidual(farDetection.getRect(), cfg.edgeSnapDist),
+              farDetection.kfResidualDist(track));
+}
+
+
 TEST_F(OcvLocalYoloDetectionTestFixture, TestImage) {
     MPFImageJob job("Test", "data/dog.jpg", getYoloConfig(), {});
 
@@ -241,6 +280,111 @@ TEST_F(OcvLocalYoloDetectionTestFixture, TestVideo) {
 }
 
 
+TEST_F(OcvLocalYoloDetectionTestFixture, TestCheckpointResume) {
+    std::string checkpointDir = "checkpoint-test";
+    std::filesystem::remove_all(checkpointDir);
+
+    auto jobProps = getTinyYoloConfig(0.5);
+    jobProps["DETECTION_FRAME_BATCH_SIZE"] = "4";
+    auto component = initComponent();
+
+    MPFVideoJob referenceJob("Test", "data/lp-ferrari-texas-shortened.mp4", 0, 19, jobProps, {});
+    auto expectedTracks = component.GetDetections(referenceJob);
+
+    // Interrupted job: the last checkpoint is written after the batch ending at frame 7.
+    jobProps["CHECKPOINT_DIRECTORY"] = checkpointDir;
+    jobProps["CHECKPOINT_FRAME_INTERVAL"] = "4";
+    jobProps["CHECKPOINT_RETAIN_ON_COMPLETION"] = "true";
+    MPFVideoJob partialJob("Test", "data/lp-ferrari-texas-shortened.mp4", 0, 9, jobProps, {});
+    component.GetDetections(partialJob);
+    ASSERT_FALSE(std::filesystem::is_empty(checkpointDir));
+
+    // Restarted job resumes from frame 8 and deletes the checkpoint when done.
+    jobProps["CHECKPOINT_RETAIN_ON_COMPLETION"] = "false";
+    MPFVideoJob resumedJob("Test", "data/lp-ferrari-texas-shortened.mp4", 0, 19, jobProps, {});
+
+    // The restarted job picks up the retained checkpoint, including the tracks that continue
+    // past frame 7.
+    {
+        Config config(resumedJob.job_properties);
+        std::vector<Track> inProgressTracks;
+        std::vector<MPFVideoTrack> completedTracks;
+        ASSERT_EQ(7, TrackingCheckpoint(resumedJob, config)
+                .restore(config, inProgressTracks, completedTracks));
+        auto numContinuingTracks = std::count_if(
+                expectedTracks.begin(), expectedTracks.end(),
+                [](const MPFVideoTrack &track) { return track.start_frame <= 7 && track.stop_frame >= 8; });
+        ASSERT_GT(numContinuingTracks, 0);
+        ASSERT_GE(static_cast<long>(inProgressTracks.size()), numContinuingTracks);
+    }
+    auto resumedTracks = component.GetDetections(resumedJob);
+    ASSERT_TRUE(std::filesystem::is_empty(checkpointDir));
+
+    ASSERT_EQ(expectedTracks.size(), resumedTracks.size());
+    for (int i = 0; i < expectedTracks.size(); ++i) {
+        const auto &expected = expectedTracks[i];
+        const auto &resumed = resumedTracks[i];
+        ASSERT_EQ(expected.start_frame, resumed.start_frame);
+        ASSERT_EQ(expected.stop_frame, resumed.stop_frame);
+        ASSERT_EQ(expected.confidence, resumed.confidence);
+        ASSERT_EQ(expected.detection_properties, resumed.detection_properties);
+        ASSERT_EQ(expected.frame_locations.size(), resumed.frame_locations.size());
+        for (const auto &[frameIdx, expectedLocation]: expected.frame_locations) {
+            const auto &resumedLocation = resumed.frame_locations.at(frameIdx);
+            ASSERT_EQ(expectedLocation.x_left_upper, resumedLocation.x_left_upper);
+            ASSERT_EQ(expectedLocation.y_left_upper, resumedLocation.y_left_upper);
+            ASSERT_EQ(expectedLocation.width, resumedLocation.width);
+            ASSERT_EQ(expectedLocation.height, resumedLocation.height);
+            ASSERT_EQ(expectedLocation.confidence, resumedLocation.confidence);
+        }
+    }
+    std::filesystem::remove_all(checkpointDir);
+}
+
+
+TEST_F(OcvLocalYoloDetectionTestFixture, TestStageTiming) {
+    auto jobProps = getTinyYoloConfig();
+    jobProps["ENABLE_STAGE_TIMING"] = "true";
+    MPFVideoJob job("Test", "data/lp-ferrari-texas-shortened.mp4", 0, 4, jobProps, {});
+
+    auto tracks = initComponent().GetDetections(job);
+    ASSERT_FALSE(tracks.empty());
+
+    const auto &properties = tracks.front().detection_properties;
+    for (const std::string stage: {"DECODE", "PREPROCESS", "FORWARD", "POSTPROCESS",
+                                   "DFT FEATURES", "ASSIGNMENT", "KALMAN"}) {
+        ASSERT_EQ(1, properties.count("STAGE LATENCY " + stage)) << stage;
+    }
+    ASSERT_EQ(0, properties.at("STAGE LATENCY DECODE").find("count: 5,"));
+
+    for (int i = 1; i < tracks.size(); ++i) {
+        ASSERT_EQ(0, tracks[i].detection_properties.count("STAGE LATENCY FORWARD"));
+    }
+}
+
+
+TEST_F(OcvLocalYoloDetectionTestFixture, TestAutoTuneBatchSize) {
+    auto jobProps = getTinyYoloConfig();
+    jobProps["AUTO_TUNE_FRAME_BATCH_SIZE"] = "true";
+    jobProps["AUTO_TUNE_MAX_FRAME_BATCH_SIZE"] = "4";
+    jobProps["AUTO_TUNE_MEMORY_LIMIT_MB"] = "0";
+    auto component = initComponent();
+
+    // Tuning uses two batches of each size: 2 * (1 + 2 + 4) = 14 frames.
+    MPFVideoJob tuningJob("Test", "data/lp-ferrari-texas-shortened.mp4", 0, 19, jobProps, {});
+    auto tracks = component.GetDetections(tuningJob);
+    ASSERT_FALSE(tracks.empty());
+    std::string batchSize = tracks.front().detection_properties.at("DETECTION FRAME BATCH SIZE");
+    ASSERT_TRUE(batchSize == "1" || batchSize == "2" || batchSize == "4") << batchSize;
+
+    // A job too short to tune reuses the previous result.
+    MPFVideoJob shortJob("Test", "data/lp-ferrari-texas-shortened.mp4", 0, 2, jobProps, {});
+    tracks = component.GetDetections(shortJob);
+    ASSERT_FALSE(tracks.empty());
+    ASSERT_EQ(batchSize, tracks.front().detection_properties.at("DETECTION FRAME BATCH SIZE"));
+}
+
+
 TEST_F(OcvLocalYoloDetectionTestFixture, TestInvalidModel) {
     ModelSettings modelSettings;
     modelSettings.ocvDnnNetworkConfigFile = "fake config";
@@ -115,6 +115,34 @@ cv::Mat fromString(const std::string &data, const int rows, const int cols, cons
 }
 
 
+/** **************************************************************************
+*   Write properties as a flat sequence of name/value pairs. Property names
+*   can contain spaces, so they can not be used as file storage keys.
+*   cv::write is used for the strings because operator<< treats strings
+*   starting with a bracket or brace as structure delimiters.
+*************************************************************************** */
+void writeProperties(cv::FileStorage &fs, const std::string &name, const Properties &properties) {
+    fs << name << "[";
+    for (const auto &property: properties) {
+        cv::write(fs, std::string(), property.first);
+        cv::write(fs, std::string(), property.second);
+    }
+    fs << "]";
+}
+
+
+/** **************************************************************************
+*   Read properties written by writeProperties
+*************************************************************************** */
+Properties readProperties(const cv::FileNode &node) {
+    Properties properties;
+    for (int i = 0; i + 1 < static_cast<int>(node.size()); i += 2) {
+        properties.emplace(static_cast<std::string>(node[i]), static_cast<std::string>(node[i + 1]));
+    }
+    return properties;
+}
+
+
 namespace MPF {
     namespace COMPONENT {
 /** **************************************************************************
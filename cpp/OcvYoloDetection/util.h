@@ -35,6 +35,7 @@
 #include <dlib/matrix.h>
 
 #include <opencv2/core.hpp>
+#include <opencv2/core/persistence.hpp>
 
 #include <MPFDetectionObjects.h>
 
@@ -85,6 +86,13 @@ cv::Mat fromString(const std::string &data,
                    int cols,
                    const std::string &dt = "f");
 
+/// write detection properties to an open file storage under the given name
+void writeProperties(cv::FileStorage &fs, const std::string &name,
+                     const MPF::COMPONENT::Properties &properties);
+
+/// read detection properties written by writeProperties
+MPF::COMPONENT::Properties readProperties(const cv::FileNode &node);
+
 namespace std {
     /// output vector to stream
     template<typename T>
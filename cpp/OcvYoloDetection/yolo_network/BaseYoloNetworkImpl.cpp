@@ -308,18 +308,12 @@ void BaseYoloNetworkImpl::Reset() noexcept {}
 std::vector<std::vector<DetectionLocation>> BaseYoloNetworkImpl::GetDetectionsCvdnn(
         const std::vector<Frame> &frames, const Config &config) {
 
-    net_.setInput(ConvertToBlob(frames.begin(), frames.end(), config.netInputImageSize));
-
-    // There are different output layers for different scales, e.g. yolo_82, yolo_94, yolo_106 for yolo v4.
-    // Each result is a row vector like: [center_x, center_y, width, height, objectness, ...class_scores]
-    // When multiple frames dimensions are: layerOutputs[output_layer][frame][box][feature]
-    // When single frame dimensions are: layerOutputs[output_layer][box][feature]
-    std::vector<cv::Mat> layerOutputs;
-    net_.forward(layerOutputs, net_.getUnconnectedOutLayersNames());
+    std::vector<cv::Mat> layerOutputs = ForwardCvdnn(frames, config);
 
     std::vector<std::vector<DetectionLocation>> detectionsGroupedByFrame;
     detectionsGroupedByFrame.reserve(frames.size());
     for (int frameIdx = 0; frameIdx < frames.size(); ++frameIdx) {
+        ScopedStageTimer timer(config.stageTimings.get(), StageTimings::POSTPROCESS);
         detectionsGroupedByFrame.push_back(
                 ExtractFrameDetectionsCvdnn(frameIdx, frames.at(frameIdx), layerOutputs, config));
     }
@@ -327,6 +321,27 @@ std::vector<std::vector<DetectionLocation>> BaseYoloNetworkImpl::GetDetectionsCv
 }
 
 
+std::vector<cv::Mat> BaseYoloNetworkImpl::ForwardCvdnn(
+        const std::vector<Frame> &frames, const Config &config) {
+
+    {
+        ScopedStageTimer timer(config.stageTimings.get(), StageTimings::PREPROCESS);
+        net_.setInput(ConvertToBlob(frames.begin(), frames.end(), config.netInputImageSize));
+    }
+
+    // There are different output layers for different scales, e.g. yolo_82, yolo_94, yolo_106 for yolo v4.
+    // Each result is a row vector like: [center_x, center_y, width, height, objectness, ...class_scores]
+    // When multiple frames dimensions are: layerOutputs[output_layer][frame][box][feature]
+    // When single frame dimensions are: layerOutputs[output_layer][box][feature]
+    std::vector<cv::Mat> layerOutputs;
+    {
+        ScopedStageTimer timer(config.stageTimings.get(), StageTimings::FORWARD);
+        net_.forward(layerOutputs, net_.getUnconnectedOutLayersNames());
+    }
+    return layerOutputs;
+}
+
+
 std::vector<DetectionLocation> BaseYoloNetworkImpl::ExtractFrameDetectionsCvdnn(
         int frameIdx, const Frame &frame, const std::vector<cv::Mat> &layerOutputs,
         const Config &config) const {
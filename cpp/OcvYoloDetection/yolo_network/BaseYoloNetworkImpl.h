@@ -78,6 +78,8 @@ protected:
     std::vector<std::vector<DetectionLocation>> GetDetectionsCvdnn(
             const std::vector<Frame> &frames, const Config &config);
 
+    std::vector<cv::Mat> ForwardCvdnn(const std::vector<Frame> &frames, const Config &config);
+
     std::vector<DetectionLocation> ExtractFrameDetectionsCvdnn(
             int frameIdx, const Frame &frame, const std::vector<cv::Mat> &layerOutputs,
             const Config &config) const;
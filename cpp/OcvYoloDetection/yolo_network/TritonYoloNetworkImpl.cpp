@@ -201,6 +201,8 @@ private:
                                                        << begin->idx << ".." << (end - 1)->idx << "].");
                                      int i = 0;
                                      for (auto frameIt = begin; frameIt != end; ++i, ++frameIt) {
+                                         ScopedStageTimer timer(config.stageTimings.get(),
+                                                                StageTimings::POSTPROCESS);
                                          detectionsGroupedByFrame.push_back(
                                                  ExtractFrameDetectionsTriton(*frameIt, outBlob.ptr<float>(i, 0),
                                                                               config));
@@ -26,12 +26,9 @@
 
 #include "SceneChangeDetection.h"
 
-#include <algorithm>
-#include <map>
+#include <set>
 #include <utility>
 
-#include <opencv2/imgproc.hpp>
-
 #include <detectionComponentUtils.h>
 #include <MPFVideoCapture.h>
 #include <Utils.h>
@@ -56,9 +53,6 @@ bool SceneChangeDetection::Init() {
     LOG4CXX_DEBUG(logger_, "Plugin path: " << plugin_path);
     LOG4CXX_INFO(logger_, "Initializing SceneChangeDetection");
 
-    // Initialize dilateKernel.
-    dilateKernel = getStructuringElement(MORPH_RECT, Size(11, 11), Point(5, 5));
-
     LOG4CXX_INFO(logger_, "INITIALIZED COMPONENT" );
     return true;
 }
@@ -70,105 +64,44 @@ bool SceneChangeDetection::Close() {
 }
 
 /*
- * Calculates the difference in edge pixels between the last two frames.
- * Returns true when the difference exceeds edge_thresh.
- */
-bool SceneChangeDetection::DetectChangeEdges(const cv::Mat &frameGray,
-                                             cv::Mat &lastFrameEdgeFinal) const {
-    cv::Mat frameEdges, frameEdgeFinal, edgeDst;
-    blur(frameGray, frameEdges, Size(3, 3));
-    Canny(frameEdges, frameEdges, 90, 270, 3);
-    frameGray.copyTo(frameEdgeFinal, frameEdges);
-    dilate(frameEdgeFinal, frameEdgeFinal, dilateKernel);
-    absdiff(frameEdgeFinal, lastFrameEdgeFinal, edgeDst);
-    double sumEdges = sum(edgeDst).val[0];
-    int frame_pixels = edgeDst.size().width * edgeDst.size().height;
-    double deltaEdges = sumEdges / frame_pixels;
-
-    frameEdges.copyTo(lastFrameEdgeFinal);
-    return deltaEdges > edge_thresh;
-}
-
-/*
- * Performs histogram comparison between the last two frames.
- * Returns true when correlation falls below hist_thresh.
+ * Selects the frames stored in a compact scene track: the first, middle, and last frames of
+ * the scene, plus every scene_frame_stride frames from the start when it is positive.
+ * The middle frame is the same one stored when USE_MIDDLE_FRAME is true.
  */
-bool SceneChangeDetection::DetectChangeHistogram(const cv::Mat &frame, cv::Mat &lastHist) const
+std::set<int> SceneChangeDetection::GetSceneFrames(int start_frame, int end_frame) const
 {
-    MatND hist;
-    const float* ranges[] = { hranges, sranges };
-
-
-    calcHist( &frame, 1, (const int*) &channels[0], Mat(), // Do not use mask.
-             hist, 2, histSize, ranges,
-             true, // The histogram is uniform.
-             false );
-    double val = compareHist(hist, lastHist, cv::HISTCMP_CORREL);
-    hist.copyTo(lastHist);
-    return val < hist_thresh;
-}
-
-/*
- * Calculates average difference in HSV values between the last two frames.
- * Returns true when total average difference exceeds cont_thresh.
- */
-bool SceneChangeDetection::DetectChangeContent(const cv::Mat &frame, cv::Mat &lastFrameHSV) const
-{
-    Mat frameHSV, dst;
-    cvtColor(frame, frameHSV, COLOR_BGR2HSV);
-    absdiff(frameHSV, lastFrameHSV, dst);
-    auto sum_ = sum(dst);
-    int frame_pixels = dst.size().width * dst.size().height;
-    double deltaH = sum_[0] / frame_pixels;
-    double deltaS = sum_[1] / frame_pixels;
-    double deltaV = sum_[2] / frame_pixels;
-    double deltaHSVAvg = (deltaH + deltaS + deltaV) / (3.0);
-
-    frameHSV.copyTo(lastFrameHSV);
-    return deltaHSVAvg > cont_thresh;
-}
-
-/*
- * Performs threshold detection for scene fade outs.
- * Note: Once threshold is met, fadeOut is set to true
- * and all subsequent frames in the scene will be marked as fade outs.
- */
-bool SceneChangeDetection::DetectChangeThreshold(const cv::Mat &frame, cv::Mat &lastFrame)
-{
-    bool FUT = frameUnderThreshold(frame, thrs_thresh, numPixels * 3);
-    if (!fadeOut && FUT)
-    {
-        fadeOut = true;
-    }
-    else if (fadeOut && FUT)
-    {
-        return true;
+    std::set<int> frames { start_frame,
+                           start_frame + (int)((end_frame - start_frame) / 2),
+                           end_frame - 1 };
+    if (scene_frame_stride > 0) {
+        for (int i = start_frame; i < end_frame; i += scene_frame_stride) {
+            frames.insert(i);
+        }
     }
-    return false;
+    return frames;
 }
 
 /*
- * Counts number of pixels that fall under threshold value.
- * If total number of dark pixels exceeds minThreshold, return true.
+ * Collects the job properties that control where scene changes are found.
  */
-bool SceneChangeDetection::frameUnderThreshold(
-        const cv::Mat &image, double threshold, double numPixels) const
+ShotBoundarySettings SceneChangeDetection::GetShotBoundarySettings() const
 {
-    int minThreshold = (int)(numPixels * (1.0 - minPercent));
-    int frameAmount = 0;
-    std::vector<Mat> channels;
-    split(image, channels);
-    for (int y = 0; y < image.rows; y++)
-    {
-        cv::Mat dst;
-        compare(channels[0].row(y), Scalar(threshold), dst, CMP_GT);
-        frameAmount += countNonZero(dst);
-        if (frameAmount > minThreshold)
-        {
-            return false;
-        }
-    }
-    return true;
+    ShotBoundarySettings settings;
+    settings.edgeThreshold = edge_thresh;
+    settings.histogramThreshold = hist_thresh;
+    settings.contentThreshold = cont_thresh;
+    settings.darkThreshold = thrs_thresh;
+    settings.minDarkFraction = minPercent;
+    settings.edgeEnabled = do_edge;
+    settings.histogramEnabled = do_hist;
+    settings.contentEnabled = do_cont;
+    settings.fadeOutEnabled = do_thrs;
+    settings.minShotLength = minScene;
+    settings.analysisMaxDimension = analysis_max_dimension;
+    settings.parallelSegments = parallel_segments;
+    settings.samplingInterval = sampling_interval;
+    settings.cacheDirectory = shot_boundary_cache_directory;
+    return settings;
 }
 
 /*
@@ -187,38 +120,9 @@ std::vector<MPFVideoTrack> SceneChangeDetection::GetDetections(const MPFVideoJob
         }
 
         LOG4CXX_DEBUG(logger_, "Data URI = " << job.data_uri);
-
-        MPFVideoCapture cap(job);
-
-        int frame_count = cap.GetFrameCount();
-        LOG4CXX_DEBUG(logger_, "frame count = " << frame_count);
         LOG4CXX_DEBUG(logger_, "begin frame = " << job.start_frame);
         LOG4CXX_DEBUG(logger_, "end frame = " << job.stop_frame);
 
-        Mat lastFrameEdgeFinal, frameGray, lastFrameHSV, lastFrame;
-        MatND lastHist;
-        int frame_index;
-        const std::vector<cv::Mat> &init_frames = cap.GetInitializationFramesIfAvailable(1);
-        // Attempt to use the frame before the start of the segment to initialize the foreground.
-        // If one is not available, use frame 0 and start processing at frame 1.
-        if (init_frames.empty()) {
-            frame_index = 1;
-            bool success = cap.Read(lastFrame);
-            if (!success){
-                return { };
-            }
-        }
-        else {
-            frame_index = 0;
-            lastFrame = init_frames.at(0);
-        }
-
-
-        int lastFrameNum = 0;
-        int rows, cols;
-        const float* ranges[] = { hranges, sranges };
-
-        // Initialize the first frame.
         edge_thresh = DetectionComponentUtils::GetProperty<double>(job.job_properties, "EDGE_THRESHOLD", edge_thresh);
         hist_thresh = DetectionComponentUtils::GetProperty<double>(job.job_properties, "HIST_THRESHOLD", hist_thresh);
         cont_thresh = DetectionComponentUtils::GetProperty<double>(job.job_properties, "CONT_THRESHOLD", cont_thresh);
@@ -233,51 +137,34 @@ std::vector<MPFVideoTrack> SceneChangeDetection::GetDetections(const MPFVideoJob
         do_edge = DetectionComponentUtils::GetProperty<bool>(job.job_properties, "DO_EDGE", do_edge);
 
         use_middle_frame = DetectionComponentUtils::GetProperty<bool>(job.job_properties, "USE_MIDDLE_FRAME", use_middle_frame);
+        analysis_max_dimension = DetectionComponentUtils::GetProperty<int>(job.job_properties, "ANALYSIS_MAX_DIMENSION", analysis_max_dimension);
+        parallel_segments = DetectionComponentUtils::GetProperty<int>(job.job_properties, "PARALLEL_SEGMENTS", parallel_segments);
 
-        rows = lastFrame.rows;
-        cols = lastFrame.cols;
-        numPixels = rows * cols;
-
-        cvtColor(lastFrame, frameGray, COLOR_BGR2GRAY);
-        cv::Mat frameEdges, frameEdgeFinal;
-        blur(frameGray, frameEdges, Size(3, 3));
-        Canny(frameEdges, frameEdges, 90, 270, 3);
-        frameGray.copyTo(lastFrameEdgeFinal, frameEdges);
-        dilate(lastFrameEdgeFinal, lastFrameEdgeFinal, dilateKernel);
-        cvtColor(lastFrame, lastFrameHSV, COLOR_BGR2HSV);
-        calcHist( &lastFrame, 1, (const int*) &channels[0], Mat(),
-             lastHist, 2, histSize, ranges,
-             true,
-             false );
-
-        cv::Mat frame;
-        std::map<int, int> keyframes;
-        while (cap.Read(frame)) {
-
-            cvtColor(frame,frameGray,COLOR_BGR2GRAY);
-            bool edge_result = do_edge && DetectChangeEdges(frameGray, lastFrameEdgeFinal);
-            bool hist_result = do_hist && DetectChangeHistogram(frame, lastHist);
-            bool cont_result = do_cont && DetectChangeContent(frame, lastFrameHSV);
-            bool thrs_result = do_thrs && DetectChangeThreshold(frame, lastFrame);
-
-            if (edge_result || hist_result || cont_result || thrs_result)
-            {
-                if (frame_index - lastFrameNum >= minScene)
-                {
-                    keyframes[frame_index] = lastFrameNum;
-                    lastFrameNum = frame_index;
-                }
-            }
+        sampling_interval = DetectionComponentUtils::GetProperty<int>(job.job_properties, "SAMPLING_INTERVAL", sampling_interval);
+        compact_scene_output = DetectionComponentUtils::GetProperty<bool>(job.job_properties, "COMPACT_SCENE_OUTPUT", compact_scene_output);
+        scene_frame_stride = DetectionComponentUtils::GetProperty<int>(job.job_properties, "SCENE_FRAME_STRIDE", scene_frame_stride);
+
+        shot_boundary_cache_directory = DetectionComponentUtils::GetProperty<std::string>(job.job_properties, "SHOT_BOUNDARY_CACHE_DIRECTORY", shot_boundary_cache_directory);
 
-            frame_index++;
+        ShotBoundarySettings settings = GetShotBoundarySettings();
+        ShotBoundaryDetector detector(logger_);
+        ShotBoundaryAnalysis analysis = detector.Analyze(job, settings);
+        if (analysis.frameSize.empty()) {
+            return { };
         }
 
-        keyframes[frame_index] = lastFrameNum;
+        // Track locations always cover the full frame, even when analyzing a downscaled copy.
+        int rows = analysis.frameSize.height;
+        int cols = analysis.frameSize.width;
+
+        // Used to map the tracks back to the original video.
+        MPFVideoCapture cap(job);
+
         std::vector<MPFVideoTrack> tracks;
-        for(auto const& kv : keyframes)
+        for (const Shot &shot : ShotBoundaryDetector::GetShots(analysis, settings))
         {
-            auto start_frame = kv.second;
-            auto end_frame = kv.first;
+            int start_frame = shot.startFrame;
+            int end_frame = shot.stopFrame + 1;
             MPFVideoTrack track(start_frame, end_frame - 1);
             if (use_middle_frame) {
                 track.frame_locations.insert(
@@ -285,6 +172,17 @@ std::vector<MPFVideoTrack> SceneChangeDetection::GetDetections(const MPFVideoJob
                             MPFImageLocation(0, 0, cols, rows)
                             )
                         );
+            } else if (compact_scene_output) {
+                for (int i : GetSceneFrames(start_frame, end_frame)) {
+                    track.frame_locations.insert(
+                        std::pair<int,MPFImageLocation>(i,
+                            MPFImageLocation(0, 0, cols, rows)
+                            )
+                        );
+                }
+                track.detection_properties["SCENE FRAME COUNT"] = std::to_string(end_frame - start_frame);
+                track.detection_properties["SCENE CHANGED FRAME COUNT"] = std::to_string(shot.changedFrameCount);
+                track.detection_properties["SCENE DARK FRAME COUNT"] = std::to_string(shot.darkFrameCount);
             } else {
                 for(int i = start_frame; i < end_frame; i++)
                 {
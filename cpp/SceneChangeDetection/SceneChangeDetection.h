@@ -28,6 +28,7 @@
 #ifndef OPENMPF_COMPONENTS_SceneChangeDetection_H
 #define OPENMPF_COMPONENTS_SceneChangeDetection_H
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -38,6 +39,7 @@
 #include <adapters/MPFVideoDetectionComponentAdapter.h>
 #include <MPFDetectionObjects.h>
 #include <MPFDetectionComponent.h>
+#include <ShotBoundaryDetector.h>
 
 
 class SceneChangeDetection : public MPF::COMPONENT::MPFVideoDetectionComponentAdapter {
@@ -51,8 +53,6 @@ public:
 
 private:
     log4cxx::LoggerPtr logger_;
-    cv::Mat dilateKernel;
-    int numPixels;
 
     // Sets threshold for edge detection (range 0-255).
     // Fepresents cutoff score for fraction of mismatches between two frames.
@@ -78,8 +78,6 @@ private:
     // Higher values decrease sensitivity.
     // Range 0-1.
     double minPercent = 0.95;
-    int channels[2] = {0,1};
-    bool fadeOut;
 
     // Expected min number of frames between scene changes.
     int minScene = 15;
@@ -88,19 +86,26 @@ private:
     bool do_hist = true, do_edge = true, do_cont = true, do_thrs = true;
     bool use_middle_frame = true;
 
-    bool DetectChangeEdges(const cv::Mat &frameGray, cv::Mat &lastFrameEdgeFinal) const;
-    bool DetectChangeHistogram(const cv::Mat &frame, cv::Mat &lastHist) const;
-    bool DetectChangeContent(const cv::Mat &frame, cv::Mat &lastFrameHSV) const;
-    bool DetectChangeThreshold(const cv::Mat &frame, cv::Mat &lastFrame);
+    // Frames larger than this are downscaled before analysis (0 = analyze at full resolution).
+    int analysis_max_dimension = 0;
 
+    // Number of segments of the video that are analyzed concurrently (1 = serial).
+    int parallel_segments = 1;
 
-    int histSize[2] = {30,32};
-    // Hue varies from 0 to 179, see cvtColor.
-    float hranges[2] = {0,180};
-    // Saturation varies from 0 (black-gray-white) to
-    // 255 (pure spectrum color).
-    float sranges[2] = {0,256};
-    bool frameUnderThreshold(const cv::Mat &image, double threshold, double numPixels) const;
+    // Distance between the frames compared before bisecting (1 = compare every frame).
+    int sampling_interval = 1;
+
+    // When use_middle_frame is false, store only representative frames and summary
+    // statistics for each scene instead of every frame.
+    bool compact_scene_output = true;
+    // Also store every scene_frame_stride frames of a compact scene (0 = disabled).
+    int scene_frame_stride = 0;
+
+    // Directory where the per-frame detector results are cached (empty = no caching).
+    std::string shot_boundary_cache_directory;
+
+    ShotBoundarySettings GetShotBoundarySettings() const;
+    std::set<int> GetSceneFrames(int start_frame, int end_frame) const;
 };
 
 
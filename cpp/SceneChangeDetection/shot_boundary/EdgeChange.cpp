@@ -0,0 +1,210 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "EdgeChange.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+
+
+using namespace cv;
+
+
+namespace {
+
+    /*
+     * Largest power of two that is not greater than size.
+     */
+    int FloorPowerOfTwo(int size) {
+        int power = 1;
+        while (power * 2 <= size) {
+            power *= 2;
+        }
+        return power;
+    }
+
+
+    /*
+     * dst[i] = max(a[i], b[i]). dst may be the same as a.
+     */
+    void MaxRow(const uchar *a, const uchar *b, uchar *dst, int width) {
+        int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+        const int step = VTraits<v_uint8>::vlanes();
+        for (; x <= width - step; x += step) {
+            v_store(dst + x, v_max(vx_load(a + x), vx_load(b + x)));
+        }
+        vx_cleanup();
+#endif
+        for (; x < width; ++x) {
+            dst[x] = std::max(a[x], b[x]);
+        }
+    }
+
+
+    /*
+     * dst[i] = gray[i] where edges[i] is set, otherwise 0. Canny edges are either 0 or 255,
+     * so this is the same as gray.copyTo(dst, edges).
+     */
+    void MaskRow(const uchar *gray, const uchar *edges, uchar *dst, int width) {
+        int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+        const int step = VTraits<v_uint8>::vlanes();
+        for (; x <= width - step; x += step) {
+            v_store(dst + x, v_and(vx_load(gray + x), vx_load(edges + x)));
+        }
+        vx_cleanup();
+#endif
+        for (; x < width; ++x) {
+            dst[x] = gray[x] & edges[x];
+        }
+    }
+
+
+    /*
+     * Sum of |max(a[i], b[i]) - last[i]|.
+     */
+    uint64_t MaxAbsDiffRow(const uchar *a, const uchar *b, const uchar *last, int width) {
+        uint64_t sum = 0;
+        int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+        const int step = VTraits<v_uint8>::vlanes();
+        for (; x <= width - step; x += step) {
+            sum += v_reduce_sad(v_max(vx_load(a + x), vx_load(b + x)), vx_load(last + x));
+        }
+        vx_cleanup();
+#endif
+        for (; x < width; ++x) {
+            sum += std::abs(std::max(a[x], b[x]) - last[x]);
+        }
+        return sum;
+    }
+}
+
+
+EdgeChange::EdgeChange(int dilateRadius)
+        : radius_(dilateRadius) {
+    CV_Assert(dilateRadius >= 0);
+}
+
+
+void EdgeChange::Reset(const cv::Mat &frameGray, bool afterAnalyzedFrame) {
+    DetectEdges(frameGray);
+    if (afterAnalyzedFrame) {
+        std::swap(edges_, lastEdges_);
+    }
+    else {
+        DilateRows(frameGray);
+        lastEdges_.create(frameGray.size(), CV_8UC1);
+        DilateColumns(&lastEdges_, nullptr);
+    }
+}
+
+
+double EdgeChange::Update(const cv::Mat &frameGray) {
+    CV_Assert(frameGray.size() == lastEdges_.size());
+    DetectEdges(frameGray);
+    DilateRows(frameGray);
+    uint64_t diffSum = 0;
+    DilateColumns(nullptr, &diffSum);
+    // Only the undilated edges are kept for the next frame.
+    std::swap(edges_, lastEdges_);
+    return static_cast<double>(diffSum) / (frameGray.rows * frameGray.cols);
+}
+
+
+void EdgeChange::DetectEdges(const cv::Mat &frameGray) {
+    CV_Assert(frameGray.type() == CV_8UC1);
+    blur(frameGray, blurred_, Size(3, 3));
+    Canny(blurred_, edges_, 90, 270, 3);
+}
+
+
+/*
+ * Masks the gray frame with the edges and applies the horizontal max filter to each row.
+ * Out of frame pixels are treated as 0, which is the same as dilate's default border since 0
+ * never raises a maximum.
+ *
+ * A window of kernelSize pixels is covered by two overlapping windows of the largest power
+ * of two that fits. The maximums over power of two windows are built in place by repeatedly
+ * taking the maximum with the value shift pixels to the right and doubling shift.
+ */
+void EdgeChange::DilateRows(const cv::Mat &frameGray) {
+    int width = frameGray.cols;
+    int kernelSize = 2 * radius_ + 1;
+    int window = FloorPowerOfTwo(kernelSize);
+    int paddedWidth = width + 2 * radius_;
+    paddedRow_.resize(paddedWidth);
+    rowMax_.create(frameGray.rows + 2 * radius_, width, CV_8UC1);
+
+    uchar *padded = paddedRow_.data();
+    for (int y = 0; y < frameGray.rows; y++) {
+        std::fill(padded, padded + radius_, 0);
+        std::fill(padded + radius_ + width, padded + paddedWidth, 0);
+        MaskRow(frameGray.ptr<uchar>(y), edges_.ptr<uchar>(y), padded + radius_, width);
+        for (int shift = 1; shift < window; shift *= 2) {
+            MaxRow(padded, padded + shift, padded, paddedWidth - shift);
+        }
+        MaxRow(padded, padded + kernelSize - window, rowMax_.ptr<uchar>(y + radius_), width);
+    }
+}
+
+
+/*
+ * Applies the vertical max filter to rowMax_, the same way DilateRows does for each row.
+ * The result is either stored in dst or compared with lastEdges_ and added to diffSum.
+ */
+void EdgeChange::DilateColumns(cv::Mat *dst, uint64_t *diffSum) {
+    int width = rowMax_.cols;
+    int height = rowMax_.rows - 2 * radius_;
+    int kernelSize = 2 * radius_ + 1;
+    int window = FloorPowerOfTwo(kernelSize);
+    // The padding rows are overwritten by the previous frame's shifted maximums.
+    rowMax_.rowRange(0, radius_).setTo(0);
+    rowMax_.rowRange(radius_ + height, rowMax_.rows).setTo(0);
+
+    for (int shift = 1; shift < window; shift *= 2) {
+        for (int y = 0; y < rowMax_.rows - shift; y++) {
+            MaxRow(rowMax_.ptr<uchar>(y), rowMax_.ptr<uchar>(y + shift), rowMax_.ptr<uchar>(y),
+                   width);
+        }
+    }
+
+    for (int y = 0; y < height; y++) {
+        const uchar *top = rowMax_.ptr<uchar>(y);
+        const uchar *bottom = rowMax_.ptr<uchar>(y + kernelSize - window);
+        if (dst != nullptr) {
+            MaxRow(top, bottom, dst->ptr<uchar>(y), width);
+        }
+        else {
+            *diffSum += MaxAbsDiffRow(top, bottom, lastEdges_.ptr<uchar>(y), width);
+        }
+    }
+}
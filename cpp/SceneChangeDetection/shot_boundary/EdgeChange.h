@@ -0,0 +1,81 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_EDGECHANGE_H
+#define OPENMPF_COMPONENTS_EDGECHANGE_H
+
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+
+/**
+ * Computes the edge detector's average difference between a frame's dilated edge pixels and
+ * the edges kept from the previous frame. The dilation with a square kernel is done as two
+ * separable max filters, each built from log2(kernel size) shifted maximums rather than one
+ * maximum per kernel element. The masking of the gray frame is fused into the horizontal pass
+ * and the difference and sum into the vertical pass. All buffers are reused for every frame.
+ * The results are identical to blur + Canny + copyTo + dilate + absdiff + sum.
+ */
+class EdgeChange {
+public:
+    /// Dilation with a (2 * dilateRadius + 1) square kernel anchored at its center.
+    explicit EdgeChange(int dilateRadius);
+
+    /**
+     * Compute the edges that the next call to Update is compared against. When
+     * afterAnalyzedFrame is false the dilated edge pixels of the frame are kept, otherwise
+     * its undilated edges, which is what Update keeps.
+     */
+    void Reset(const cv::Mat &frameGray, bool afterAnalyzedFrame);
+
+    /// Average absolute difference per pixel from the previous frame's edges. The frame's
+    /// undilated edges are kept for the next comparison.
+    double Update(const cv::Mat &frameGray);
+
+private:
+    int radius_;
+
+    cv::Mat blurred_;
+    cv::Mat edges_;
+    cv::Mat lastEdges_;
+
+    /// Horizontal max filter output with radius_ rows of zeros above and below.
+    cv::Mat rowMax_;
+
+    /// One row of masked gray pixels with radius_ zeros on either side.
+    std::vector<uchar> paddedRow_;
+
+    void DetectEdges(const cv::Mat &frameGray);
+
+    void DilateRows(const cv::Mat &frameGray);
+
+    void DilateColumns(cv::Mat *dst, uint64_t *diffSum);
+};
+
+
+#endif //OPENMPF_COMPONENTS_EDGECHANGE_H
@@ -0,0 +1,194 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "FrameStatistics.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+
+
+using namespace cv;
+
+
+namespace {
+
+    /*
+     * Adds one row of BGR pixels to the histogram bin counts and/or the above threshold count.
+     */
+    template<bool DoHist, bool DoThrs>
+    void AccumulateRow(const uchar *pixel, int width, const int *binLut0, const int *binLut1,
+                       int histCols, const uchar *aboveLut, int *binCounts, int &numAbove) {
+        int rowAbove = 0;
+        for (const uchar *rowEnd = pixel + 3 * width; pixel != rowEnd; pixel += 3) {
+            if (DoHist) {
+                int bin0 = binLut0[pixel[0]];
+                int bin1 = binLut1[pixel[1]];
+                if ((bin0 | bin1) >= 0) {
+                    ++binCounts[bin0 * histCols + bin1];
+                }
+            }
+            if (DoThrs) {
+                rowAbove += aboveLut[pixel[0]];
+            }
+        }
+        numAbove += rowAbove;
+    }
+
+
+    /*
+     * Adds the per channel absolute differences between two rows of 3 channel pixels.
+     */
+    void AccumulateAbsDiff(const uchar *cur, const uchar *prev, int width, uint64_t sums[3]) {
+        int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+        const int step = VTraits<v_uint8>::vlanes();
+        for (; x <= width - step; x += step) {
+            v_uint8 cur0, cur1, cur2, prev0, prev1, prev2;
+            v_load_deinterleave(cur + 3 * x, cur0, cur1, cur2);
+            v_load_deinterleave(prev + 3 * x, prev0, prev1, prev2);
+            sums[0] += v_reduce_sad(cur0, prev0);
+            sums[1] += v_reduce_sad(cur1, prev1);
+            sums[2] += v_reduce_sad(cur2, prev2);
+        }
+        vx_cleanup();
+#endif
+        for (; x < width; ++x) {
+            sums[0] += std::abs(cur[3 * x] - prev[3 * x]);
+            sums[1] += std::abs(cur[3 * x + 1] - prev[3 * x + 1]);
+            sums[2] += std::abs(cur[3 * x + 2] - prev[3 * x + 2]);
+        }
+    }
+}
+
+
+FrameStatistics::FrameStatistics(const int histSize[2], const float ranges0[2],
+                                 const float ranges1[2])
+        : histSize_{histSize[0], histSize[1]}
+        , binCounts_(histSize[0] * histSize[1]) {
+    // Same bin lookup as calcHist uses for uniform 8-bit histograms.
+    const float *ranges[] = { ranges0, ranges1 };
+    for (int i = 0; i < 2; i++) {
+        double scale = histSize[i] / ((double) ranges[i][1] - ranges[i][0]);
+        double offset = -scale * ranges[i][0];
+        for (int value = 0; value < 256; value++) {
+            int bin = cvFloor(value * scale + offset);
+            if (value >= ranges[i][0] && value < ranges[i][1]) {
+                binLut_[i][value] = std::max(std::min(bin, histSize[i] - 1), 0);
+            }
+            else {
+                binLut_[i][value] = -1;
+            }
+        }
+    }
+    hist_.create(2, histSize, CV_32F);
+    lastHist_.create(2, histSize, CV_32F);
+}
+
+
+void FrameStatistics::Configure(bool doHist, bool doCont, bool doThrs, double threshold) {
+    doHist_ = doHist;
+    doCont_ = doCont;
+    doThrs_ = doThrs;
+    // Matches compare(src, Scalar(threshold), dst, CMP_GT) for fractional and out of range
+    // thresholds.
+    for (int value = 0; value < 256; value++) {
+        aboveLut_[value] = value > threshold ? 1 : 0;
+    }
+}
+
+
+void FrameStatistics::Reset(const cv::Mat &frame) {
+    ComputeFrameStatistics(frame, true, false);
+    cvtColor(frame, hsv_, COLOR_BGR2HSV);
+    hsvDeltaSums_ = Scalar::all(0);
+}
+
+
+void FrameStatistics::Update(const cv::Mat &frame) {
+    if (doHist_) {
+        std::swap(hist_, lastHist_);
+    }
+    ComputeFrameStatistics(frame, doHist_, doThrs_);
+
+    if (doCont_) {
+        std::swap(hsv_, lastHsv_);
+        cvtColor(frame, hsv_, COLOR_BGR2HSV);
+        ComputeHsvDeltaSums();
+    }
+}
+
+
+/*
+ * Collects the histogram and the above threshold count in a single pass over the frame.
+ */
+void FrameStatistics::ComputeFrameStatistics(const cv::Mat &frame, bool doHist, bool doThrs) {
+    CV_Assert(frame.type() == CV_8UC3);
+    if (doHist) {
+        std::fill(binCounts_.begin(), binCounts_.end(), 0);
+    }
+
+    int numAbove = 0;
+    const int *binLut0 = binLut_[0].data();
+    const int *binLut1 = binLut_[1].data();
+    for (int y = 0; y < frame.rows; y++) {
+        const uchar *row = frame.ptr<uchar>(y);
+        if (doHist && doThrs) {
+            AccumulateRow<true, true>(row, frame.cols, binLut0, binLut1, histSize_[1],
+                                      aboveLut_.data(), binCounts_.data(), numAbove);
+        }
+        else if (doHist) {
+            AccumulateRow<true, false>(row, frame.cols, binLut0, binLut1, histSize_[1],
+                                       aboveLut_.data(), binCounts_.data(), numAbove);
+        }
+        else if (doThrs) {
+            AccumulateRow<false, true>(row, frame.cols, binLut0, binLut1, histSize_[1],
+                                       aboveLut_.data(), binCounts_.data(), numAbove);
+        }
+    }
+
+    if (doHist) {
+        // calcHist also counts in integers before converting to float.
+        auto *histData = hist_.ptr<float>();
+        for (size_t i = 0; i < binCounts_.size(); i++) {
+            histData[i] = static_cast<float>(binCounts_[i]);
+        }
+    }
+    numAboveThreshold_ = numAbove;
+}
+
+
+void FrameStatistics::ComputeHsvDeltaSums() {
+    uint64_t sums[3] = { 0, 0, 0 };
+    for (int y = 0; y < hsv_.rows; y++) {
+        AccumulateAbsDiff(hsv_.ptr<uchar>(y), lastHsv_.ptr<uchar>(y), hsv_.cols, sums);
+    }
+    hsvDeltaSums_ = Scalar(static_cast<double>(sums[0]), static_cast<double>(sums[1]),
+                           static_cast<double>(sums[2]));
+}
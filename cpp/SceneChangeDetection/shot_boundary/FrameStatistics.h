@@ -0,0 +1,96 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_FRAMESTATISTICS_H
+#define OPENMPF_COMPONENTS_FRAMESTATISTICS_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+
+/**
+ * Computes the statistics used by the histogram, content, and threshold scene change
+ * detectors. The histogram and threshold count are collected in a single pass over the BGR
+ * frame and the HSV deltas in a single pass over the HSV frames, reusing the same buffers for
+ * every frame. The results are identical to calcHist, absdiff + sum, and compare + countNonZero.
+ */
+class FrameStatistics {
+public:
+    /// Histogram of channels 0 and 1 with the given number of bins and uniform [low, high) ranges.
+    FrameStatistics(const int histSize[2], const float ranges0[2], const float ranges1[2]);
+
+    /// Select which statistics Update computes and set the threshold for the pixel count.
+    void Configure(bool doHist, bool doCont, bool doThrs, double threshold);
+
+    /// Compute the statistics for the frame that the next call to Update is compared against.
+    void Reset(const cv::Mat &frame);
+
+    /// Compute the statistics for the next frame, keeping the previous frame's for comparison.
+    void Update(const cv::Mat &frame);
+
+    /// 2D histogram of the current frame, same layout as calcHist.
+    const cv::Mat &GetHistogram() const { return hist_; }
+
+    /// 2D histogram of the previous frame.
+    const cv::Mat &GetLastHistogram() const { return lastHist_; }
+
+    /// Per channel sum of absolute HSV differences between the current and previous frames.
+    const cv::Scalar &GetHsvDeltaSums() const { return hsvDeltaSums_; }
+
+    /// Number of pixels whose blue channel is above the threshold.
+    int GetNumAboveThreshold() const { return numAboveThreshold_; }
+
+private:
+    std::array<int, 2> histSize_;
+
+    /// Bin index for each channel value, -1 when out of range.
+    std::array<std::array<int, 256>, 2> binLut_;
+
+    /// 1 for each value above the threshold.
+    std::array<uchar, 256> aboveLut_{};
+
+    bool doHist_ = true;
+    bool doCont_ = true;
+    bool doThrs_ = true;
+
+    std::vector<int> binCounts_;
+    cv::Mat hist_;
+    cv::Mat lastHist_;
+    cv::Mat hsv_;
+    cv::Mat lastHsv_;
+    cv::Scalar hsvDeltaSums_;
+    int numAboveThreshold_ = 0;
+
+    void ComputeFrameStatistics(const cv::Mat &frame, bool doHist, bool doThrs);
+
+    void ComputeHsvDeltaSums();
+};
+
+
+#endif //OPENMPF_COMPONENTS_FRAMESTATISTICS_H
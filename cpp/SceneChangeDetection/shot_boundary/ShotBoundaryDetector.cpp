@@ -0,0 +1,587 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "ShotBoundaryDetector.h"
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <limits>
+#include <map>
+#include <optional>
+#include <utility>
+
+#include <opencv2/imgproc.hpp>
+
+#include <MPFAsyncVideoCapture.h>
+#include <MPFVideoCapture.h>
+
+#include "EdgeChange.h"
+#include "FrameStatistics.h"
+#include "ShotBoundaryIndex.h"
+
+
+using namespace MPF::COMPONENT;
+using namespace cv;
+
+
+namespace {
+
+    // Detector state carried from one frame to the next. Each concurrently analyzed
+    // segment has its own.
+    struct AnalysisState {
+        FrameStatistics frameStats;
+        EdgeChange edgeChange;
+        cv::Mat analysisFrame;
+        cv::Mat frameGray;
+    };
+
+
+    /*
+     * Runs the detectors on the frames of one job.
+     */
+    class JobAnalyzer {
+    public:
+        JobAnalyzer(const ShotBoundarySettings &settings, log4cxx::LoggerPtr logger)
+                : settings_(settings)
+                , logger_(std::move(logger)) {
+        }
+
+        /*
+         * Analyzes every frame of the job on the calling thread while the next frames are
+         * decoded in the background.
+         */
+        bool AnalyzeVideo(const MPFVideoJob &job, const std::vector<cv::Mat> &init_frames,
+                          ShotBoundaryAnalysis &analysis) {
+            // Frames are decoded on a background thread into a bounded queue while the
+            // previous frames are analyzed.
+            MPFAsyncVideoCapture cap(job);
+
+            cv::Mat lastFrame;
+            if (init_frames.empty()) {
+                auto firstFrame = cap.Read();
+                if (!firstFrame) {
+                    return false;
+                }
+                lastFrame = std::move(firstFrame->data);
+            }
+            else {
+                lastFrame = init_frames.at(0);
+            }
+
+            analysis.frameSize = lastFrame.size();
+            SetAnalysisScale(analysis.frameSize);
+            AnalysisState state = CreateAnalysisState();
+            InitAnalysis(state, lastFrame, false);
+
+            while (auto mpfFrame = cap.Read()) {
+                analysis.frames.push_back(AnalyzeFrame(state, mpfFrame->data));
+            }
+            return true;
+        }
+
+
+        /*
+         * Splits the frames of the job into segments that are analyzed concurrently, then
+         * concatenates their results in frame order.
+         */
+        bool AnalyzeSegments(const MPFVideoJob &job, MPFVideoCapture &cap,
+                             const std::vector<cv::Mat> &init_frames, int frame_count,
+                             ShotBoundaryAnalysis &analysis) {
+            cv::Mat firstFrame;
+            if (init_frames.empty()) {
+                if (!cap.Read(firstFrame)) {
+                    return false;
+                }
+            }
+            else {
+                firstFrame = init_frames.at(0);
+            }
+            int firstFrameIndex = analysis.firstFrameIndex;
+
+            analysis.frameSize = firstFrame.size();
+            SetAnalysisScale(analysis.frameSize);
+
+            int numFrames = std::max(frame_count - firstFrameIndex, 0);
+            int numSegments = std::max(1, std::min(settings_.parallelSegments, numFrames));
+            LOG4CXX_DEBUG(logger_, "Analyzing " << numFrames << " frames in " << numSegments
+                                   << " segments");
+
+            std::vector<int> segmentBegins;
+            std::vector<std::future<std::vector<FrameChange>>> segments;
+            for (int i = 0; i < numSegments; i++) {
+                int begin = firstFrameIndex + (int) ((long) numFrames * i / numSegments);
+                // The frame count may be an estimate, so the last segment reads until the
+                // video ends.
+                int end = i == numSegments - 1
+                          ? std::numeric_limits<int>::max()
+                          : firstFrameIndex + (int) ((long) numFrames * (i + 1) / numSegments);
+                cv::Mat segmentLastFrame = i == 0 ? firstFrame : cv::Mat();
+                bool afterAnalyzedFrame = i > 0;
+                segmentBegins.push_back(begin);
+                segments.push_back(std::async(std::launch::async, [=, &job] {
+                    return AnalyzeSegment(job, segmentLastFrame, begin, end, afterAnalyzedFrame);
+                }));
+            }
+
+            // Always wait for every segment before re-throwing an exception from one of them.
+            for (auto &segment : segments) {
+                segment.wait();
+            }
+            std::vector<FrameChange> &results = analysis.frames;
+            for (int i = 0; i < numSegments; i++) {
+                // Will re-throw exception from thread.
+                std::vector<FrameChange> segmentResults = segments[i].get();
+                results.insert(results.end(), segmentResults.begin(), segmentResults.end());
+                // A serial run stops at the first frame that can not be read, so the segments
+                // after a short one are discarded.
+                if (i < numSegments - 1
+                        && firstFrameIndex + results.size() < (size_t) segmentBegins[i + 1]) {
+                    LOG4CXX_WARN(logger_, "Video ended at frame " << firstFrameIndex + results.size()
+                            << ", before the frame count of " << frame_count << " was reached.");
+                    break;
+                }
+            }
+            return true;
+        }
+
+
+        /*
+         * Compares frames samplingInterval frames apart and only looks at the frames in
+         * between when the detectors find a change between the samples. The interval is then
+         * bisected, seeking to the middle frame, until the change is narrowed down to
+         * consecutive frames, which are compared exactly as in a serial run. When either end
+         * of an interval is under the fade out threshold, every frame in it is analyzed,
+         * since the fade out detector looks at individual frames. Frames that are skipped are
+         * reported as unchanged.
+         *
+         * A shot that is shorter than samplingInterval frames can be missed, because both of
+         * the samples around it may fall in the surrounding shots. The same applies to a fade
+         * out that is shorter than samplingInterval frames.
+         */
+        bool AnalyzeSampled(MPFVideoCapture &cap, const std::vector<cv::Mat> &init_frames,
+                            ShotBoundaryAnalysis &analysis) {
+            cv::Mat firstFrame;
+            if (init_frames.empty()) {
+                if (!cap.Read(firstFrame)) {
+                    return false;
+                }
+            }
+            else {
+                firstFrame = init_frames.at(0);
+            }
+            int firstFrameIndex = analysis.firstFrameIndex;
+            std::vector<FrameChange> &results = analysis.frames;
+
+            analysis.frameSize = firstFrame.size();
+            SetAnalysisScale(analysis.frameSize);
+
+            // Only seek when not reading the next frame, since seeking may decode from the
+            // previous key frame.
+            int nextPosition = firstFrameIndex;
+            auto readFrame = [&](int frame_index, cv::Mat &frame) {
+                if (frame_index != nextPosition && !cap.SetFramePosition(frame_index)) {
+                    nextPosition = -1;
+                    return false;
+                }
+                nextPosition = cap.Read(frame) ? frame_index + 1 : -1;
+                return nextPosition >= 0;
+            };
+
+            auto resultAt = [&](int frame_index) -> FrameChange & {
+                size_t i = frame_index - firstFrameIndex;
+                if (i >= results.size()) {
+                    results.resize(i + 1, FrameChange{ false, false });
+                }
+                return results[i];
+            };
+
+            // The detector state can be reused when the next comparison starts from the frame
+            // that was just analyzed.
+            AnalysisState state = CreateAnalysisState();
+            int stateFrameIndex = std::numeric_limits<int>::min();
+            auto compareFrames = [&](int aIndex, const cv::Mat &frameA,
+                                     int bIndex, const cv::Mat &frameB) {
+                if (stateFrameIndex != aIndex) {
+                    InitAnalysis(state, frameA, aIndex >= firstFrameIndex);
+                }
+                FrameChange result = AnalyzeFrame(state, frameB);
+                stateFrameIndex = bIndex;
+                resultAt(bIndex).underThreshold = result.underThreshold;
+                if (bIndex == aIndex + 1) {
+                    resultAt(bIndex).changed = result.changed;
+                }
+                return result;
+            };
+
+            auto analyzeAll = [&](int aIndex, const cv::Mat &frameA, int bIndex) {
+                cv::Mat lastFrame = frameA;
+                for (int frame_index = aIndex + 1; frame_index <= bIndex; frame_index++) {
+                    cv::Mat frame;
+                    if (!readFrame(frame_index, frame)) {
+                        break;
+                    }
+                    compareFrames(frame_index - 1, lastFrame, frame_index, frame);
+                    lastFrame = frame;
+                }
+            };
+
+            std::function<void(int, const cv::Mat &, bool, int, const cv::Mat &)> analyzeInterval
+                    = [&](int aIndex, const cv::Mat &frameA, bool aUnderThreshold,
+                          int bIndex, const cv::Mat &frameB) {
+                FrameChange result = compareFrames(aIndex, frameA, bIndex, frameB);
+                if (bIndex == aIndex + 1) {
+                    return;
+                }
+                if (aUnderThreshold || result.underThreshold) {
+                    analyzeAll(aIndex, frameA, bIndex);
+                    return;
+                }
+                if (!result.changed) {
+                    return;
+                }
+                int midIndex = aIndex + (bIndex - aIndex) / 2;
+                cv::Mat midFrame;
+                if (!readFrame(midIndex, midFrame)) {
+                    analyzeAll(aIndex, frameA, bIndex);
+                    return;
+                }
+                analyzeInterval(aIndex, frameA, aUnderThreshold, midIndex, midFrame);
+                analyzeInterval(midIndex, midFrame, resultAt(midIndex).underThreshold,
+                                bIndex, frameB);
+            };
+
+            int aIndex = firstFrameIndex - 1;
+            cv::Mat frameA = firstFrame;
+            bool aUnderThreshold = false;
+            while (true) {
+                int bIndex = aIndex + settings_.samplingInterval;
+                cv::Mat frameB;
+                if (!readFrame(bIndex, frameB)) {
+                    // Fewer than samplingInterval frames remain.
+                    analyzeAll(aIndex, frameA, std::numeric_limits<int>::max());
+                    break;
+                }
+                analyzeInterval(aIndex, frameA, aUnderThreshold, bIndex, frameB);
+                aIndex = bIndex;
+                frameA = frameB;
+                aUnderThreshold = resultAt(bIndex).underThreshold;
+            }
+            return true;
+        }
+
+    private:
+        const ShotBoundarySettings &settings_;
+        log4cxx::LoggerPtr logger_;
+        double analysisScale_ = 1.0;
+        int numPixels_ = 0;
+        int dilateRadius_ = 5;
+
+        int histSize_[2] = {30,32};
+        // Hue varies from 0 to 179, see cvtColor.
+        float hranges_[2] = {0,180};
+        // Saturation varies from 0 (black-gray-white) to
+        // 255 (pure spectrum color).
+        float sranges_[2] = {0,256};
+
+
+        /*
+         * Sets the scale at which frames are analyzed so that neither dimension exceeds
+         * analysisMaxDimension, and scales the 11x11 edge dilation kernel to match.
+         */
+        void SetAnalysisScale(const cv::Size &frameSize) {
+            analysisScale_ = 1.0;
+            int maxDimension = std::max(frameSize.width, frameSize.height);
+            if (settings_.analysisMaxDimension > 0 && maxDimension > settings_.analysisMaxDimension) {
+                analysisScale_ = settings_.analysisMaxDimension / (double) maxDimension;
+            }
+
+            dilateRadius_ = analysisScale_ < 1.0 ? cvRound(5 * analysisScale_) : 5;
+
+            Size analysisSize = GetAnalysisSize(frameSize);
+            // The content and threshold detectors normalize by the number of analyzed pixels.
+            numPixels_ = analysisSize.width * analysisSize.height;
+            LOG4CXX_DEBUG(logger_, "analysis frame size = " << analysisSize);
+        }
+
+
+        cv::Size GetAnalysisSize(const cv::Size &frameSize) const {
+            if (analysisScale_ >= 1.0) {
+                return frameSize;
+            }
+            return { std::max(1, cvRound(frameSize.width * analysisScale_)),
+                     std::max(1, cvRound(frameSize.height * analysisScale_)) };
+        }
+
+
+        /*
+         * Returns the frame the detectors run on. When downscaling, the frame is resized once
+         * with area interpolation into a buffer that is reused for every frame.
+         */
+        const cv::Mat &GetAnalysisFrame(const cv::Mat &frame, AnalysisState &state) const {
+            if (analysisScale_ >= 1.0) {
+                return frame;
+            }
+            resize(frame, state.analysisFrame, GetAnalysisSize(frame.size()), 0, 0, INTER_AREA);
+            return state.analysisFrame;
+        }
+
+
+        AnalysisState CreateAnalysisState() const {
+            return { FrameStatistics(histSize_, hranges_, sranges_), EdgeChange(dilateRadius_) };
+        }
+
+
+        /*
+         * Prepares the detectors to compare against lastFrame. afterAnalyzedFrame is true
+         * when lastFrame would itself have been analyzed in a serial run, which is the case
+         * for the overlapping frame at the start of every segment but the first. The edge
+         * detector keeps the undilated edges of analyzed frames, but the dilated edges of the
+         * initial frame, so that must be reproduced for segments to give the same results as
+         * a serial run.
+         */
+        void InitAnalysis(AnalysisState &state, const cv::Mat &lastFrame,
+                          bool afterAnalyzedFrame) const {
+            const cv::Mat &lastAnalysisFrame = GetAnalysisFrame(lastFrame, state);
+            cvtColor(lastAnalysisFrame, state.frameGray, COLOR_BGR2GRAY);
+            if (settings_.edgeEnabled) {
+                state.edgeChange.Reset(state.frameGray, afterAnalyzedFrame);
+            }
+            state.frameStats.Configure(settings_.histogramEnabled, settings_.contentEnabled,
+                                       settings_.fadeOutEnabled, settings_.darkThreshold);
+            state.frameStats.Reset(lastAnalysisFrame);
+        }
+
+
+        /*
+         * Runs the detectors that only depend on the frame and its predecessor.
+         */
+        FrameChange AnalyzeFrame(AnalysisState &state, const cv::Mat &frame) const {
+            const cv::Mat &analysisFrame = GetAnalysisFrame(frame, state);
+            cvtColor(analysisFrame, state.frameGray, COLOR_BGR2GRAY);
+            bool edge_result = settings_.edgeEnabled
+                    && DetectChangeEdges(state.edgeChange, state.frameGray);
+            state.frameStats.Update(analysisFrame);
+            bool hist_result = settings_.histogramEnabled && DetectChangeHistogram(state.frameStats);
+            bool cont_result = settings_.contentEnabled && DetectChangeContent(state.frameStats);
+            bool under_threshold = settings_.fadeOutEnabled
+                    && FrameUnderThreshold(state.frameStats.GetNumAboveThreshold(), numPixels_ * 3);
+            return { edge_result || hist_result || cont_result, under_threshold };
+        }
+
+
+        /*
+         * Analyzes frames [begin, end) with an independent capture. The segment is
+         * initialized from the frame before begin, so consecutive segments overlap by one
+         * frame. When lastFrame is given, it is used as the frame before begin instead of
+         * seeking to it. The results stop early if the video ends or a frame can not be read.
+         */
+        std::vector<FrameChange> AnalyzeSegment(const MPFVideoJob &job, const cv::Mat &lastFrame,
+                                                int begin, int end, bool afterAnalyzedFrame) const {
+            std::vector<FrameChange> results;
+            MPFVideoCapture cap(job);
+
+            cv::Mat frame = lastFrame;
+            if (frame.empty()) {
+                if (!cap.SetFramePosition(begin - 1) || !cap.Read(frame)) {
+                    return results;
+                }
+            }
+            else if (!cap.SetFramePosition(begin)) {
+                return results;
+            }
+
+            AnalysisState state = CreateAnalysisState();
+            InitAnalysis(state, frame, afterAnalyzedFrame);
+            for (int frame_index = begin; frame_index < end && cap.Read(frame); frame_index++) {
+                results.push_back(AnalyzeFrame(state, frame));
+            }
+            LOG4CXX_DEBUG(logger_, "Analyzed segment [" << begin << ", "
+                                   << begin + results.size() << ")");
+            return results;
+        }
+
+
+        /*
+         * Calculates the difference in edge pixels between the last two frames.
+         * Returns true when the difference exceeds edgeThreshold.
+         */
+        bool DetectChangeEdges(EdgeChange &edgeChange, const cv::Mat &frameGray) const {
+            return edgeChange.Update(frameGray) > settings_.edgeThreshold;
+        }
+
+
+        /*
+         * Performs histogram comparison between the last two frames.
+         * Returns true when correlation falls below histogramThreshold.
+         */
+        bool DetectChangeHistogram(const FrameStatistics &stats) const {
+            double val = compareHist(stats.GetHistogram(), stats.GetLastHistogram(),
+                                     cv::HISTCMP_CORREL);
+            return val < settings_.histogramThreshold;
+        }
+
+
+        /*
+         * Calculates average difference in HSV values between the last two frames.
+         * Returns true when total average difference exceeds contentThreshold.
+         */
+        bool DetectChangeContent(const FrameStatistics &stats) const {
+            const cv::Scalar &sum_ = stats.GetHsvDeltaSums();
+            double deltaH = sum_[0] / numPixels_;
+            double deltaS = sum_[1] / numPixels_;
+            double deltaV = sum_[2] / numPixels_;
+            double deltaHSVAvg = (deltaH + deltaS + deltaV) / (3.0);
+
+            return deltaHSVAvg > settings_.contentThreshold;
+        }
+
+
+        /*
+         * Checks the number of pixels that are not under the threshold value.
+         * If that number does not exceed minThreshold, the frame is dark and this returns
+         * true.
+         */
+        bool FrameUnderThreshold(int numAboveThreshold, double numPixels) const {
+            int minThreshold = (int)(numPixels * (1.0 - settings_.minDarkFraction));
+            return numAboveThreshold <= minThreshold;
+        }
+    };
+} // end anonymous namespace
+
+
+ShotBoundaryDetector::ShotBoundaryDetector(log4cxx::LoggerPtr logger)
+        : logger_(std::move(logger)) {
+}
+
+
+ShotBoundaryAnalysis ShotBoundaryDetector::Analyze(const MPFVideoJob &job,
+                                                   const ShotBoundarySettings &settings) const {
+    ShotBoundaryIndex index(job, settings, logger_);
+    ShotBoundaryAnalysis analysis;
+    if (index.Load(analysis)) {
+        return analysis;
+    }
+    analysis = RunDetectors(job, settings);
+    // A failed analysis is not saved, since later jobs would load it instead of retrying.
+    if (!analysis.frameSize.empty()) {
+        index.Save(analysis);
+    }
+    return analysis;
+}
+
+
+ShotBoundaryAnalysis ShotBoundaryDetector::RunDetectors(const MPFVideoJob &job,
+                                                        const ShotBoundarySettings &settings) const {
+    // Used to get the frame count and the initialization frame, and to read the frames
+    // when seeking or segmenting.
+    std::optional<MPFVideoCapture> cap(std::in_place, job);
+
+    int frame_count = cap->GetFrameCount();
+    LOG4CXX_DEBUG(logger_, "frame count = " << frame_count);
+
+    // Attempt to use the frame before the start of the segment to initialize the detectors.
+    // If one is not available, use frame 0 and start processing at frame 1. The frames are
+    // copied so that they outlive the capture.
+    std::vector<cv::Mat> init_frames = cap->GetInitializationFramesIfAvailable(1);
+    ShotBoundaryAnalysis analysis;
+    analysis.firstFrameIndex = init_frames.empty() ? 1 : 0;
+
+    JobAnalyzer analyzer(settings, logger_);
+    bool success;
+    if (settings.samplingInterval > 1) {
+        if (settings.parallelSegments > 1) {
+            LOG4CXX_WARN(logger_, "PARALLEL_SEGMENTS is ignored when SAMPLING_INTERVAL is greater than 1.");
+        }
+        success = analyzer.AnalyzeSampled(*cap, init_frames, analysis);
+    }
+    else if (settings.parallelSegments > 1) {
+        success = analyzer.AnalyzeSegments(job, *cap, init_frames, frame_count, analysis);
+    }
+    else {
+        // Close the video before the asynchronous capture opens it again, so that only one
+        // decoder is open while the frames are analyzed.
+        cap.reset();
+        success = analyzer.AnalyzeVideo(job, init_frames, analysis);
+    }
+    if (!success) {
+        return { };
+    }
+    return analysis;
+}
+
+
+/*
+ * The fade out state and shot lengths carry across segment seams and sampled intervals, so
+ * they are applied to the combined results in frame order.
+ */
+std::vector<Shot> ShotBoundaryDetector::GetShots(const ShotBoundaryAnalysis &analysis,
+                                                 const ShotBoundarySettings &settings) {
+    if (analysis.frameSize.empty()) {
+        return { };
+    }
+
+    // Once a frame is under the threshold, every following dark frame is treated as a
+    // change, so fade outs are reported as their own shots.
+    bool fadeOut = false;
+    int frame_index = analysis.firstFrameIndex;
+    int lastFrameNum = 0;
+    std::map<int, int> keyframes;
+    for (const FrameChange &result : analysis.frames) {
+        bool thrs_result = false;
+        if (settings.fadeOutEnabled && result.underThreshold) {
+            thrs_result = fadeOut;
+            fadeOut = true;
+        }
+        if (result.changed || thrs_result) {
+            if (frame_index - lastFrameNum >= settings.minShotLength) {
+                keyframes[frame_index] = lastFrameNum;
+                lastFrameNum = frame_index;
+            }
+        }
+        frame_index++;
+    }
+    keyframes[frame_index] = lastFrameNum;
+
+    std::vector<Shot> shots;
+    for (const auto &kv : keyframes) {
+        Shot shot { kv.second, kv.first - 1, 0, 0 };
+        for (int i = std::max(shot.startFrame, analysis.firstFrameIndex); i <= shot.stopFrame; i++) {
+            const FrameChange &result = analysis.frames.at(i - analysis.firstFrameIndex);
+            // The change on the first frame is the one that started the shot.
+            shot.changedFrameCount += i > shot.startFrame && result.changed;
+            shot.darkFrameCount += result.underThreshold;
+        }
+        shots.push_back(shot);
+    }
+    return shots;
+}
+
+
+std::vector<Shot> ShotBoundaryDetector::FindShots(const MPFVideoJob &job,
+                                                  const ShotBoundarySettings &settings) const {
+    return GetShots(Analyze(job, settings), settings);
+}
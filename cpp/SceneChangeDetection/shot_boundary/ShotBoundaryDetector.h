@@ -0,0 +1,142 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_SHOTBOUNDARYDETECTOR_H
+#define OPENMPF_COMPONENTS_SHOTBOUNDARYDETECTOR_H
+
+#include <string>
+#include <vector>
+
+#include <log4cxx/logger.h>
+
+#include <opencv2/core.hpp>
+
+#include <MPFDetectionObjects.h>
+
+
+/*
+ * Shot boundary detection for SceneChangeDetection, kept separate from the component
+ * interface so that the analysis can be used and tested without a component.
+ *
+ * Frame indices are relative to the job, the same as the positions of an MPFVideoCapture
+ * created for the job, so results can be mapped back to the original video with that
+ * capture's ReverseTransform.
+ */
+
+
+// Settings that determine where shot boundaries are found. The defaults match the
+// SceneChangeDetection descriptor.
+struct ShotBoundarySettings {
+    // EDGE_THRESHOLD: average difference of the edge maps of consecutive frames (0-255).
+    double edgeThreshold = 70;
+    // HIST_THRESHOLD: histogram correlation below which frames differ (0-1).
+    double histogramThreshold = 0.9;
+    // CONT_THRESHOLD: average HSV difference of consecutive frames (0-255).
+    double contentThreshold = 35;
+    // THRS_THRESHOLD: blue channel value at or below which a pixel is dark (0-255).
+    double darkThreshold = 15;
+    // MIN_PERCENT: fraction of dark pixels for a frame to be part of a fade out (0-1).
+    double minDarkFraction = 0.95;
+
+    // DO_EDGE, DO_HIST, DO_CONT, DO_THRS
+    bool edgeEnabled = true;
+    bool histogramEnabled = true;
+    bool contentEnabled = true;
+    bool fadeOutEnabled = true;
+
+    // MIN_SCENECHANGE_LENGTH: minimum number of frames between shot boundaries.
+    int minShotLength = 15;
+
+    // ANALYSIS_MAX_DIMENSION: frames are downscaled to this size before analysis (0 = off).
+    int analysisMaxDimension = 0;
+    // PARALLEL_SEGMENTS: number of segments of the video analyzed concurrently.
+    int parallelSegments = 1;
+    // SAMPLING_INTERVAL: distance between the frames compared before bisecting.
+    int samplingInterval = 1;
+
+    // SHOT_BOUNDARY_CACHE_DIRECTORY: where the sidecar index is kept (empty = no caching).
+    std::string cacheDirectory;
+};
+
+
+// Detector results for one frame that only depend on the frame and its predecessor.
+struct FrameChange {
+    // The edge, histogram, or content detector found a change.
+    bool changed;
+    // The frame is dark enough to be part of a fade out.
+    bool underThreshold;
+};
+
+
+// Per-frame detector results for a job, before the fade out and minimum shot length rules
+// are applied. These do not depend on minShotLength, so they can be reused for any value.
+struct ShotBoundaryAnalysis {
+    // Index of the frame frames[0] belongs to. The frame before it only initializes the
+    // detectors.
+    int firstFrameIndex = 0;
+    // Size of the decoded frames, empty if the video has no frames.
+    cv::Size frameSize;
+    std::vector<FrameChange> frames;
+};
+
+
+struct Shot {
+    int startFrame;
+    // Inclusive.
+    int stopFrame;
+    // Frames after the first where a change was found, but suppressed by minShotLength.
+    int changedFrameCount;
+    // Analyzed frames that were dark enough to be part of a fade out.
+    int darkFrameCount;
+};
+
+
+class ShotBoundaryDetector {
+public:
+    explicit ShotBoundaryDetector(log4cxx::LoggerPtr logger);
+
+    // Runs the detectors on the frames of the job, or loads the results from the sidecar
+    // index when settings.cacheDirectory contains one for the same media and settings.
+    ShotBoundaryAnalysis Analyze(const MPF::COMPONENT::MPFVideoJob &job,
+                                 const ShotBoundarySettings &settings) const;
+
+    // Applies the fade out and minimum shot length rules to get the shots, in frame order.
+    static std::vector<Shot> GetShots(const ShotBoundaryAnalysis &analysis,
+                                      const ShotBoundarySettings &settings);
+
+    // Same as GetShots(Analyze(job, settings), settings).
+    std::vector<Shot> FindShots(const MPF::COMPONENT::MPFVideoJob &job,
+                                const ShotBoundarySettings &settings) const;
+
+private:
+    log4cxx::LoggerPtr logger_;
+
+    ShotBoundaryAnalysis RunDetectors(const MPF::COMPONENT::MPFVideoJob &job,
+                                      const ShotBoundarySettings &settings) const;
+};
+
+
+#endif //OPENMPF_COMPONENTS_SHOTBOUNDARYDETECTOR_H
@@ -0,0 +1,284 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "ShotBoundaryIndex.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include <opencv2/core.hpp>
+
+#include <MPFDetectionException.h>
+#include <MPFInvalidPropertyException.h>
+#include <Utils.h>
+
+
+using namespace MPF::COMPONENT;
+
+
+namespace {
+    // Index format version, increment when the layout or the detectors change.
+    constexpr int INDEX_VERSION = 2;
+
+    // Amount read at a time when hashing the media file.
+    constexpr std::streamsize HASH_BLOCK_SIZE = 1 << 20;
+
+
+    void Fnv1a(uint64_t &hash, const char *data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+    }
+
+
+    /*
+     * Uses the MEDIA_HASH media property when the workflow manager provides it. Otherwise,
+     * the whole file is hashed, so that an index is never used for media that was changed
+     * after it was written. This reads the file once more, which is still much less work
+     * than decoding it.
+     */
+    std::string GetMediaHash(const MPFVideoJob &job) {
+        auto iter = job.media_properties.find("MEDIA_HASH");
+        if (iter != job.media_properties.end() && !iter->second.empty()) {
+            return iter->second;
+        }
+
+        std::ifstream file(job.data_uri, std::ios::binary);
+        if (!file) {
+            throw MPFDetectionException(MPF_COULD_NOT_OPEN_MEDIA,
+                                        "Failed to open \"" + job.data_uri + "\".");
+        }
+        uint64_t hash = 14695981039346656037ULL;
+        uint64_t fileSize = 0;
+        std::vector<char> buffer(HASH_BLOCK_SIZE);
+        while (file) {
+            file.read(buffer.data(), HASH_BLOCK_SIZE);
+            Fnv1a(hash, buffer.data(), file.gcount());
+            fileSize += file.gcount();
+        }
+        if (file.bad()) {
+            throw MPFDetectionException(MPF_COULD_NOT_READ_MEDIA,
+                                        "Failed to read \"" + job.data_uri + "\".");
+        }
+        Fnv1a(hash, reinterpret_cast<const char *>(&fileSize), sizeof(fileSize));
+
+        std::ostringstream hashString;
+        hashString << std::hex << hash;
+        return hashString.str();
+    }
+
+
+    bool IsFrameTransformProperty(const std::string &name) {
+        for (const char *prefix : { "FRAME_INTERVAL", "USE_KEY_FRAMES", "FRAME_RATE_CAP",
+                                    "ROTATION", "HORIZONTAL_FLIP", "AUTO_ROTATE", "AUTO_FLIP",
+                                    "SEARCH_REGION_" }) {
+            if (name.rfind(prefix, 0) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    // The key covers everything that changes which frames are decoded or how they are
+    // analyzed, including the feed-forward track, which limits the frames that
+    // MPFVideoCapture decodes to those of its detections. MIN_SCENECHANGE_LENGTH and
+    // PARALLEL_SEGMENTS are left out because the per-frame results do not depend on them.
+    std::string GetSettingsKey(const MPFVideoJob &job, const ShotBoundarySettings &settings) {
+        std::ostringstream key;
+        key.precision(std::numeric_limits<double>::max_digits10);
+        key << settings.edgeThreshold << '\n'
+            << settings.histogramThreshold << '\n'
+            << settings.contentThreshold << '\n'
+            << settings.darkThreshold << '\n'
+            << settings.minDarkFraction << '\n'
+            << settings.edgeEnabled << settings.histogramEnabled
+            << settings.contentEnabled << settings.fadeOutEnabled << '\n'
+            << settings.analysisMaxDimension << '\n'
+            << settings.samplingInterval << '\n'
+            << job.start_frame << '-' << job.stop_frame << '\n';
+        if (job.has_feed_forward_track) {
+            key << "feed forward " << job.feed_forward_track.start_frame << '-'
+                << job.feed_forward_track.stop_frame << ':';
+            for (const auto &frameLocation : job.feed_forward_track.frame_locations) {
+                key << ' ' << frameLocation.first;
+            }
+            key << '\n';
+        }
+        for (const auto &property : job.job_properties) {
+            if (IsFrameTransformProperty(property.first)) {
+                key << property.first << '=' << property.second << '\n';
+            }
+        }
+        for (const auto &property : job.media_properties) {
+            if (property.first != "MEDIA_HASH") {
+                key << property.first << '=' << property.second << '\n';
+            }
+        }
+        return key.str();
+    }
+
+
+    std::string GetIndexPath(const std::string &cacheDirectory, const std::string &mediaHash,
+                             const std::string &settingsKey) {
+        std::string directory;
+        std::string error = Utils::expandFileName(cacheDirectory, directory);
+        if (!error.empty()) {
+            throw MPFInvalidPropertyException(
+                    "SHOT_BOUNDARY_CACHE_DIRECTORY",
+                    "The value, \"" + cacheDirectory
+                    + "\", could not be expanded due to: " + error);
+        }
+
+        std::error_code errorCode;
+        std::filesystem::create_directories(directory, errorCode);
+        if (errorCode) {
+            throw MPFDetectionException(
+                    MPF_FILE_WRITE_ERROR,
+                    "Failed to create shot boundary cache directory \"" + directory
+                    + "\" due to: " + errorCode.message());
+        }
+
+        std::ostringstream fileName;
+        fileName << "shot-boundaries-" << std::hex << std::hash<std::string>()(mediaHash)
+                 << '-' << std::hash<std::string>()(settingsKey);
+        return directory + '/' + fileName.str() + ".yml";
+    }
+} // end anonymous namespace
+
+
+ShotBoundaryIndex::ShotBoundaryIndex(const MPFVideoJob &job,
+                                     const ShotBoundarySettings &settings,
+                                     log4cxx::LoggerPtr logger)
+        : logger_(std::move(logger)) {
+    if (settings.cacheDirectory.empty()) {
+        return;
+    }
+    std::string mediaHash = GetMediaHash(job);
+    key_ = mediaHash + '\n' + GetSettingsKey(job, settings);
+    path_ = GetIndexPath(settings.cacheDirectory, mediaHash, key_);
+    LOG4CXX_DEBUG(logger_, "Using shot boundary index " << path_);
+}
+
+
+bool ShotBoundaryIndex::Load(ShotBoundaryAnalysis &analysis) const {
+    if (!IsEnabled() || !std::filesystem::exists(path_)) {
+        return false;
+    }
+
+    try {
+        cv::FileStorage fs(path_, cv::FileStorage::READ);
+        if (static_cast<int>(fs["version"]) != INDEX_VERSION
+                || static_cast<std::string>(fs["key"]) != key_) {
+            LOG4CXX_WARN(logger_, "Ignoring shot boundary index " << path_
+                    << " because it was created for different media, settings, or component version.");
+            return false;
+        }
+
+        ShotBoundaryAnalysis loaded;
+        loaded.firstFrameIndex = static_cast<int>(fs["firstFrameIndex"]);
+        fs["frameSize"] >> loaded.frameSize;
+        // Each frame is stored as a byte with the changed flag in bit 0 and the under
+        // threshold flag in bit 1.
+        cv::Mat frames;
+        fs["frames"] >> frames;
+        if (!frames.empty() && (frames.type() != CV_8UC1 || frames.rows != 1)) {
+            LOG4CXX_WARN(logger_, "Ignoring shot boundary index " << path_
+                    << " because it is corrupt.");
+            return false;
+        }
+        loaded.frames.reserve(frames.total());
+        for (int i = 0; i < frames.cols; i++) {
+            uchar bits = frames.at<uchar>(i);
+            loaded.frames.push_back({ (bits & 1) != 0, (bits & 2) != 0 });
+        }
+
+        analysis = std::move(loaded);
+        LOG4CXX_INFO(logger_, "Loaded the results for " << analysis.frames.size()
+                << " frames from shot boundary index " << path_);
+        return true;
+    }
+    catch (const std::exception &ex) {
+        LOG4CXX_WARN(logger_, "Ignoring shot boundary index " << path_
+                << " because it could not be read: " << ex.what());
+        return false;
+    }
+}
+
+
+void ShotBoundaryIndex::Save(const ShotBoundaryAnalysis &analysis) const {
+    if (!IsEnabled()) {
+        return;
+    }
+
+    cv::Mat1b frames(1, static_cast<int>(analysis.frames.size()));
+    for (int i = 0; i < frames.cols; i++) {
+        const FrameChange &frame = analysis.frames[i];
+        frames(i) = static_cast<uchar>(frame.changed | frame.underThreshold << 1);
+    }
+
+    // Write to a temporary file and then rename it so that concurrent jobs never read a
+    // partially written index. Each writer uses its own temporary file, since jobs in other
+    // threads, processes, or containers that share the cache directory may write the same
+    // index at the same time. The last rename wins, and both files have the same contents.
+    std::ostringstream tempSuffix;
+    tempSuffix << ".tmp-" << ::getpid() << '-'
+               << std::hash<std::thread::id>()(std::this_thread::get_id()) << '-'
+               << std::hex << std::random_device()() << ".yml";
+    std::string tempPath = path_.substr(0, path_.size() - 4) + tempSuffix.str();
+    try {
+        {
+            cv::FileStorage fs(tempPath, cv::FileStorage::WRITE_BASE64);
+            fs << "version" << INDEX_VERSION
+               << "key" << key_
+               << "firstFrameIndex" << analysis.firstFrameIndex
+               << "frameSize" << analysis.frameSize
+               << "frames" << frames;
+        }
+        if (std::rename(tempPath.c_str(), path_.c_str()) != 0) {
+            throw std::runtime_error("Failed to rename \"" + tempPath + "\" to \"" + path_ + "\".");
+        }
+        LOG4CXX_DEBUG(logger_, "Saved shot boundary index " << path_);
+    }
+    catch (const std::exception &ex) {
+        std::remove(tempPath.c_str());
+        LOG4CXX_WARN(logger_, "Failed to write shot boundary index " << path_
+                << " due to: " << ex.what());
+    }
+}
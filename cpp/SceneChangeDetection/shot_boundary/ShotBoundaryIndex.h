@@ -0,0 +1,67 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_SHOTBOUNDARYINDEX_H
+#define OPENMPF_COMPONENTS_SHOTBOUNDARYINDEX_H
+
+#include <string>
+
+#include <log4cxx/logger.h>
+
+#include <MPFDetectionObjects.h>
+
+#include "ShotBoundaryDetector.h"
+
+
+/*
+ * Sidecar file holding the per-frame detector results for a piece of media, so that other
+ * jobs on the same media with the same analysis settings do not need to
+ * decode and analyze it again. The file is named after a hash of the media and a hash of
+ * the settings that affect the results, and also stores the full key to guard against hash
+ * collisions.
+ */
+class ShotBoundaryIndex {
+public:
+    ShotBoundaryIndex(const MPF::COMPONENT::MPFVideoJob &job,
+                      const ShotBoundarySettings &settings,
+                      log4cxx::LoggerPtr logger);
+
+    bool IsEnabled() const { return !path_.empty(); }
+
+    // Returns false when there is no usable index for the job.
+    bool Load(ShotBoundaryAnalysis &analysis) const;
+
+    // Failing to save is logged, but not an error, since the index is only an optimization.
+    void Save(const ShotBoundaryAnalysis &analysis) const;
+
+private:
+    log4cxx::LoggerPtr logger_;
+    std::string path_;
+    std::string key_;
+};
+
+
+#endif //OPENMPF_COMPONENTS_SHOTBOUNDARYINDEX_H
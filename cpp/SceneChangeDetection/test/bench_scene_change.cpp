@@ -0,0 +1,196 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "EdgeChange.h"
+#include "FrameStatistics.h"
+
+// Per-frame cost of the histogram, content, and threshold statistics and of the edge detector
+// at 1080p and 4K, using the fused FrameStatistics and EdgeChange passes and the separate
+// OpenCV calls they replace.
+//     ./bench_scene_change --benchmark_filter=Fused
+
+
+namespace {
+    int HIST_SIZE[] = {30, 32};
+    float HRANGES[] = {0, 180};
+    float SRANGES[] = {0, 256};
+    int CHANNELS[] = {0, 1};
+    constexpr double THRESHOLD = 15;
+
+
+    std::vector<cv::Mat> CreateFrames(const benchmark::State &state) {
+        cv::RNG rng(12345);
+        std::vector<cv::Mat> frames;
+        for (int i = 0; i < 2; i++) {
+            cv::Mat frame(static_cast<int>(state.range(1)), static_cast<int>(state.range(0)), CV_8UC3);
+            rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+            frames.push_back(frame);
+        }
+        return frames;
+    }
+
+
+    void BM_FusedFrameStatistics(benchmark::State &state) {
+        std::vector<cv::Mat> frames = CreateFrames(state);
+        FrameStatistics stats(HIST_SIZE, HRANGES, SRANGES);
+        stats.Configure(true, true, true, THRESHOLD);
+        stats.Reset(frames[0]);
+        int frameIdx = 0;
+        for (auto _ : state) {
+            stats.Update(frames[++frameIdx % 2]);
+            benchmark::DoNotOptimize(cv::compareHist(stats.GetHistogram(), stats.GetLastHistogram(),
+                                                     cv::HISTCMP_CORREL));
+            benchmark::DoNotOptimize(stats.GetHsvDeltaSums());
+            benchmark::DoNotOptimize(stats.GetNumAboveThreshold());
+        }
+    }
+    BENCHMARK(BM_FusedFrameStatistics)->Args({1920, 1080})->Args({3840, 2160})
+            ->Unit(benchmark::kMillisecond);
+
+
+    // Same as above, but first downscaling to the given maximum dimension as
+    // ANALYSIS_MAX_DIMENSION does.
+    void BM_DownscaledFrameStatistics(benchmark::State &state) {
+        std::vector<cv::Mat> frames = CreateFrames(state);
+        double scale = state.range(2) / static_cast<double>(std::max(frames[0].cols, frames[0].rows));
+        cv::Size analysisSize(cvRound(frames[0].cols * scale), cvRound(frames[0].rows * scale));
+        cv::Mat analysisFrame;
+        cv::resize(frames[0], analysisFrame, analysisSize, 0, 0, cv::INTER_AREA);
+
+        FrameStatistics stats(HIST_SIZE, HRANGES, SRANGES);
+        stats.Configure(true, true, true, THRESHOLD);
+        stats.Reset(analysisFrame);
+        int frameIdx = 0;
+        for (auto _ : state) {
+            cv::resize(frames[++frameIdx % 2], analysisFrame, analysisSize, 0, 0, cv::INTER_AREA);
+            stats.Update(analysisFrame);
+            benchmark::DoNotOptimize(cv::compareHist(stats.GetHistogram(), stats.GetLastHistogram(),
+                                                     cv::HISTCMP_CORREL));
+            benchmark::DoNotOptimize(stats.GetHsvDeltaSums());
+            benchmark::DoNotOptimize(stats.GetNumAboveThreshold());
+        }
+    }
+    BENCHMARK(BM_DownscaledFrameStatistics)->Args({1920, 1080, 480})->Args({3840, 2160, 480})
+            ->Unit(benchmark::kMillisecond);
+
+
+    void BM_SeparateFrameStatistics(benchmark::State &state) {
+        std::vector<cv::Mat> frames = CreateFrames(state);
+        const float *ranges[] = { HRANGES, SRANGES };
+        cv::Mat lastHist, lastHsv;
+        cv::calcHist(&frames[0], 1, CHANNELS, cv::Mat(), lastHist, 2, HIST_SIZE, ranges, true, false);
+        cv::cvtColor(frames[0], lastHsv, cv::COLOR_BGR2HSV);
+        int frameIdx = 0;
+        for (auto _ : state) {
+            const cv::Mat &frame = frames[++frameIdx % 2];
+
+            cv::Mat hist;
+            cv::calcHist(&frame, 1, CHANNELS, cv::Mat(), hist, 2, HIST_SIZE, ranges, true, false);
+            benchmark::DoNotOptimize(cv::compareHist(hist, lastHist, cv::HISTCMP_CORREL));
+            hist.copyTo(lastHist);
+
+            cv::Mat hsv, diff;
+            cv::cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
+            cv::absdiff(hsv, lastHsv, diff);
+            benchmark::DoNotOptimize(cv::sum(diff));
+            hsv.copyTo(lastHsv);
+
+            int numAbove = 0;
+            std::vector<cv::Mat> channels;
+            cv::split(frame, channels);
+            for (int y = 0; y < frame.rows; y++) {
+                cv::Mat above;
+                cv::compare(channels[0].row(y), cv::Scalar(THRESHOLD), above, cv::CMP_GT);
+                numAbove += cv::countNonZero(above);
+            }
+            benchmark::DoNotOptimize(numAbove);
+        }
+    }
+    BENCHMARK(BM_SeparateFrameStatistics)->Args({1920, 1080})->Args({3840, 2160})
+            ->Unit(benchmark::kMillisecond);
+
+
+    std::vector<cv::Mat> CreateGrayFrames(const benchmark::State &state) {
+        std::vector<cv::Mat> grayFrames;
+        for (const cv::Mat &frame : CreateFrames(state)) {
+            // Smooth the noise so that the frames have a realistic number of edges.
+            cv::Mat gray;
+            cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+            cv::GaussianBlur(gray, gray, cv::Size(0, 0), 4);
+            cv::normalize(gray, gray, 0, 255, cv::NORM_MINMAX);
+            grayFrames.push_back(gray);
+        }
+        return grayFrames;
+    }
+
+
+    void BM_FusedEdgeChange(benchmark::State &state) {
+        std::vector<cv::Mat> grayFrames = CreateGrayFrames(state);
+        EdgeChange edgeChange(5);
+        edgeChange.Reset(grayFrames[0], false);
+        int frameIdx = 0;
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(edgeChange.Update(grayFrames[++frameIdx % 2]));
+        }
+    }
+    BENCHMARK(BM_FusedEdgeChange)->Args({1920, 1080})->Args({3840, 2160})
+            ->Unit(benchmark::kMillisecond);
+
+
+    void BM_SeparateEdgeChange(benchmark::State &state) {
+        std::vector<cv::Mat> grayFrames = CreateGrayFrames(state);
+        cv::Mat dilateKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(11, 11),
+                                                         cv::Point(5, 5));
+        cv::Mat lastFrameEdgeFinal;
+        cv::blur(grayFrames[0], lastFrameEdgeFinal, cv::Size(3, 3));
+        cv::Canny(lastFrameEdgeFinal, lastFrameEdgeFinal, 90, 270, 3);
+        int frameIdx = 0;
+        for (auto _ : state) {
+            const cv::Mat &frameGray = grayFrames[++frameIdx % 2];
+            cv::Mat frameEdges, frameEdgeFinal, edgeDst;
+            cv::blur(frameGray, frameEdges, cv::Size(3, 3));
+            cv::Canny(frameEdges, frameEdges, 90, 270, 3);
+            frameGray.copyTo(frameEdgeFinal, frameEdges);
+            cv::dilate(frameEdgeFinal, frameEdgeFinal, dilateKernel);
+            cv::absdiff(frameEdgeFinal, lastFrameEdgeFinal, edgeDst);
+            benchmark::DoNotOptimize(cv::sum(edgeDst).val[0] / (edgeDst.rows * edgeDst.cols));
+            frameEdges.copyTo(lastFrameEdgeFinal);
+        }
+    }
+    BENCHMARK(BM_SeparateEdgeChange)->Args({1920, 1080})->Args({3840, 2160})
+            ->Unit(benchmark::kMillisecond);
+}
+
+
+BENCHMARK_MAIN();
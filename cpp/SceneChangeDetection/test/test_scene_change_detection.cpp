@@ -24,16 +24,21 @@
  * limitations under the License.                                             *
  ******************************************************************************/
 
+#include <filesystem>
 #include <string>
+#include <vector>
 #include <MPFDetectionComponent.h>
 #include <gtest/gtest.h>
 #include <log4cxx/basicconfigurator.h>
+#include <opencv2/imgproc.hpp>
+#include <MPFVideoCapture.h>
+#include "EdgeChange.h"
+#include "FrameStatistics.h"
 #include "SceneChangeDetection.h"
 
 using namespace MPF::COMPONENT;
 
-MPFVideoJob createSceneJob(const std::string &uri){
-    Properties algorithm_properties;
+MPFVideoJob createSceneJob(const std::string &uri, const Properties &algorithm_properties = {}){
     Properties media_properties;
     std::string job_name("Testing Scene Change");
     MPFVideoJob job(job_name, uri, 0, 251, algorithm_properties, media_properties);
@@ -59,6 +64,36 @@ bool init_logging() {
 bool logging_initialized = init_logging();
 
 
+void assertSameScenes(const std::vector<MPFVideoTrack> &expected,
+                      const std::vector<MPFVideoTrack> &actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(expected[i].start_frame, actual[i].start_frame) << "scene " << i;
+        ASSERT_EQ(expected[i].stop_frame, actual[i].stop_frame) << "scene " << i;
+        ASSERT_EQ(expected[i].frame_locations.size(), actual[i].frame_locations.size());
+        auto expectedLoc = expected[i].frame_locations.begin();
+        auto actualLoc = actual[i].frame_locations.begin();
+        for (; expectedLoc != expected[i].frame_locations.end(); ++expectedLoc, ++actualLoc) {
+            ASSERT_EQ(expectedLoc->first, actualLoc->first);
+            ASSERT_EQ(expectedLoc->second.width, actualLoc->second.width);
+            ASSERT_EQ(expectedLoc->second.height, actualLoc->second.height);
+        }
+    }
+}
+
+
+std::vector<MPFVideoTrack> runSceneJob(const Properties &props) {
+    // Job properties are kept by the component between jobs, so use a new instance each time.
+    SceneChangeDetection scenechange;
+    scenechange.SetRunDirectory("../plugin");
+    EXPECT_TRUE(scenechange.Init());
+    std::vector<MPFVideoTrack> tracks
+            = scenechange.GetDetections(createSceneJob("data/scene_change.mp4", props));
+    EXPECT_TRUE(scenechange.Close());
+    return tracks;
+}
+
+
 TEST(SCENECHANGE, VideoTest) {
 
     SceneChangeDetection scenechange;
@@ -67,3 +102,276 @@ TEST(SCENECHANGE, VideoTest) {
     assertScenesDetected(2,"data/scene_change.mp4", scenechange);
     ASSERT_TRUE(scenechange.Close());
 }
+
+
+void assertStatisticsMatchOpenCV(const cv::Mat &lastFrame, const cv::Mat &frame, double threshold) {
+    int histSize[] = {30, 32};
+    float hranges[] = {0, 180};
+    float sranges[] = {0, 256};
+    const float* ranges[] = { hranges, sranges };
+    int channels[] = {0, 1};
+
+    FrameStatistics stats(histSize, hranges, sranges);
+    stats.Configure(true, true, true, threshold);
+    stats.Reset(lastFrame);
+    stats.Update(frame);
+
+    cv::Mat expectedHist, expectedLastHist;
+    cv::calcHist(&frame, 1, channels, cv::Mat(), expectedHist, 2, histSize, ranges, true, false);
+    cv::calcHist(&lastFrame, 1, channels, cv::Mat(), expectedLastHist, 2, histSize, ranges, true, false);
+    ASSERT_EQ(0, cv::norm(expectedHist, stats.GetHistogram(), cv::NORM_INF));
+    ASSERT_EQ(0, cv::norm(expectedLastHist, stats.GetLastHistogram(), cv::NORM_INF));
+    ASSERT_EQ(cv::compareHist(expectedHist, expectedLastHist, cv::HISTCMP_CORREL),
+              cv::compareHist(stats.GetHistogram(), stats.GetLastHistogram(), cv::HISTCMP_CORREL));
+
+    cv::Mat hsv, lastHsv, diff;
+    cv::cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
+    cv::cvtColor(lastFrame, lastHsv, cv::COLOR_BGR2HSV);
+    cv::absdiff(hsv, lastHsv, diff);
+    cv::Scalar expectedSums = cv::sum(diff);
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(expectedSums[i], stats.GetHsvDeltaSums()[i]);
+    }
+
+    std::vector<cv::Mat> bgr;
+    cv::split(frame, bgr);
+    cv::Mat above;
+    cv::compare(bgr[0], cv::Scalar(threshold), above, cv::CMP_GT);
+    ASSERT_EQ(cv::countNonZero(above), stats.GetNumAboveThreshold());
+}
+
+
+TEST(SCENECHANGE, FrameStatisticsMatchOpenCV) {
+    cv::RNG rng(12345);
+    // Odd width so the SIMD loops also have a scalar tail.
+    cv::Mat lastFrame(71, 97, CV_8UC3), frame(71, 97, CV_8UC3);
+    rng.fill(lastFrame, cv::RNG::UNIFORM, 0, 256);
+    rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+    for (double threshold : {-1.0, 0.0, 15.0, 15.5, 179.9, 255.0, 300.0}) {
+        assertStatisticsMatchOpenCV(lastFrame, frame, threshold);
+    }
+
+    MPFVideoCapture capture(createSceneJob("data/scene_change.mp4"));
+    cv::Mat videoLastFrame, videoFrame;
+    ASSERT_TRUE(capture.Read(videoLastFrame));
+    for (int i = 0; i < 10 && capture.Read(videoFrame); i++) {
+        assertStatisticsMatchOpenCV(videoLastFrame, videoFrame, 15);
+        videoFrame.copyTo(videoLastFrame);
+    }
+}
+
+
+// The edge detector as it was written with separate OpenCV calls.
+double expectedEdgeChange(const cv::Mat &frameGray, cv::Mat &lastFrameEdgeFinal,
+                          const cv::Mat &dilateKernel) {
+    cv::Mat frameEdges, frameEdgeFinal, edgeDst;
+    cv::blur(frameGray, frameEdges, cv::Size(3, 3));
+    cv::Canny(frameEdges, frameEdges, 90, 270, 3);
+    frameGray.copyTo(frameEdgeFinal, frameEdges);
+    cv::dilate(frameEdgeFinal, frameEdgeFinal, dilateKernel);
+    cv::absdiff(frameEdgeFinal, lastFrameEdgeFinal, edgeDst);
+    double deltaEdges = cv::sum(edgeDst).val[0] / (edgeDst.rows * edgeDst.cols);
+    frameEdges.copyTo(lastFrameEdgeFinal);
+    return deltaEdges;
+}
+
+
+void assertEdgeChangeMatchesOpenCV(const std::vector<cv::Mat> &grayFrames, int radius,
+                                   bool afterAnalyzedFrame) {
+    cv::Mat dilateKernel = cv::getStructuringElement(
+            cv::MORPH_RECT, cv::Size(2 * radius + 1, 2 * radius + 1), cv::Point(radius, radius));
+
+    cv::Mat lastFrameEdgeFinal;
+    cv::blur(grayFrames[0], lastFrameEdgeFinal, cv::Size(3, 3));
+    cv::Canny(lastFrameEdgeFinal, lastFrameEdgeFinal, 90, 270, 3);
+    if (!afterAnalyzedFrame) {
+        cv::Mat edges = lastFrameEdgeFinal;
+        lastFrameEdgeFinal = cv::Mat();
+        grayFrames[0].copyTo(lastFrameEdgeFinal, edges);
+        cv::dilate(lastFrameEdgeFinal, lastFrameEdgeFinal, dilateKernel);
+    }
+
+    EdgeChange edgeChange(radius);
+    edgeChange.Reset(grayFrames[0], afterAnalyzedFrame);
+    for (size_t i = 1; i < grayFrames.size(); i++) {
+        ASSERT_EQ(expectedEdgeChange(grayFrames[i], lastFrameEdgeFinal, dilateKernel),
+                  edgeChange.Update(grayFrames[i])) << "frame " << i << " radius " << radius;
+    }
+}
+
+
+TEST(SCENECHANGE, EdgeChangeMatchesOpenCV) {
+    cv::RNG rng(12345);
+    std::vector<cv::Mat> randomFrames;
+    for (int i = 0; i < 3; i++) {
+        // Odd width so the SIMD loops also have a scalar tail. Blocks of constant color give
+        // Canny some edges to find.
+        cv::Mat frame(71, 97, CV_8UC1);
+        rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+        cv::resize(frame, frame, cv::Size(), 1.0 / 8, 1.0 / 8, cv::INTER_AREA);
+        cv::resize(frame, frame, cv::Size(97, 71), 0, 0, cv::INTER_NEAREST);
+        randomFrames.push_back(frame);
+    }
+
+    std::vector<cv::Mat> videoFrames;
+    MPFVideoCapture capture(createSceneJob("data/scene_change.mp4"));
+    cv::Mat videoFrame;
+    for (int i = 0; i < 10 && capture.Read(videoFrame); i++) {
+        cv::Mat gray;
+        cv::cvtColor(videoFrame, gray, cv::COLOR_BGR2GRAY);
+        videoFrames.push_back(gray);
+    }
+    ASSERT_EQ(10, videoFrames.size());
+
+    // Radius 5 is the 11x11 kernel, the others are used with ANALYSIS_MAX_DIMENSION.
+    for (int radius : {0, 1, 2, 3, 5, 7}) {
+        for (bool afterAnalyzedFrame : {false, true}) {
+            assertEdgeChangeMatchesOpenCV(randomFrames, radius, afterAnalyzedFrame);
+            assertEdgeChangeMatchesOpenCV(videoFrames, radius, afterAnalyzedFrame);
+        }
+    }
+}
+
+
+TEST(SCENECHANGE, DownscaledAnalysisFindsSameScenes) {
+    SceneChangeDetection scenechange;
+    scenechange.SetRunDirectory("../plugin");
+    ASSERT_TRUE(scenechange.Init());
+
+    std::vector<MPFVideoTrack> fullResolution
+            = scenechange.GetDetections(createSceneJob("data/scene_change.mp4"));
+    ASSERT_EQ(2, fullResolution.size());
+
+    for (const std::string &maxDimension : {"320", "240"}) {
+        Properties props { { "ANALYSIS_MAX_DIMENSION", maxDimension } };
+        std::vector<MPFVideoTrack> downscaled
+                = scenechange.GetDetections(createSceneJob("data/scene_change.mp4", props));
+        assertSameScenes(fullResolution, downscaled);
+    }
+    ASSERT_TRUE(scenechange.Close());
+}
+
+
+TEST(SCENECHANGE, ParallelSegmentsMatchSerial) {
+    for (const std::string &useMiddleFrame : {"true", "false"}) {
+        // A short minimum scene length so that changes near the segment seams are reported.
+        for (const std::string &minScene : {"15", "1"}) {
+            Properties props {
+                    { "USE_MIDDLE_FRAME", useMiddleFrame },
+                    { "MIN_SCENECHANGE_LENGTH", minScene } };
+            std::vector<MPFVideoTrack> serial = runSceneJob(props);
+            ASSERT_FALSE(serial.empty());
+
+            for (const std::string &numSegments : {"2", "3", "7"}) {
+                props["PARALLEL_SEGMENTS"] = numSegments;
+                assertSameScenes(serial, runSceneJob(props));
+            }
+        }
+    }
+}
+
+
+TEST(SCENECHANGE, SampledMatchesExhaustive) {
+    for (const std::string &useMiddleFrame : {"true", "false"}) {
+        Properties props { { "USE_MIDDLE_FRAME", useMiddleFrame } };
+        std::vector<MPFVideoTrack> exhaustive = runSceneJob(props);
+        ASSERT_EQ(2, exhaustive.size());
+
+        // Both scenes in the sample video are much longer than the sampling intervals, so
+        // no scene change may be missed.
+        for (const std::string &interval : {"2", "5", "8", "13"}) {
+            props["SAMPLING_INTERVAL"] = interval;
+            assertSameScenes(exhaustive, runSceneJob(props));
+        }
+    }
+}
+
+
+TEST(SCENECHANGE, CompactSceneOutput) {
+    Properties props { { "USE_MIDDLE_FRAME", "false" }, { "COMPACT_SCENE_OUTPUT", "false" } };
+    std::vector<MPFVideoTrack> allFrames = runSceneJob(props);
+    ASSERT_EQ(2, allFrames.size());
+
+    props["COMPACT_SCENE_OUTPUT"] = "true";
+    std::vector<MPFVideoTrack> compact = runSceneJob(props);
+    props["SCENE_FRAME_STRIDE"] = "10";
+    std::vector<MPFVideoTrack> strided = runSceneJob(props);
+    ASSERT_EQ(allFrames.size(), compact.size());
+    ASSERT_EQ(allFrames.size(), strided.size());
+
+    for (size_t i = 0; i < allFrames.size(); i++) {
+        const MPFVideoTrack &track = compact[i];
+        int start = allFrames[i].start_frame;
+        int stop = allFrames[i].stop_frame;
+        ASSERT_EQ(stop - start + 1, allFrames[i].frame_locations.size());
+        ASSERT_EQ(start, track.start_frame);
+        ASSERT_EQ(stop, track.stop_frame);
+
+        ASSERT_EQ(3, track.frame_locations.size());
+        ASSERT_EQ(1, track.frame_locations.count(start));
+        ASSERT_EQ(1, track.frame_locations.count(start + (stop + 1 - start) / 2));
+        ASSERT_EQ(1, track.frame_locations.count(stop));
+        ASSERT_EQ(std::to_string(stop - start + 1),
+                  track.detection_properties.at("SCENE FRAME COUNT"));
+        ASSERT_TRUE(track.detection_properties.count("SCENE CHANGED FRAME COUNT"));
+        ASSERT_TRUE(track.detection_properties.count("SCENE DARK FRAME COUNT"));
+
+        for (int frame = start; frame <= stop; frame += 10) {
+            ASSERT_EQ(1, strided[i].frame_locations.count(frame));
+        }
+        ASSERT_LE(strided[i].frame_locations.size(), (stop - start) / 10 + 3);
+    }
+}
+
+
+TEST(SCENECHANGE, ShotBoundaryCacheIsReused) {
+    std::string cacheDir = "shot-boundary-cache-test";
+    std::filesystem::remove_all(cacheDir);
+    auto numCacheFiles = [&] {
+        return std::distance(std::filesystem::directory_iterator(cacheDir),
+                             std::filesystem::directory_iterator());
+    };
+
+    Properties props;
+    std::vector<MPFVideoTrack> uncached = runSceneJob(props);
+
+    props["SHOT_BOUNDARY_CACHE_DIRECTORY"] = cacheDir;
+    assertSameScenes(uncached, runSceneJob(props));
+    ASSERT_EQ(1, numCacheFiles());
+    assertSameScenes(uncached, runSceneJob(props));
+    ASSERT_EQ(1, numCacheFiles());
+
+    // The minimum scene length is applied after the per-frame results are loaded.
+    props["MIN_SCENECHANGE_LENGTH"] = "1";
+    std::vector<MPFVideoTrack> shortScenes = runSceneJob(props);
+    ASSERT_EQ(1, numCacheFiles());
+    props.erase("SHOT_BOUNDARY_CACHE_DIRECTORY");
+    assertSameScenes(runSceneJob(props), shortScenes);
+
+    // Detector settings are part of the cache key.
+    props["SHOT_BOUNDARY_CACHE_DIRECTORY"] = cacheDir;
+    props["EDGE_THRESHOLD"] = "50";
+    runSceneJob(props);
+    ASSERT_EQ(2, numCacheFiles());
+
+    std::filesystem::remove_all(cacheDir);
+}
+
+
+TEST(SCENECHANGE, FailedAnalysisIsNotCached) {
+    std::string cacheDir = "shot-boundary-cache-failure-test";
+    std::filesystem::remove_all(cacheDir);
+
+    // The video has 252 frames, so none of the job's frames can be read.
+    Properties props { { "SHOT_BOUNDARY_CACHE_DIRECTORY", cacheDir } };
+    MPFVideoJob job("Testing Scene Change", "data/scene_change.mp4", 1000, 1100, props, { });
+    SceneChangeDetection scenechange;
+    scenechange.SetRunDirectory("../plugin");
+    ASSERT_TRUE(scenechange.Init());
+    ASSERT_TRUE(scenechange.GetDetections(job).empty());
+    ASSERT_TRUE(scenechange.Close());
+
+    ASSERT_TRUE(!std::filesystem::exists(cacheDir) || std::filesystem::is_empty(cacheDir));
+
+    std::filesystem::remove_all(cacheDir);
+}
@@ -28,9 +28,8 @@
 
 #include <algorithm>
 #include <cmath>
-#include <future>
 #include <iostream>
-#include <random>
+#include <list>
 
 #include <boost/regex.hpp>
 #include <boost/locale.hpp>
@@ -49,10 +48,13 @@
 #include <tesseract/unicharset.h>
 
 #include <detectionComponentUtils.h>
+#include <frame_transformers/FrameTransformerFactory.h>
 #include <MPFSimpleConfigLoader.h>
 #include <MPFVideoCapture.h>
 #include <Utils.h>
 
+#include "WorkQueue.h"
+
 
 using namespace MPF;
 using namespace COMPONENT;
@@ -67,29 +69,6 @@ typedef boost::multi_index::multi_index_container<string,
         >> unique_vector;
 
 
-class TempDirectory {
-public:
-    const string path;
-
-    explicit TempDirectory(const string &path)
-            : path(path) {
-        bool created = boost::filesystem::create_directories(path);
-        if (!created) {
-            throw MPFDetectionException(
-                    MPF_FILE_WRITE_ERROR,
-                    "Unable to write temporary directory (may already exist): " + path);
-        }
-    }
-
-    ~TempDirectory() {
-        boost::filesystem::remove_all(path);
-    }
-
-    TempDirectory(const TempDirectory&) = delete;
-    TempDirectory& operator=(const TempDirectory&) = delete;
-};
-
-
 bool TesseractOCRTextDetection::Init() {
     // Set global C++ locale.
     // Required for boost function calls.
@@ -116,6 +95,7 @@ bool TesseractOCRTextDetection::Init() {
     LOG4CXX_DEBUG(hw_logger_, "Plugin path: " << plugin_path);
     LOG4CXX_INFO(hw_logger_, "Initializing TesseractOCRTextDetection");
     set_default_parameters();
+    tess_api_pool.reset(new TessApiPool());
 
     LOG4CXX_INFO(hw_logger_, "INITIALIZED COMPONENT.");
     return true;
@@ -175,6 +155,7 @@ void TesseractOCRTextDetection::set_default_parameters() {
     default_ocr_fset.enable_osd_fallback = true;
     default_ocr_fset.max_parallel_ocr_threads = 4;
     default_ocr_fset.max_parallel_pdf_threads = 4;
+    default_ocr_fset.max_pooled_model_mb = 1024;
 }
 
 
@@ -251,30 +232,6 @@ set<string> generate_lang_set(const string& input) {
 }
 
 
-/*
- * Generate a random alphanumeric string of specified length.
- * Used to generate image placeholders.
- */
-string random_string(size_t length) {
-    static auto &chrs = "0123456789"
-                        "abcdefghijklmnopqrstuvwxyz"
-                        "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-
-    thread_local static std::mt19937 rg{random_device{}()};
-    thread_local static uniform_int_distribution<string::size_type> pick(0, sizeof(chrs) - 2);
-
-    string s;
-
-    s.reserve(length);
-
-    while (length--) {
-        s += chrs[pick(rg)];
-    }
-    ostringstream stp;
-    stp << ::getpid();
-    return s + stp.str();
-}
-
 /*
  * Preprocess image before running OSD and OCR.
  */
@@ -463,7 +420,7 @@ void TesseractOCRTextDetection::process_tesseract_lang_model(OCR_job_inputs &inp
 
     bool tess_api_in_map = inputs.tess_api_map->find(tess_api_key) != inputs.tess_api_map->end();
     string tessdata_dir;
-    unique_ptr<TessApiWrapper> tess_api_for_parallel;
+    TessApiPool::Lease tess_api_for_parallel;
     set<string> languages_found, missing_languages;
     // If running OSD scripts, set tessdata_dir to the location found during OSD processing.
     // Otherwise, for each individual language setting, locate the appropriate tessdata directory.
@@ -485,10 +442,10 @@ void TesseractOCRTextDetection::process_tesseract_lang_model(OCR_job_inputs &inp
         }
 
         if (inputs.parallel_processing) {
-            // When parallel processing is enabled, new APIs must be started up to avoid deadlocking issues rather than
-            // using globally initialized APIs.
-            tess_api_for_parallel.reset(
-                    new TessApiWrapper(tessdata_dir, results.lang, (tesseract::OcrEngineMode) inputs.ocr_fset->oem));
+            // When parallel processing is enabled, each run must use its own API to avoid deadlocking issues rather
+            // than using globally initialized APIs. The API is returned to the pool for later runs when the run ends.
+            tess_api_for_parallel = inputs.tess_api_pool->Acquire(
+                    tessdata_dir, results.lang, (tesseract::OcrEngineMode) inputs.ocr_fset->oem);
         }
         else if (!tess_api_in_map) {
             inputs.tess_api_map->emplace(
@@ -524,41 +481,23 @@ void TesseractOCRTextDetection::process_tesseract_lang_model(OCR_job_inputs &inp
 void TesseractOCRTextDetection::process_parallel_image_runs(OCR_job_inputs &inputs,
                                                             Image_results &results) {
 
-    OCR_results ocr_results[inputs.ocr_lang_inputs.size()];
-    future<void> ocr_threads[inputs.ocr_lang_inputs.size()];
-    int index = 0;
-    set<int> active_threads;
-
-    // Initialize a new track for each language specified.
-    for (const string &lang: inputs.ocr_lang_inputs) {
-        ocr_results[index].lang = lang;
-        ocr_threads[index] = async(launch::async,
-                                        &process_tesseract_lang_model,
-                                        ref(inputs),
-                                        ref(ocr_results[index]));
-        active_threads.insert(index);
-        index++;
-        while (active_threads.size() >= inputs.ocr_fset->max_parallel_ocr_threads) {
-            this_thread::sleep_for(chrono::seconds(1));
-            for (auto active_thread_iter = active_threads.begin(); active_thread_iter != active_threads.end();
-                /* Intentionally no ++ to support erasing. */) {
-                int i = *active_thread_iter;
-                if (ocr_threads[i].wait_for(chrono::milliseconds(0)) == future_status::ready) {
-                    // Will re-throw exception from thread.
-                    ocr_threads[i].get();
-                    active_thread_iter = active_threads.erase(active_thread_iter);
-                }
-                else {
-                    ++active_thread_iter;
-                }
-            }
+    vector<OCR_results> ocr_results(inputs.ocr_lang_inputs.size());
+    {
+        // Declared after the results, so that the workers stop before the results are destroyed.
+        WorkQueue work_queue(min<int>(inputs.ocr_fset->max_parallel_ocr_threads, ocr_results.size()));
+        int index = 0;
+
+        // Initialize a new track for each language specified.
+        for (const string &lang: inputs.ocr_lang_inputs) {
+            OCR_results &ocr_res = ocr_results[index];
+            ocr_res.lang = lang;
+            // Will re-throw exception from a failed run.
+            work_queue.Add([&inputs, &ocr_res] { process_tesseract_lang_model(inputs, ocr_res); });
+            index++;
         }
-    }
 
-    // Wait for all remaining threads to finish.
-    for (const int &i: active_threads) {
-        // Will re-throw exception from thread.
-        ocr_threads[i].get();
+        // Will re-throw exception from a failed run.
+        work_queue.Wait();
     }
 
     for (OCR_results &ocr_res: ocr_results) {
@@ -1148,6 +1087,12 @@ TesseractOCRTextDetection::load_settings(const MPFJob &job, OCR_filter_settings
     ocr_fset.enable_osd_fallback = DetectionComponentUtils::GetProperty<bool>(job.job_properties,"ENABLE_OSD_FALLBACK", default_ocr_fset.enable_osd_fallback);
     ocr_fset.max_parallel_ocr_threads = DetectionComponentUtils::GetProperty<int>(job.job_properties, "MAX_PARALLEL_SCRIPT_THREADS", default_ocr_fset.max_parallel_ocr_threads);
     ocr_fset.max_parallel_pdf_threads = DetectionComponentUtils::GetProperty<int>(job.job_properties, "MAX_PARALLEL_PAGE_THREADS", default_ocr_fset.max_parallel_pdf_threads);
+    ocr_fset.max_pooled_model_mb = DetectionComponentUtils::GetProperty<int>(job.job_properties, "MAX_POOLED_MODEL_MB", default_ocr_fset.max_pooled_model_mb);
+
+    // Each parallel run holds one engine, so there is no use in keeping more idle engines for a language than
+    // there are threads.
+    tess_api_pool->SetLimits(max({ocr_fset.max_parallel_ocr_threads, ocr_fset.max_parallel_pdf_threads, 1}),
+                             static_cast<size_t>(max(ocr_fset.max_pooled_model_mb, 0)) * 1024 * 1024);
 
     // Tessdata setup
     ocr_fset.model_dir =  DetectionComponentUtils::GetProperty<string>(job.job_properties, "MODELS_DIR_PATH", default_ocr_fset.model_dir);
@@ -1429,6 +1374,7 @@ vector<MPFImageLocation> TesseractOCRTextDetection::process_image_job(const MPFJ
     ocr_job_inputs.process_pdf = false;
     ocr_job_inputs.hw_logger_ = hw_logger_;
     ocr_job_inputs.tess_api_map = &tess_api_map;
+    ocr_job_inputs.tess_api_pool = tess_api_pool.get();
 
     Image_results image_results;
     get_tesseract_detections(ocr_job_inputs, image_results);
@@ -1523,74 +1469,88 @@ vector<MPFImageLocation> TesseractOCRTextDetection::process_image_job(const MPFJ
 
 void TesseractOCRTextDetection::process_parallel_pdf_pages(PDF_page_inputs &page_inputs,
                                                            PDF_page_results &page_results) {
-    PDF_thread_variables thread_var[page_inputs.filelist.size()];
-    future<void> pdf_threads[page_inputs.filelist.size()];
+    // The page count is not known until the last page is read. Deques are used so that each
+    // page's variables stay in place while more pages are added.
+    deque<PDF_thread_variables> thread_var;
+    // Each page is OCRed once per language, and every run is a separate task, so a page with
+    // several languages is spread over several threads.
+    // Declared after the page variables, so that the workers stop before the pages are destroyed.
+    WorkQueue work_queue(page_inputs.ocr_fset.max_parallel_pdf_threads);
     int index = 0;
-    set<int> active_threads;
-
-    for (const string &filename : page_inputs.filelist) {
-        MPFImageJob c_job((*page_inputs.job).job_name,
-                          filename,
-                          (*page_inputs.job).job_properties,
-                          (*page_inputs.job).media_properties);
 
-        MPFImageReader image_reader(c_job);
-        thread_var[index].image = image_reader.GetImage();
-        preprocess_image(c_job, thread_var[index].image, page_inputs.ocr_fset);
-
-        thread_var[index].osd_track_results = MPFGenericTrack(-1.0);
-        thread_var[index].tessdata_script_dir = "";
+    MPFImageJob c_job((*page_inputs.job).job_name,
+                      (*page_inputs.job).data_uri,
+                      (*page_inputs.job).job_properties,
+                      (*page_inputs.job).media_properties);
+
+    cv::Mat page;
+    while (page_inputs.pages->Next(page)) {
+        thread_var.emplace_back();
+        PDF_thread_variables &page_var = thread_var[index];
+        page_var.image = page;
+        page.release();
+        preprocess_image(c_job, page_var.image, page_inputs.ocr_fset);
+
+        page_var.osd_track_results = MPFGenericTrack(-1.0);
+        page_var.tessdata_script_dir = "";
         if (page_inputs.ocr_fset.enable_osd) {
             OSBestResult os_best_result;
             // Reset to original specified language before processing OSD.
             page_inputs.ocr_fset.tesseract_lang = page_inputs.default_lang;
             set<string> missing_languages;
-            get_OSD(os_best_result, thread_var[index].image, c_job, page_inputs.ocr_fset, thread_var[index].osd_track_results.detection_properties,
-                    thread_var[index].tessdata_script_dir, missing_languages);
+            get_OSD(os_best_result, page_var.image, c_job, page_inputs.ocr_fset, page_var.osd_track_results.detection_properties,
+                    page_var.tessdata_script_dir, missing_languages);
             page_results.all_missing_languages.insert(missing_languages.begin(), missing_languages.end());
         }
         else {
             // If OSD is not run, the image won't be rescaled yet.
-            rescale_image(c_job, thread_var[index].image, page_inputs.ocr_fset);
-        }
-
-        thread_var[index].lang = page_inputs.ocr_fset.tesseract_lang;
-        thread_var[index].ocr_input.job_name = &(*page_inputs.job).job_name;
-        thread_var[index].ocr_input.run_dir = &page_inputs.run_dir;
-        thread_var[index].ocr_input.ocr_fset = &page_inputs.ocr_fset;
-        thread_var[index].ocr_input.process_pdf = true;
-        thread_var[index].ocr_input.hw_logger_ = hw_logger_;
-        thread_var[index].ocr_input.tess_api_map = &tess_api_map;
-        pdf_threads[index] = async(launch::async,
-                                        &get_tesseract_detections,
-                                        ref(thread_var[index].ocr_input),
-                                        ref(thread_var[index].page_thread_res));
-        active_threads.insert(index);
-        index ++;
-        while (active_threads.size() >= page_inputs.ocr_fset.max_parallel_pdf_threads) {
-            this_thread::sleep_for(chrono::seconds(1));
-            for (auto active_thread_iter = active_threads.begin(); active_thread_iter != active_threads.end();
-                /* Intentionally no ++ to support erasing. */) {
-                int i = *active_thread_iter;
-                if (pdf_threads[i].wait_for(chrono::milliseconds(0)) == future_status::ready) {
-                    // Will re-throw exception from thread.
-                    pdf_threads[i].get();
-                    active_thread_iter = active_threads.erase(active_thread_iter);
-                }
-                else {
-                    ++active_thread_iter;
+            rescale_image(c_job, page_var.image, page_inputs.ocr_fset);
+        }
+
+        page_var.lang = page_inputs.ocr_fset.tesseract_lang;
+        page_var.ocr_input.job_name = &(*page_inputs.job).job_name;
+        page_var.ocr_input.run_dir = &page_inputs.run_dir;
+        page_var.ocr_input.ocr_fset = &page_inputs.ocr_fset;
+        page_var.ocr_input.process_pdf = true;
+        // Disable usage of global tesseract APIs during parallel processing of PDF images.
+        page_var.ocr_input.parallel_processing = true;
+        page_var.ocr_input.hw_logger_ = hw_logger_;
+        page_var.ocr_input.tess_api_map = &tess_api_map;
+        page_var.ocr_input.tess_api_pool = tess_api_pool.get();
+        page_var.ocr_input.ocr_lang_inputs = generate_lang_set(page_var.lang);
+
+        page_var.lang_results.resize(page_var.ocr_input.ocr_lang_inputs.size());
+        page_var.remaining_runs = page_var.lang_results.size();
+        int lang_index = 0;
+        for (const string &lang : page_var.ocr_input.ocr_lang_inputs) {
+            OCR_results &ocr_res = page_var.lang_results[lang_index];
+            ocr_res.lang = lang;
+            // Blocks until a thread is free, so only the pages being OCRed are held in memory.
+            // Will re-throw exception from a failed run.
+            work_queue.Add([&page_var, &ocr_res] {
+                process_tesseract_lang_model(page_var.ocr_input, ocr_res);
+                if (--page_var.remaining_runs == 0) {
+                    // Only the page's results are needed from here on.
+                    page_var.image.release();
                 }
-            }
+            });
+            lang_index++;
         }
+        index++;
     }
 
-    // Wait for all remaining threads to finish.
-    for (const int &i: active_threads) {
-        // Will re-throw exception from thread.
-        pdf_threads[i].get();
-    }
+    // Wait for all remaining runs to finish.
+    // Will re-throw exception from a failed run.
+    work_queue.Wait();
+
+    for (index = 0; index < thread_var.size(); index++ ) {
+        for (const OCR_results &ocr_res : thread_var[index].lang_results) {
+            LOG4CXX_DEBUG(hw_logger_, "Tesseract run successful.");
+            wstring t_detection = boost::locale::conv::utf_to_utf<wchar_t>(ocr_res.text_result);
 
-    for (index = 0; index < page_inputs.filelist.size(); index++ ) {
+            OCR_output output_ocr = {ocr_res.confidence, ocr_res.lang, t_detection, "", false};
+            thread_var[index].page_thread_res.detections_by_lang.push_back(output_ocr);
+        }
 
         // If max_text_tracks is set, filter out to return only the top specified tracks.
         if (page_inputs.ocr_fset.max_text_tracks > 0) {
@@ -1618,13 +1578,12 @@ void TesseractOCRTextDetection::process_parallel_pdf_pages(PDF_page_inputs &page
 void TesseractOCRTextDetection::process_serial_pdf_pages(PDF_page_inputs &page_inputs,
                                                          PDF_page_results &page_results) {
     int page_num = 0;
-    for (const string &filename : page_inputs.filelist) {
-        MPFImageJob c_job((*page_inputs.job).job_name,
-                          filename,
-                          (*page_inputs.job).job_properties,
-                          (*page_inputs.job).media_properties);
-        MPFImageReader image_reader(c_job);
-        cv::Mat image_data = image_reader.GetImage();
+    MPFImageJob c_job((*page_inputs.job).job_name,
+                      (*page_inputs.job).data_uri,
+                      (*page_inputs.job).job_properties,
+                      (*page_inputs.job).media_properties);
+    cv::Mat image_data;
+    while (page_inputs.pages->Next(image_data)) {
         preprocess_image(c_job, image_data, page_inputs.ocr_fset);
 
         MPFGenericTrack osd_track_results(-1);
@@ -1662,6 +1621,7 @@ void TesseractOCRTextDetection::process_serial_pdf_pages(PDF_page_inputs &page_i
         ocr_job_inputs.process_pdf = true;
         ocr_job_inputs.hw_logger_ = hw_logger_;
         ocr_job_inputs.tess_api_map = &tess_api_map;
+        ocr_job_inputs.tess_api_pool = tess_api_pool.get();
 
         Image_results image_results;
         get_tesseract_detections(ocr_job_inputs, image_results);
@@ -1703,11 +1663,6 @@ vector<MPFGenericTrack> TesseractOCRTextDetection::GetDetections(const MPFGeneri
         load_settings(job, page_inputs.ocr_fset);
         load_image_preprocessing_settings(job, page_inputs.ocr_fset);
 
-        vector<string> job_names;
-        boost::split(job_names, job.job_name, boost::is_any_of(":"));
-        string job_name = boost::ireplace_all_copy(job_names[0], "job", "");
-        boost::trim(job_name);
-
         page_inputs.run_dir = GetRunDirectory();
         if (page_inputs.run_dir.empty()) {
             page_inputs.run_dir = ".";
@@ -1715,30 +1670,23 @@ vector<MPFGenericTrack> TesseractOCRTextDetection::GetDetections(const MPFGeneri
 
         check_default_languages(page_inputs.ocr_fset, job.job_name, page_inputs.run_dir);
 
-        string plugin_path = page_inputs.run_dir + "/TesseractOCRTextDetection";
-        TempDirectory temp_im_directory(plugin_path + "/tmp-" + job_name + "-" + random_string(20));
+        bool process_parallel = page_inputs.ocr_fset.max_parallel_pdf_threads > 1 &&
+                                page_inputs.ocr_fset.psm != 0;
 
         // Attempts to process generic document.
-        // If read successfully, convert to images and store in a temporary directory.
-        Magick::ReadOptions options;
-        options.density(Magick::Geometry(300, 300));
-        options.depth(8);
-        list<Magick::Image> images;
-        readImages(&images, job.data_uri, options);
-        size_t i;
-        list<Magick::Image>::iterator image;
-        for (image = images.begin(), i = 0; image != images.end(); image++, i++) {
-            image->matte(false);
-            image->backgroundColor(Magick::Color("WHITE"));
-            string tiff_file = temp_im_directory.path + "/results_extracted" + to_string(i) + ".tiff";
-            image->write(tiff_file);
-            page_inputs.filelist.push_back(tiff_file);
+        // Pages are rasterized as they are processed, rather than all at once up front. When
+        // processing in parallel, enough pages are read at a time to keep every thread busy.
+        MPFImageJob page_job(job.job_name, job.data_uri, job.job_properties, job.media_properties);
+        size_t pages_per_read = 4;
+        if (process_parallel) {
+            pages_per_read = max<size_t>(pages_per_read, page_inputs.ocr_fset.max_parallel_pdf_threads);
         }
+        DocumentPageReader pages(page_job, pages_per_read);
+        page_inputs.pages = &pages;
 
         page_inputs.default_lang = page_inputs.ocr_fset.tesseract_lang;
 
-        if (page_inputs.ocr_fset.max_parallel_pdf_threads > 1 && page_inputs.filelist.size() > 1 &&
-            page_inputs.ocr_fset.psm != 0) {
+        if (process_parallel) {
             // Process PDF pages in parallel.
             process_parallel_pdf_pages(page_inputs, page_results);
         }
@@ -1800,5 +1748,182 @@ bool TessApiWrapper::DetectOS(OSResults *results) {
 }
 
 
+DocumentPageReader::DocumentPageReader(const MPFImageJob &page_job, size_t pages_per_read)
+        : page_job_(page_job)
+        , pages_per_read_(max<size_t>(pages_per_read, 1)) {
+    // Pinging only reads the attributes of each page, so the pages are counted without
+    // rasterizing them.
+    list<Magick::Image> pinged_pages;
+    try {
+        Magick::ReadOptions options;
+        pingImages(&pinged_pages, page_job_.data_uri, options);
+    }
+    catch (const Magick::Exception &ex) {
+        throw MPFDetectionException(MPF_COULD_NOT_READ_MEDIA,
+                                    "Could not count the pages of the document: " + string(ex.what()));
+    }
+    num_pages_ = pinged_pages.size();
+}
+
+bool DocumentPageReader::Next(cv::Mat &page) {
+    if (pages_.empty() && next_page_ < num_pages_) {
+        ReadPages();
+    }
+    if (pages_.empty()) {
+        return false;
+    }
+    page = pages_.front();
+    pages_.pop_front();
+
+    IFrameTransformer::Ptr transformer = FrameTransformerFactory::GetTransformer(page_job_, page.size());
+    transformer->TransformFrame(page, 0);
+    return true;
+}
+
+void DocumentPageReader::ReadPages() {
+    Magick::ReadOptions options;
+    options.density(Magick::Geometry(300, 300));
+    options.depth(8);
+
+    // ImageMagick only reads the pages selected with "[first-last]" after the path. For PDFs,
+    // the range is passed on to Ghostscript, so the other pages are not rasterized. The range
+    // stops at the last page, since asking for pages past the end of the document is an error.
+    size_t first = next_page_;
+    size_t last = min(next_page_ + pages_per_read_, num_pages_) - 1;
+    list<Magick::Image> images;
+    try {
+        readImages(&images, page_job_.data_uri + "[" + to_string(first) + "-" + to_string(last) + "]",
+                   options);
+    }
+    catch (const Magick::Exception &ex) {
+        throw MPFDetectionException(MPF_COULD_NOT_READ_MEDIA,
+                                    "Could not read pages " + to_string(first) + " to " + to_string(last)
+                                    + " of the document: " + ex.what());
+    }
+    next_page_ = last + 1;
+
+    while (!images.empty()) {
+        Magick::Image &image = images.front();
+        image.matte(false);
+        image.backgroundColor(Magick::Color("WHITE"));
+        image.colorSpace(Magick::sRGBColorspace);
+
+        // Same as reading an 8 bit TIFF of the page with cv::imread.
+        cv::Mat page(static_cast<int>(image.rows()), static_cast<int>(image.columns()), CV_8UC3);
+        image.write(0, 0, image.columns(), image.rows(), "BGR", Magick::CharPixel, page.data);
+        pages_.push_back(page);
+
+        // Release each page's ImageMagick copy as soon as it is converted.
+        images.pop_front();
+    }
+}
+
+
+TessApiPool::Lease::Lease(TessApiPool *pool, tuple<int, string, string> key,
+                          unique_ptr<TessApiWrapper> tess_api, size_t model_size)
+        : pool_(pool)
+        , key_(move(key))
+        , tess_api_(move(tess_api))
+        , model_size_(model_size) {
+}
+
+TessApiPool::Lease::~Lease() {
+    if (tess_api_ != nullptr) {
+        pool_->Release({move(key_), move(tess_api_), model_size_});
+    }
+}
+
+TessApiPool::Lease& TessApiPool::Lease::operator=(Lease&& other) {
+    if (this != &other) {
+        if (tess_api_ != nullptr) {
+            pool_->Release({move(key_), move(tess_api_), model_size_});
+        }
+        pool_ = other.pool_;
+        key_ = move(other.key_);
+        tess_api_ = move(other.tess_api_);
+        model_size_ = other.model_size_;
+    }
+    return *this;
+}
+
+TessApiWrapper& TessApiPool::Lease::operator*() const {
+    return *tess_api_;
+}
+
+TessApiWrapper* TessApiPool::Lease::operator->() const {
+    return tess_api_.get();
+}
+
+TessApiPool::Lease TessApiPool::Acquire(const string& data_path, const string& language,
+                                        tesseract::OcrEngineMode oem) {
+    tuple<int, string, string> key(oem, language, data_path);
+    {
+        lock_guard<mutex> lock(mutex_);
+        for (auto it = idle_engines_.begin(); it != idle_engines_.end(); ++it) {
+            if (it->key == key) {
+                IdleEngine engine = move(*it);
+                idle_engines_.erase(it);
+                idle_model_size_ -= engine.model_size;
+                return {this, move(engine.key), move(engine.tess_api), engine.model_size};
+            }
+        }
+    }
+
+    // Loading the language models is slow, so other runs may use the pool in the meantime.
+    unique_ptr<TessApiWrapper> tess_api(new TessApiWrapper(data_path, language, oem));
+
+    // Estimate the memory used by the engine from the size of its language model files.
+    size_t model_size = 0;
+    vector<string> models;
+    boost::split(models, language, boost::is_any_of("+"));
+    for (const string &model : models) {
+        boost::system::error_code ec;
+        uintmax_t file_size = boost::filesystem::file_size(data_path + "/" + model + ".traineddata", ec);
+        if (!ec) {
+            model_size += file_size;
+        }
+    }
+    return {this, move(key), move(tess_api), model_size};
+}
+
+void TessApiPool::SetLimits(size_t max_idle_per_model, size_t memory_budget) {
+    list<IdleEngine> evicted;
+    lock_guard<mutex> lock(mutex_);
+    max_idle_per_model_ = max_idle_per_model;
+    memory_budget_ = memory_budget;
+    evicted = Evict();
+}
+
+void TessApiPool::Release(IdleEngine engine) {
+    // Free up recognition results and any stored image data.
+    engine.tess_api->Clear();
+
+    list<IdleEngine> evicted;
+    lock_guard<mutex> lock(mutex_);
+    idle_model_size_ += engine.model_size;
+    idle_engines_.push_front(move(engine));
+    evicted = Evict();
+}
+
+list<TessApiPool::IdleEngine> TessApiPool::Evict() {
+    list<IdleEngine> evicted;
+    map<tuple<int, string, string>, size_t> idle_per_model;
+    for (auto it = idle_engines_.begin(); it != idle_engines_.end(); /* Intentionally no ++ to support erasing. */) {
+        if (++idle_per_model[it->key] > max_idle_per_model_) {
+            idle_model_size_ -= it->model_size;
+            evicted.splice(evicted.end(), idle_engines_, it++);
+        }
+        else {
+            ++it;
+        }
+    }
+    while (!idle_engines_.empty() && (memory_budget_ == 0 || idle_model_size_ > memory_budget_)) {
+        idle_model_size_ -= idle_engines_.back().model_size;
+        evicted.splice(evicted.end(), idle_engines_, prev(idle_engines_.end()));
+    }
+    return evicted;
+}
+
+
 MPF_COMPONENT_CREATOR(TesseractOCRTextDetection);
 MPF_COMPONENT_DELETER();
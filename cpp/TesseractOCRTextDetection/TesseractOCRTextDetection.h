@@ -27,10 +27,15 @@
 #ifndef OPENMPF_COMPONENTS_TESSERACTOCRTEXTDETECTION_H
 #define OPENMPF_COMPONENTS_TESSERACTOCRTEXTDETECTION_H
 
+#include <atomic>
+#include <deque>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -57,6 +62,10 @@ namespace MPF {
 
         class TessApiWrapper;
 
+        class TessApiPool;
+
+        class DocumentPageReader;
+
         class TesseractOCRTextDetection : public MPFDetectionComponent {
 
         public:
@@ -98,6 +107,7 @@ namespace MPF {
                 int adaptive_hist_tile_size;
                 int max_parallel_ocr_threads;
                 int max_parallel_pdf_threads;
+                int max_pooled_model_mb;
                 double adaptive_hist_clip_limit;
                 double adaptive_thrs_c;
                 double scale;
@@ -153,6 +163,7 @@ namespace MPF {
                 std::set<std::string> ocr_lang_inputs;
                 log4cxx::LoggerPtr hw_logger_;
                 std::map<std::pair<int, std::string>, TessApiWrapper> *tess_api_map;
+                TessApiPool *tess_api_pool;
             };
 
             struct Image_results{
@@ -167,7 +178,7 @@ namespace MPF {
 
             struct PDF_page_inputs {
                 std::string run_dir;
-                std::vector<std::string> filelist;
+                DocumentPageReader *pages;
                 const MPFGenericJob *job;
                 std::string default_lang;
                 OCR_filter_settings ocr_fset;
@@ -187,6 +198,9 @@ namespace MPF {
                 MPFGenericTrack osd_track_results;
 
                 OCR_job_inputs ocr_input;
+                // One result per language, filled in by the page's OCR runs.
+                std::vector<OCR_results> lang_results;
+                std::atomic<size_t> remaining_runs{0};
                 Image_results page_thread_res;
 
                 PDF_thread_variables()
@@ -216,6 +230,9 @@ namespace MPF {
             // Map of {OCR engine, language} pairs to TessApiWrapper
             std::map<std::pair<int, std::string>, TessApiWrapper> tess_api_map;
 
+            // Engines for parallel OCR runs, which can not share the engines in tess_api_map.
+            std::unique_ptr<TessApiPool> tess_api_pool;
+
 
             static void get_tesseract_detections(OCR_job_inputs &input, Image_results &result);
             
@@ -297,6 +314,83 @@ namespace MPF {
             tesseract::TessBaseAPI tess_api_;
         };
 
+        // Keeps initialized Tesseract engines so that parallel OCR runs can reuse them, rather than loading the
+        // language models again for every run. Each engine is only used by one run at a time. Idle engines are
+        // evicted, least recently used first, once their language models exceed the memory budget.
+        class TessApiPool {
+        public:
+            // Returns the engine to the pool when destroyed.
+            class Lease {
+            public:
+                Lease() = default;
+                Lease(Lease&&) = default;
+                Lease& operator=(Lease&& other);
+                ~Lease();
+
+                TessApiWrapper& operator*() const;
+                TessApiWrapper* operator->() const;
+
+            private:
+                friend class TessApiPool;
+                Lease(TessApiPool *pool, std::tuple<int, std::string, std::string> key,
+                      std::unique_ptr<TessApiWrapper> tess_api, size_t model_size);
+
+                TessApiPool *pool_ = nullptr;
+                std::tuple<int, std::string, std::string> key_;
+                std::unique_ptr<TessApiWrapper> tess_api_;
+                size_t model_size_ = 0;
+            };
+
+            // Returns an idle engine for the language models in data_path, or initializes a new one when they
+            // are all in use.
+            Lease Acquire(const std::string& data_path, const std::string& language, tesseract::OcrEngineMode oem);
+
+            // Keeps at most max_idle_per_model idle engines for each set of language models, and at most
+            // memory_budget bytes of language models in total. A budget of 0 disables pooling.
+            void SetLimits(size_t max_idle_per_model, size_t memory_budget);
+
+        private:
+            struct IdleEngine {
+                std::tuple<int, std::string, std::string> key;
+                std::unique_ptr<TessApiWrapper> tess_api;
+                size_t model_size;
+            };
+
+            std::mutex mutex_;
+            // Most recently used first.
+            std::list<IdleEngine> idle_engines_;
+            size_t idle_model_size_ = 0;
+            size_t max_idle_per_model_ = 0;
+            size_t memory_budget_ = 0;
+
+            void Release(IdleEngine engine);
+
+            // Removes idle engines until the limits are met, and returns them so that they can be
+            // destroyed without holding the lock.
+            std::list<IdleEngine> Evict();
+        };
+
+        // Rasterizes the pages of a generic job's document a few at a time, so that only the pages
+        // being processed are held in memory rather than every page of the document.
+        class DocumentPageReader {
+        public:
+            DocumentPageReader(const MPFImageJob &page_job, size_t pages_per_read);
+
+            // Sets page to the next page, with the job's frame transforms applied, the same as
+            // MPFImageReader::GetImage would for an image of that page.
+            // Returns false once every page has been read.
+            bool Next(cv::Mat &page);
+
+        private:
+            MPFImageJob page_job_;
+            size_t pages_per_read_;
+            size_t num_pages_;
+            size_t next_page_ = 0;
+            std::deque<cv::Mat> pages_;
+
+            void ReadPages();
+        };
+
     }
 }
 
@@ -0,0 +1,111 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#include "WorkQueue.h"
+
+#include <algorithm>
+
+
+using namespace MPF;
+using namespace COMPONENT;
+using namespace std;
+
+
+WorkQueue::WorkQueue(int num_threads) {
+    num_threads = max(num_threads, 1);
+    workers_.reserve(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+        workers_.emplace_back(&WorkQueue::RunWorker, this);
+    }
+}
+
+
+WorkQueue::~WorkQueue() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+        tasks_.clear();
+    }
+    task_added_.notify_all();
+    for (thread &worker : workers_) {
+        worker.join();
+    }
+}
+
+
+void WorkQueue::Add(function<void()> task) {
+    unique_lock<mutex> lock(mutex_);
+    task_done_.wait(lock, [this] {
+        return error_ != nullptr || tasks_.size() + num_running_ < workers_.size();
+    });
+    if (error_ != nullptr) {
+        rethrow_exception(error_);
+    }
+    tasks_.push_back(move(task));
+    lock.unlock();
+    task_added_.notify_one();
+}
+
+
+void WorkQueue::Wait() {
+    unique_lock<mutex> lock(mutex_);
+    task_done_.wait(lock, [this] { return tasks_.empty() && num_running_ == 0; });
+    if (error_ != nullptr) {
+        rethrow_exception(error_);
+    }
+}
+
+
+void WorkQueue::RunWorker() {
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        task_added_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+        if (stopping_) {
+            return;
+        }
+        function<void()> task = move(tasks_.front());
+        tasks_.pop_front();
+        num_running_++;
+        lock.unlock();
+
+        exception_ptr error;
+        try {
+            task();
+        }
+        catch (...) {
+            error = current_exception();
+        }
+
+        lock.lock();
+        num_running_--;
+        if (error != nullptr && error_ == nullptr) {
+            error_ = error;
+            // The job is going to fail, so there is no point in running the rest of its tasks.
+            tasks_.clear();
+        }
+        task_done_.notify_all();
+    }
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+ * NOTICE                                                                     *
+ *                                                                            *
+ * This software (or technical data) was produced for the U.S. Government     *
+ * under contract, and is subject to the Rights in Data-General Clause        *
+ * 52.227-14, Alt. IV (DEC 2007).                                             *
+ *                                                                            *
+ * Copyright 2024 The MITRE Corporation. All Rights Reserved.                 *
+ ******************************************************************************/
+
+/******************************************************************************
+ * Copyright 2024 The MITRE Corporation                                       *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+#ifndef OPENMPF_COMPONENTS_WORKQUEUE_H
+#define OPENMPF_COMPONENTS_WORKQUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace MPF {
+
+    namespace COMPONENT {
+
+        // Runs tasks on a fixed number of worker threads. Add blocks while every worker is busy, so a
+        // caller that prepares the input for each task, such as a document page, only holds as many
+        // inputs in memory as there are workers.
+        class WorkQueue {
+        public:
+            explicit WorkQueue(int num_threads);
+
+            // Waits for the running tasks to finish. Tasks that have not started are discarded.
+            ~WorkQueue();
+
+            WorkQueue(const WorkQueue&) = delete;
+            WorkQueue& operator=(const WorkQueue&) = delete;
+
+            // Queues the task once a worker is free to run it.
+            // Rethrows the exception from a failed task, in which case the task is not queued.
+            void Add(std::function<void()> task);
+
+            // Blocks until every queued task has finished.
+            // Rethrows the first exception thrown by a task. Tasks that had not started when it was
+            // thrown are discarded.
+            void Wait();
+
+        private:
+            std::mutex mutex_;
+            std::condition_variable task_added_;
+            std::condition_variable task_done_;
+            std::deque<std::function<void()>> tasks_;
+            size_t num_running_ = 0;
+            bool stopping_ = false;
+            std::exception_ptr error_;
+            std::vector<std::thread> workers_;
+
+            void RunWorker();
+        };
+    }
+}
+
+#endif
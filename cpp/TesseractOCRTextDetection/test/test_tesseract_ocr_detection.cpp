@@ -24,9 +24,12 @@
  * limitations under the License.                                             *
  ******************************************************************************/
 
+#include <atomic>
+#include <chrono>
 #include <set>
 #include <stdlib.h>
 #include <string>
+#include <thread>
 #include <MPFDetectionComponent.h>
 #include <unistd.h>
 #include <gtest/gtest.h>
@@ -41,6 +44,7 @@
 #undef BOOST_NO_CXX11_SCOPED_ENUMS
 
 #include "TesseractOCRTextDetection.h"
+#include "WorkQueue.h"
 
 using namespace MPF::COMPONENT;
 
@@ -1395,3 +1399,95 @@ TEST(TESSERACTOCR, RedundantFilterTest) {
 
     ASSERT_TRUE(ocr.Close());
 }
+
+TEST(TESSERACTOCR, ParallelDocumentLanguagesTest) {
+
+    TesseractOCRTextDetection ocr;
+    ocr.SetRunDirectory("../plugin");
+    ASSERT_TRUE(ocr.Init());
+
+    // Each page is OCRed once per language in parallel. Check that the tracks are the same, and in the same
+    // order, as when the pages are processed serially.
+    std::map<std::string, std::string> custom_properties = {{"ENABLE_OSD_AUTOMATION",     "false"},
+                                                            {"TESSERACT_LANGUAGE",        "eng,fra"},
+                                                            {"MAX_PARALLEL_PAGE_THREADS", "0"}};
+    std::vector<MPFGenericTrack> serial_results;
+    ASSERT_NO_FATAL_FAILURE(runDocumentDetection("data/test.pdf", ocr, serial_results, custom_properties));
+
+    custom_properties["MAX_PARALLEL_PAGE_THREADS"] = "4";
+    std::vector<MPFGenericTrack> parallel_results;
+    ASSERT_NO_FATAL_FAILURE(runDocumentDetection("data/test.pdf", ocr, parallel_results, custom_properties));
+
+    ASSERT_EQ(6, serial_results.size()) << "Expected one track per page and language.";
+    ASSERT_EQ(serial_results.size(), parallel_results.size());
+    for (int i = 0; i < serial_results.size(); i++) {
+        ASSERT_EQ(serial_results[i].detection_properties.at("PAGE_NUM"),
+                  parallel_results[i].detection_properties.at("PAGE_NUM"));
+        ASSERT_EQ(serial_results[i].detection_properties.at("TEXT_LANGUAGE"),
+                  parallel_results[i].detection_properties.at("TEXT_LANGUAGE"));
+        ASSERT_EQ(serial_results[i].detection_properties.at("TEXT"),
+                  parallel_results[i].detection_properties.at("TEXT"));
+    }
+
+    ASSERT_TRUE(ocr.Close());
+}
+
+TEST(TESSERACTOCR, WorkQueueTest) {
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+    std::atomic<int> finished{0};
+    {
+        WorkQueue work_queue(3);
+        for (int i = 0; i < 20; i++) {
+            work_queue.Add([&] {
+                int now_running = ++running;
+                int prev_max = max_running;
+                while (now_running > prev_max && !max_running.compare_exchange_weak(prev_max, now_running)) { }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                --running;
+                ++finished;
+            });
+        }
+        work_queue.Wait();
+    }
+    ASSERT_EQ(20, finished);
+    ASSERT_LE(max_running, 3) << "Expected no more tasks to run at once than there are threads.";
+
+    // The first exception from a task is re-thrown to the caller, either by Add or by Wait.
+    ASSERT_THROW({
+        WorkQueue work_queue(2);
+        for (int i = 0; i < 4; i++) {
+            work_queue.Add([i] {
+                if (i == 1) {
+                    throw MPFDetectionException(MPF_OTHER_DETECTION_ERROR_TYPE, "Task failed.");
+                }
+            });
+        }
+        work_queue.Wait();
+    }, MPFDetectionException);
+}
+
+TEST(TESSERACTOCR, TessApiPoolTest) {
+    std::string tessdata_dir = "../plugin/TesseractOCRTextDetection/tessdata";
+    TessApiPool pool;
+    pool.SetLimits(1, 1024 * 1024 * 1024);
+
+    TessApiWrapper *first_api;
+    {
+        TessApiPool::Lease lease = pool.Acquire(tessdata_dir, "eng", tesseract::OEM_DEFAULT);
+        first_api = &*lease;
+
+        // An engine is only used by one run at a time.
+        TessApiPool::Lease other_lease = pool.Acquire(tessdata_dir, "eng", tesseract::OEM_DEFAULT);
+        ASSERT_NE(first_api, &*other_lease);
+    }
+
+    // Only one idle engine is kept per language, and it is the most recently returned one.
+    TessApiPool::Lease lease = pool.Acquire(tessdata_dir, "eng", tesseract::OEM_DEFAULT);
+    ASSERT_EQ(first_api, &*lease) << "Expected the idle engine to be reused.";
+
+    // Replacing a lease returns its engine to the pool.
+    lease = TessApiPool::Lease();
+    lease = pool.Acquire(tessdata_dir, "eng", tesseract::OEM_DEFAULT);
+    ASSERT_EQ(first_api, &*lease) << "Expected the idle engine to be reused.";
+}